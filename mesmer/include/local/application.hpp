@@ -9,7 +9,18 @@
 #define MESMER_APPLICATION_HPP
 
 #include <shader.hpp>
+#include <shader_registry.hpp>
 #include <settings.hpp>
+#include <cpu_renderer.hpp>
+#include <perturbation.hpp>
+#include <shader_precision.hpp>
+#include <progressive_renderer.hpp>
+#include <iteration_state.hpp>
+#include <profiler.hpp>
+#include <png_writer.hpp>
+#include <readback_ring.hpp>
+#include <fence_ring.hpp>
+#include <virtual_texture.hpp>
 
 #include <iostream>
 #include <stdexcept>
@@ -18,7 +29,12 @@
 #include <thread>
 #include <future>
 #include <atomic>
+#include <mutex>
 #include <memory>
+#include <algorithm>
+#include <array>
+#include <deque>
+#include <cstring>
 #include <spdlog/spdlog.h>
 #include <glad/glad.h>
 #include <SDL.h>
@@ -42,6 +58,8 @@ private:
     int argc;
     char** argv;
 	Shader* ourShader; // Pointer to the shader object
+    // owns every program, the Shader pointers below only borrow from it
+    ShaderRegistry m_shaders;
 
     SDL_Window* window;
     SDL_GLContext gl_context;
@@ -56,6 +74,28 @@ private:
     void addTextWithStroke(ImDrawList* draw_list, ImFont* font, float size, ImVec2 pos, ImU32 fill_col, ImU32 outline_col, float thickness, const char* text);
     void performPreRender();
     void preRenderWorker();
+    void preRenderResumeWorker();
+    bool preRenderTiles(Shader* shader, Shader* compute_shader, unsigned int vao, int tile_size, bool use_gpu, const CpuRenderParams* cpu_params);
+    bool probeTileCost(Shader* shader, TileCostMap& cost);
+    bool buildCpuPreRenderParams(CpuRenderParams& params, bool with_reference = true) const;
+    bool preRenderReferenceCenter(const CpuRenderParams& params, BigFloat& center_x, BigFloat& center_y) const;
+    std::string preRenderKernelPath(int resolution) const;
+    std::string preRenderComputePath() const;
+    int runCompactionPasses(Shader* kernel, Shader* dispatch, const GLuint lists[2], int read, int begin, int pixels, GLuint resume_list) const;
+    void createVirtualTexture();
+    bool setPreRenderUniforms(Shader* shader) const;
+    void fractalPalette(const ImVec4* palette[4]) const;
+    std::array<float, 16> colorizeState() const;
+    static void setColorizeUniforms(Shader* shader, const std::array<float, 16>& state);
+    void colorizePreRender();
+    void releasePreRender();
+    void panMandelbrot(double dx, double dy);
+    void syncMandelbrotCenter();
+    void pollReferenceOrbit();
+    bool drawMandelbrotPerturbed(int drawable_w, int drawable_h, int max_iterations);
+    bool useDf64(double zoom, int pixels) const;
+    Shader* loadFractalShader(const char* vertex_path, const char* fragment_path);
+    void queueShaderPrograms();
 
     ImFont* m_font_regular;
     ImFont* m_font_large;
@@ -68,6 +108,20 @@ private:
     double m_mandel_center_x = -0.75;
     double m_mandel_center_y = 0.0;
     int m_mandel_max_iterations = 200;
+    // deep zoom: the mandelbrot centre is kept in BigFloat precision, m_mandel_center_x/y mirror it as doubles
+    BigFloat m_mandel_deep_center_x = BigFloat::fromDouble(-0.75);
+    BigFloat m_mandel_deep_center_y = BigFloat::fromDouble(0.0);
+    double m_mandel_center_mirror_x = -0.75;
+    double m_mandel_center_mirror_y = 0.0;
+    char m_mandel_center_x_text[512] = "";
+    char m_mandel_center_y_text[512] = "";
+    Shader* m_perturb_shader = nullptr;
+    unsigned int m_reference_orbit_ssbo = 0;
+    unsigned int m_bla_ssbo = 0;
+    int m_mandel_deep_iterations = 50000;
+    std::shared_ptr<const ReferenceOrbit> m_reference_orbit;
+    std::future<std::shared_ptr<ReferenceOrbit>> m_reference_future;
+    std::atomic<bool> m_cancel_reference{ false };
     bool m_is_dragging = false;
     ImVec2 m_drag_start_pos;
     double m_julia_c_x = -0.8;
@@ -144,9 +198,23 @@ private:
     int m_pre_render_frame_count = 0;
     unsigned int m_pre_render_fbo = 0;
     unsigned int m_pre_render_texture = 0;
+    // iteration g-buffer the pre-render kernels write, colorize.frag maps it into m_pre_render_texture whenever the colouring changes
+    unsigned int m_pre_render_gbuffer_value = 0;
+    unsigned int m_pre_render_gbuffer_orbit = 0;
+    unsigned int m_pre_render_color_fbo = 0; // main context, framebuffers are not shared with the worker context
+    Shader* m_colorize_shader = nullptr;
+    std::array<float, 16> m_pre_render_color_state{};
+    bool m_pre_render_colorized = false;
+    int m_color_style = 0;             // 0 smooth, 1 distance shaded, 2 binary decomposition
+    float m_palette_cycle_speed = 0.0f; // palette periods per second
 	int m_pre_render_highest_supported_resolution = 16384;
     int m_pre_render_resolution = 16384;
     Shader* m_texture_view_shader = nullptr;
+    // detail pages rendered on demand when the viewer zooms past the pre-render's own resolution
+    VirtualTexture m_virtual_texture;
+    bool m_virtual_texture_enabled = true;
+    // set by the worker when the pre-render iterated against a reference orbit, the page kernels have no perturbation path
+    std::atomic<bool> m_pre_render_perturbed{ false };
     double m_view_center_x = 0.0;
 	double m_view_center_y = 0.0;
     double m_view_zoom = 1.0;
@@ -171,6 +239,7 @@ private:
 
     // non-blocking pre-rendering variables
     SDL_GLContext m_worker_context = nullptr;
+    std::mutex m_worker_context_mutex;  // held by whichever of the pre-render, the export and the detail pages draws on it
     std::future<bool> m_pre_render_future;
     bool m_is_loading = false;
     Shader* m_loading_shader = nullptr;
@@ -180,6 +249,155 @@ private:
     std::atomic<bool> m_worker_finished_submission = false;
     GLsync m_pre_render_fence = nullptr;
 
+    // pre-render backend selection (cpu engine only covers mandelbrot and julia, everything else stays on the gpu)
+    enum class PreRenderBackend { GPU, CPU, HYBRID };
+    PreRenderBackend m_pre_render_backend = PreRenderBackend::GPU;
+    CpuSubdivision m_pre_render_subdivision = CpuSubdivision::OFF;
+    CpuRenderer::SimdLevel m_cpu_simd_level = CpuRenderer::SimdLevel::SCALAR;
+    std::atomic<int> m_pre_render_tiles_done{ 0 };
+    std::atomic<int> m_pre_render_tiles_total{ 0 };
+    // gpu tiles in flight: the window follows the measured tile time to keep about this much work queued
+    static constexpr int PRE_RENDER_MAX_TILES_IN_FLIGHT = 16;
+    static constexpr float PRE_RENDER_QUEUE_TARGET_MS = 4.0f;
+    // gpu tiles are sized from a low resolution timing probe of the kernel, each one near the budget per submission.
+    // renders with cpu workers keep the fixed size as the largest tile, a cpu thread is far slower on a big one
+    static constexpr int PRE_RENDER_TILE_SIZE = 256;
+    static constexpr int PRE_RENDER_MIN_TILE = 64;
+    static constexpr int PRE_RENDER_MAX_TILE = 1024;
+    static constexpr double PRE_RENDER_TILE_BUDGET_MS = 25.0;
+    static constexpr int PRE_RENDER_PROBE_CELLS = 64;       // cells per side of the cost map at most
+    static constexpr int PRE_RENDER_PROBE_SCALE = 8;        // the probe runs one pixel in 8x8
+    static constexpr int PRE_RENDER_DEFAULT_ITERATIONS = 5000;
+    int m_pre_render_iterations = PRE_RENDER_DEFAULT_ITERATIONS;
+    // persistent compute kernels (persistent_queue.glsl): workgroups launched per tile at most and pixels per workgroup
+    // pass of the queue, both mirrored in the shader
+    static constexpr int PRE_RENDER_PERSISTENT_GROUPS = 512;
+    static constexpr int PRE_RENDER_PERSISTENT_GROUP_PIXELS = 64 * 4;
+    // fractals whose gpu tiles go through the compute kernel instead of the fragment shader
+    bool m_compute_kernel_mandelbrot = false;
+    bool m_compute_kernel_julia = false;
+    // stream compaction (compaction.glsl on the gpu, CpuRenderParams::compaction_chunk on the cpu): pixels iterate in
+    // chunks from this many iterations on and only the ones still running go on to the next chunk. the compute kernels
+    // swap their survivors between two lists sized for the largest tile, groups mirrored in the shader
+    static constexpr int PRE_RENDER_COMPACTION_GROUP = 64;
+    static constexpr int PRE_RENDER_COMPACTION_ORBIT_BYTES = 48;
+    static constexpr int PRE_RENDER_COMPACTION_HEADER_BYTES = 16;
+    bool m_pre_render_compaction = false;
+    int m_pre_render_compaction_chunk = 256;
+    // the last pass of every compacted tile appends the orbits that ran out at the limit to a list the render keeps
+    // (worker context, under m_worker_context_mutex), continuing it to a higher limit only iterates those. a render that
+    // leaves more than the capacity cannot be continued
+    static constexpr int PRE_RENDER_RESUME_CAPACITY = 1 << 21;
+    GLuint m_pre_render_resume_list = 0;
+    std::atomic<int> m_pre_render_resume_count{ 0 };
+    std::atomic<int> m_pre_render_resume_iterations{ 0 };   // the limit the kept orbits ran to, 0 when nothing is kept
+    std::atomic<bool> m_pre_render_resuming{ false };
+    GLsync m_pre_render_resume_fence = nullptr;
+
+    // export of the pre-render view at any size. tiles go through the pre-render kernel and the colour pass on the worker
+    // context, come back through a ring of pixel buffers and are encoded on a thread of their own, so neither the gpu
+    // nor the host ever holds the image
+    enum class ExportState { IDLE, RUNNING, DONE, FAILED, CANCELLED };
+    static constexpr int EXPORT_TILE_SIZE = 256;
+    static constexpr int EXPORT_MAX_RESOLUTION = 262144;    // tile coordinates stay exact in the kernels' double uv far beyond this
+    static constexpr int EXPORT_READBACK_SLOTS = 3;         // tiles in flight between the kernels and the host
+    static constexpr int EXPORT_ENCODE_DEPTH = 2;           // rows of tiles queued for the png encoder
+    int m_export_resolution = 32768;
+    char m_export_path[512] = "mesmer_export.png";
+    std::thread m_export_thread;
+    std::mutex m_export_mutex;                              // starting and joining the thread, the pre-render worker stops it too
+    std::atomic<ExportState> m_export_state{ ExportState::IDLE };
+    std::atomic<bool> m_cancel_export{ false };
+    std::atomic<int> m_export_tiles_done{ 0 };
+    std::atomic<int> m_export_tiles_total{ 0 };
+    // the view a tiled kernel draws, taken on the main thread so a worker never reads settings the interface is editing
+    struct PreRenderView {
+        FractalType fractal = FractalType::NONE;
+        int max_iterations = 0;
+        double center_x = 0.0;      // the (a, b) centre for lyapunov
+        double center_y = 0.0;
+        double zoom = 1.0;
+        double c_x = 0.0;           // julia and phoenix constant
+        double c_y = 0.0;
+        double p = 0.0;             // phoenix
+        double power = 0.0;         // nova and multibrot
+        double relaxation = 0.0;    // nova
+    };
+    PreRenderView preRenderView() const;
+    static bool setPreRenderUniforms(Shader* shader, const PreRenderView& view);
+    // everything an export renders from, captured by startExport. deep mandelbrot views keep the BigFloat centre of their
+    // reference orbit, the orbit itself is computed on the export thread
+    struct ExportJob {
+        std::string path;
+        int resolution = 0;
+        std::string kernel_path;
+        PreRenderView view;
+        std::array<float, 16> color_state{};
+        bool deep = false;
+        CpuRenderParams deep_params;
+        BigFloat deep_center_x;
+        BigFloat deep_center_y;
+    };
+    void startExport();
+    void stopExport();
+    void exportWorker(ExportJob job);
+
+    // fp64 / df64 kernel selection, auto follows the startup benchmark
+    ShaderPrecision m_shader_precision = ShaderPrecision::AUTO;
+    PrecisionBenchmark m_precision_benchmark;
+    std::string m_fractal_vertex_path;
+    std::string m_fractal_fragment_path;
+    bool m_fractal_shader_df64 = false;
+
+    // progressive live view, the accumulated frame restarts whenever anything the fractal pass reads changes
+    struct LiveViewState {
+        FractalType fractal = FractalType::NONE;
+        BigFloat deep_center_x;
+        BigFloat deep_center_y;
+        std::array<double, 14> view{};      // centre, zoom and the per-fractal constants
+        std::array<int, 4> iterations{};    // adaptive flag, base, max and deep iterations
+        std::array<float, 13> coloring{};   // palette and density
+        std::array<int, 2> drawable{};
+        bool df64 = false;
+        const ReferenceOrbit* reference = nullptr;
+
+        bool operator==(const LiveViewState&) const = default;
+    };
+    LiveViewState liveViewState(int drawable_w, int drawable_h) const;
+    // the fp64 mandelbrot and julia kernels keep their orbits in full resolution passes, a view that only raised the
+    // limit continues them
+    bool liveKeepsState() const;
+    int liveIterationLimit() const;
+    bool resumeLiveIterations(const LiveViewState& from, const LiveViewState& to);
+    IterationState m_iteration_state;
+    bool m_resume_iterations = true;
+    int m_resume_from = 0;
+    bool liveViewTransform(const LiveViewState& from, const LiveViewState& to, double& scale, double& offset_x, double& offset_y) const;
+    ProgressiveRenderer m_progressive;
+    LiveViewState m_live_view_state;
+    bool m_progressive_rendering = true;
+    float m_progressive_budget_ms = PROGRESSIVE_DEFAULT_BUDGET_MS;
+    Shader* m_upscale_shader = nullptr;
+
+    // frame pacing from settings.mesmer, the live budget follows the target frame time unless it is set by hand
+    static constexpr float LIVE_FRAME_SHARE = 0.7f;     // the rest of the frame is left to the interface and the swap
+    int m_max_fps = 120;
+    bool m_vsync = true;
+    bool m_budget_from_frame_rate = true;
+    Uint64 m_frame_start = 0;
+    float targetFrameMs() const;
+    void limitFrameRate() const;
+
+    // per pass frame timings and pre-render tile timings, only measured while the overlay is open
+    Profiler m_profiler;
+    bool m_show_profiler = false;
+
+    // redraw on change, the loop sleeps in SDL_WaitEventTimeout while nothing on screen can change by itself
+    static constexpr int IDLE_SETTLE_FRAMES = 3;        // imgui needs a few frames after input for hover and focus to settle
+    static constexpr int IDLE_WAIT_TIMEOUT_MS = 500;    // upper bound on a sleep, keeps the status text and timers ticking
+    int m_active_frames = IDLE_SETTLE_FRAMES;
+    int idleWaitTimeout() const;
+
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,51 @@
+/*
+	Mesmer - An interactive and high-performance fractal generator and explorer.
+	Made by -> Titan // GH: https://github.com/titan3755/mesmer
+	[big_float.hpp]
+*/
+
+#pragma once
+#ifndef MESMER_BIG_FLOAT_HPP
+#define MESMER_BIG_FLOAT_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// arbitrary precision signed fixed point number, one 32 bit integer limb and a configurable number of fraction limbs
+// (fractal coordinates never leave [-2^32, 2^32], so only the fraction needs to grow with the zoom)
+class BigFloat {
+public:
+	static constexpr int DEFAULT_FRACTION_LIMBS = 40; // 1280 fraction bits, ~385 decimal digits
+
+	BigFloat() : BigFloat(DEFAULT_FRACTION_LIMBS) {}
+	explicit BigFloat(int fraction_limbs);
+
+	static BigFloat fromDouble(double value, int fraction_limbs = DEFAULT_FRACTION_LIMBS);
+	// accepts [-]digits[.digits][e[+-]digits], false on malformed or out of range input
+	static bool fromString(const std::string& text, BigFloat& out, int fraction_limbs = DEFAULT_FRACTION_LIMBS);
+	std::string toString(int digits) const;
+	double toDouble() const;
+
+	BigFloat withPrecision(int fraction_limbs) const;
+	int fractionLimbs() const { return (int)m_limbs.size() - 1; }
+	bool isZero() const;
+	bool isNegative() const { return m_negative; }
+
+	BigFloat operator-() const;
+	BigFloat operator+(const BigFloat& other) const;
+	BigFloat operator-(const BigFloat& other) const;
+	BigFloat operator*(const BigFloat& other) const;
+	BigFloat& operator+=(const BigFloat& other) { return *this = *this + other; }
+	BigFloat& operator-=(const BigFloat& other) { return *this = *this - other; }
+	bool operator==(const BigFloat& other) const;
+
+private:
+	static BigFloat addSigned(const BigFloat& a, const BigFloat& b, bool negate_b);
+	static int compareMagnitude(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b);
+
+	bool m_negative = false;
+	std::vector<uint32_t> m_limbs; // little endian, m_limbs.back() is the integer part
+};
+
+#endif
@@ -0,0 +1,168 @@
+/*
+	Mesmer - An interactive and high-performance fractal generator and explorer.
+	Made by -> Titan // GH: https://github.com/titan3755/mesmer
+	[cpu_renderer.hpp]
+*/
+
+#pragma once
+#ifndef MESMER_CPU_RENDERER_HPP
+#define MESMER_CPU_RENDERER_HPP
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+#include <functional>
+#include <spdlog/spdlog.h>
+#include <tile_scheduler.hpp>
+#include <perturbation.hpp>
+
+// headless escape-time engine, mirrors the math of mandelbrot(_prerender).frag and julia(_prerender).frag
+enum class CpuFractal { MANDELBROT, JULIA };
+
+// mariani-silver subdivision: rectangle borders are iterated first and uniform rectangles are filled without iterating
+// their interior. EXACT only skips rectangles proven interior from their corners (inside the main cardioid or the
+// period-2 bulb of a non-perturbed mandelbrot), everything else is iterated per pixel, so it matches OFF pixel for pixel.
+// FILL fills any rectangle bounded by interior pixels, the set has no holes but the borders are only sampled at pixel
+// centres, so a filament thinner than a pixel can slip between two samples and get painted over.
+// GUESS also fills rectangles whose border escapes at one iteration count and interpolates |z|^2 across them.
+// FILL and GUESS are for previews
+enum class CpuSubdivision { OFF, EXACT, FILL, GUESS };
+
+// first save point of the brent period check, mirrored in the glsl kernels
+constexpr int PERIOD_FIRST_SAVE = 8;
+
+// the period check saves z on every 8th iteration at or past the save point and then doubles it. the point only depends on
+// the iteration, so every pixel still running after [iter_begin, iter_end) resumes from the same one
+inline int periodSaveAfter(int iter_begin, int iter_end, int next_save) {
+	for (int i = (iter_begin + 7) & ~7; i < iter_end; i += 8) {
+		if (i >= next_save) {
+			next_save *= 2;
+		}
+	}
+	return next_save;
+}
+
+struct CpuRenderParams {
+	CpuFractal fractal = CpuFractal::MANDELBROT;
+	double center_x = -0.75;
+	double center_y = 0.0;
+	double zoom = 1.0;
+	double julia_c_x = -0.7;
+	double julia_c_y = 0.27015;
+	int max_iterations = 5000;
+	float color_density = 0.05f;
+	float palette_a[3] = { 0.5f, 0.5f, 0.5f };
+	float palette_b[3] = { 0.5f, 0.5f, 0.5f };
+	float palette_c[3] = { 1.0f, 1.0f, 1.0f };
+	float palette_d[3] = { 0.0f, 0.1f, 0.2f };
+	// mandelbrot perturbation, when set the pixels iterate their delta from this orbit instead of c = pixel + center,
+	// the offset is the view centre minus the reference centre
+	std::shared_ptr<const ReferenceOrbit> reference;
+	double reference_offset_x = 0.0;
+	double reference_offset_y = 0.0;
+	CpuSubdivision subdivision = CpuSubdivision::OFF;
+	// stream compaction: pixels iterate in chunks, the first compaction_chunk iterations long and every further one twice the
+	// last, and only the pixels still running after a chunk are packed into the lanes of the next. 0 iterates in one go
+	int compaction_chunk = 0;
+	// tiles carry the iteration g-buffer colorize.frag reads instead of shaded colours
+	bool gbuffer = false;
+	// full image size, row 0 is the bottom row (same as the GL texture the tiles end up in)
+	int width = 0;
+	int height = 0;
+};
+
+struct CpuTile {
+	int x = 0;
+	int y = 0;
+	int width = 0;
+	int height = 0;
+	std::vector<unsigned char> pixels; // tightly packed RGBA8, the g-buffer orbit word when rendering a g-buffer
+	std::vector<float> values;         // g-buffer palette coordinates, empty for colour tiles
+	float milliseconds = 0.0f;         // wall time the worker spent rendering it
+};
+
+class CpuRenderer {
+public:
+	enum class SimdLevel { SCALAR, SSE2, AVX2, AVX512 };
+
+	explicit CpuRenderer(unsigned int thread_count = 0);
+	~CpuRenderer();
+	CpuRenderer(const CpuRenderer&) = delete;
+	CpuRenderer& operator=(const CpuRenderer&) = delete;
+
+	// asynchronous tiled render, the worker threads pull tiles from the scheduler as workers first_worker..first_worker+threadCount()-1
+	// and finished tiles are collected with waitTile() / pollTile() on the calling thread
+	void begin(const CpuRenderParams& params, TileScheduler& scheduler, unsigned int first_worker = 0);
+	bool waitTile(CpuTile& tile);
+	bool pollTile(CpuTile& tile);
+	bool running() const { return m_active_workers.load() > 0; }
+	void cancel();
+	void finish();
+
+	// synchronous render of a single region into an RGBA8 buffer
+	void renderRegion(const CpuRenderParams& params, int x0, int y0, int w, int h, unsigned char* dst, int dst_stride) const;
+	// same pixels as the iteration g-buffer of gbuffer.glsl: the smooth iteration count and the RGBA8 orbit word, the
+	// kernels only keep |z|^2 so arg(z) and the distance estimate are left empty
+	void renderRegionGBuffer(const CpuRenderParams& params, int x0, int y0, int w, int h, float* values, int values_stride,
+		unsigned char* orbit, int orbit_stride) const;
+
+	unsigned int threadCount() const { return m_thread_count; }
+	int tilesDone() const { return m_tiles_done.load(); }
+	SimdLevel simdLevel() const { return m_simd_level; }
+
+	static SimdLevel detectSimdLevel();
+	static const char* simdLevelName(SimdLevel level);
+
+	// iterates count lanes of z -> z^2 + c over [iter_begin, min(iter_end, max_iter)) starting from z and the period check
+	// point saved, returns the escape iteration (max_iter when bounded) and |z|^2 at escape. lanes still running at
+	// iter_end < max_iter get -1 and their z and saved point are written back for the next chunk
+	using IterateFn = void (*)(int count, double* z_re, double* z_im, const double* c_re, const double* c_im, double* saved_re,
+		double* saved_im, int iter_begin, int iter_end, int next_save, int max_iter, int* out_iter, double* out_mag2);
+	// iterates count lanes of the perturbed delta dz' = 2*Z*dz + dz^2 + dc against a reference orbit, same outputs as IterateFn
+	using PerturbFn = void (*)(int count, const double* dc_re, const double* dc_im, const double* orbit, int orbit_length,
+		int max_iter, int* out_iter, double* out_mag2);
+
+	static const char* subdivisionName(CpuSubdivision mode);
+
+private:
+	struct PointScratch {
+		std::vector<double> z_re, z_im, c_re, c_im, saved_re, saved_im;
+		std::vector<int> lanes, chunk_lanes;
+	};
+
+	using RowFn = std::function<void(int row, const int* iters, const double* mag2)>;
+
+	void workerLoop(unsigned int worker);
+	// iterates a region row by row (or by subdivision) and hands every finished row to emit
+	void iterateRegion(const CpuRenderParams& params, int x0, int y0, int w, int h, const RowFn& emit) const;
+	void iterateRegionSubdivided(const CpuRenderParams& params, int x0, int y0, int w, int h, const RowFn& emit) const;
+	// iterates count pixels given by their screen coordinates (u scaled by the aspect ratio, v in [-1, 1])
+	void iteratePoints(const CpuRenderParams& params, int count, const double* u, const double* v, int* iters, double* mag2,
+		PointScratch& scratch) const;
+	// runs the kernel over count lanes of the scratch orbits, in one go or compacted chunk by chunk
+	void iterateLanes(const CpuRenderParams& params, int count, int* iters, double* mag2, PointScratch& scratch) const;
+	void shadeRow(const CpuRenderParams& params, int count, const int* iters, const double* mag2, unsigned char* dst) const;
+	void gbufferRow(const CpuRenderParams& params, int count, const int* iters, const double* mag2, float* values, unsigned char* orbit) const;
+
+	unsigned int m_thread_count;
+	SimdLevel m_simd_level;
+	IterateFn m_iterate;
+	PerturbFn m_perturb;
+
+	CpuRenderParams m_params;
+	TileScheduler* m_scheduler = nullptr;
+	std::vector<std::thread> m_threads;
+	std::atomic<unsigned int> m_active_workers{ 0 };
+
+	std::mutex m_done_mutex;
+	std::condition_variable m_done_cv;
+	std::deque<CpuTile> m_done_tiles;
+	std::atomic<int> m_tiles_done{ 0 };
+	std::atomic<bool> m_cancelled{ false };
+};
+
+#endif
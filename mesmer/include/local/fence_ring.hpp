@@ -0,0 +1,57 @@
+/*
+	Mesmer - An interactive and high-performance fractal generator and explorer.
+	Made by -> Titan // GH: https://github.com/titan3755/mesmer
+	[fence_ring.hpp]
+*/
+
+#pragma once
+#ifndef MESMER_FENCE_RING_HPP
+#define MESMER_FENCE_RING_HPP
+
+#include <vector>
+#include <functional>
+#include <glad/glad.h>
+
+// bounded window of draws in flight, each with its own fence and timer query. the caller only blocks once the window is
+// full, so the gpu queue never runs dry between submissions. the window follows the measured gpu time per draw: it holds
+// about target_queue_ms of work, enough to cover the host's turnaround, and every draw is flushed as a submission of its
+// own so none of them grows long enough for the driver watchdog. everything belongs to the context it was created on
+class FenceRing {
+public:
+	FenceRing() = default;
+	~FenceRing() = default;
+	FenceRing(const FenceRing&) = delete;
+	FenceRing& operator=(const FenceRing&) = delete;
+
+	bool create(int max_depth, float target_queue_ms);
+	// waits for nothing, pending fences are just dropped
+	void release();
+
+	bool full() const { return m_pending >= m_depth; }
+	bool empty() const { return m_pending == 0; }
+	int depth() const { return m_depth; }
+	float drawMs() const { return m_draw_ms; }
+
+	// brackets one draw, begin() returns the slot it goes to or -1 when none is free (no draw is tracked then and
+	// end() does nothing)
+	int begin();
+	void end();
+	// retires the oldest draw if it finishes within timeout_ns (0 only polls), consume gets its slot and gpu time
+	bool retire(GLuint64 timeout_ns, const std::function<void(int slot, float gpu_ms)>& consume);
+
+private:
+	struct Slot {
+		GLuint query = 0;
+		GLsync fence = nullptr;
+	};
+
+	std::vector<Slot> m_slots;
+	float m_target_queue_ms = 4.0f;
+	float m_draw_ms = 0.0f;     // moving average of the gpu time per draw, 0 until the first one is back
+	int m_depth = 2;            // current window, at most the slot count
+	int m_next = 0;
+	int m_pending = 0;
+	bool m_open = false;        // between begin() and end()
+};
+
+#endif
@@ -0,0 +1,20 @@
+/*
+	Mesmer - An interactive and high-performance fractal generator and explorer.
+	Made by -> Titan // GH: https://github.com/titan3755/mesmer
+	[headless_render.hpp]
+*/
+
+#pragma once
+#ifndef MESMER_HEADLESS_RENDER_HPP
+#define MESMER_HEADLESS_RENDER_HPP
+
+// exit codes of `mesmer render`
+constexpr int HEADLESS_EXIT_OK = 0;
+constexpr int HEADLESS_EXIT_FAILED = 1;
+constexpr int HEADLESS_EXIT_USAGE = 2;
+
+// `mesmer render [options]`: renders one image on the cpu engine straight to a png without a window or GL context.
+// argv holds only the options after "render". progress goes to stdout, errors to stderr
+int runHeadlessRender(int argc, char* argv[]);
+
+#endif
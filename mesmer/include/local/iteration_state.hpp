@@ -0,0 +1,46 @@
+/*
+	Mesmer - An interactive and high-performance fractal generator and explorer.
+	Made by -> Titan // GH: https://github.com/titan3755/mesmer
+	[iteration_state.hpp]
+*/
+
+#pragma once
+#ifndef MESMER_ITERATION_STATE_HPP
+#define MESMER_ITERATION_STATE_HPP
+
+#include <glad/glad.h>
+
+// storage buffer bindings, mirrored in iteration_state.glsl
+constexpr GLuint ITERATION_STATE_ORBIT_BINDING = 9;
+constexpr GLuint ITERATION_STATE_STATUS_BINDING = 10;
+
+// per pixel orbit state the full resolution passes of mandelbrot.frag and julia.frag keep for the live view: z and the
+// period check point of every pixel that ran out at the limit, and which pixels are final (escaped or interior). a higher
+// limit on the same view continues the pixels that ran out from there, so it only costs the extra iterations.
+// the orbits are fp64 and take 36 bytes a pixel, the buffers belong to the main context
+class IterationState {
+public:
+	IterationState() = default;
+	~IterationState() = default;
+	IterationState(const IterationState&) = delete;
+	IterationState& operator=(const IterationState&) = delete;
+
+	// buffers for a drawable of this size, a new size drops the state
+	bool allocate(int width, int height);
+	void release();
+	void bind() const;
+
+	// the limit the kept orbits ran to, 0 while nothing is kept
+	int iterations() const { return m_iterations; }
+	void keep(int iterations) { m_iterations = iterations; }
+	void drop() { m_iterations = 0; }
+
+private:
+	GLuint m_orbits = 0;
+	GLuint m_status = 0;
+	int m_width = 0;
+	int m_height = 0;
+	int m_iterations = 0;
+};
+
+#endif
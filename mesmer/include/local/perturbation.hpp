@@ -0,0 +1,60 @@
+/*
+	Mesmer - An interactive and high-performance fractal generator and explorer.
+	Made by -> Titan // GH: https://github.com/titan3755/mesmer
+	[perturbation.hpp]
+*/
+
+#pragma once
+#ifndef MESMER_PERTURBATION_HPP
+#define MESMER_PERTURBATION_HPP
+
+#include <big_float.hpp>
+
+#include <vector>
+#include <memory>
+#include <atomic>
+
+// below this zoom the plain fp64 shaders are exact enough, above it the mandelbrot view switches to perturbation
+constexpr double DEEP_ZOOM_THRESHOLD = 1.0e10;
+// a reference is reused for views up to this many view radii (1/zoom) away, its bla table is built for that |dc|
+constexpr double BLA_VIEW_RADII = 64.0;
+// bla jumps only become long once 1/zoom is far below double epsilon, shallower views are faster without the lookups
+constexpr double BLA_MIN_ZOOM = 1.0e30;
+
+// bilinear approximation table over a reference orbit: entry j of level k jumps 2^k iterations starting at orbit index
+// m = 1 + j * 2^k with dz -> A*dz + B*dc, and is valid while |dz| < r and |dc| <= c_max
+struct BlaTable {
+	double c_max = 0.0;
+	std::vector<int> level_offsets; // first entry of every level
+	std::vector<int> level_counts;
+	std::vector<double> entries;    // A (re, im), B (re, im), r, 0 per entry, a dvec2[3] per entry in the shader
+
+	int levels() const { return (int)level_counts.size(); }
+	// applies the longest valid jump at orbit index ref, returns its length (0 when none fits)
+	int apply(int ref, int remaining, double dc_x, double dc_y, double& dz_x, double& dz_y) const;
+};
+
+BlaTable buildBlaTable(const std::vector<double>& orbit, double c_max);
+
+// one mandelbrot orbit Z_n iterated in BigFloat precision, pixels then only iterate their (double) delta from it:
+// dz' = 2*Z*dz + dz^2 + dc, rebasing to the start of the orbit whenever |Z + dz| < |dz| or the orbit runs out
+struct ReferenceOrbit {
+	BigFloat center_x;
+	BigFloat center_y;
+	double zoom = 1.0;           // zoom the precision was picked for
+	int max_iterations = 0;
+	bool escaped = false;
+	std::vector<double> points;  // Z_0 .. Z_n interleaved (re, im), same layout as a std430 dvec2 array
+	BlaTable bla;
+
+	int length() const { return (int)(points.size() / 2); }
+};
+
+int referencePrecisionLimbs(double zoom);
+// returns nullptr when cancelled
+std::shared_ptr<ReferenceOrbit> computeReferenceOrbit(const BigFloat& center_x, const BigFloat& center_y, double zoom,
+	int max_iterations, const std::atomic<bool>* cancel = nullptr);
+// an orbit stays usable while it is precise enough for the zoom, long enough for the iterations and close to the view
+bool referenceOrbitUsable(const ReferenceOrbit& reference, double offset_x, double offset_y, double zoom, int max_iterations);
+
+#endif
@@ -0,0 +1,107 @@
+/*
+	Mesmer - An interactive and high-performance fractal generator and explorer.
+	Made by -> Titan // GH: https://github.com/titan3755/mesmer
+	[png_writer.hpp]
+*/
+
+#pragma once
+#ifndef MESMER_PNG_WRITER_HPP
+#define MESMER_PNG_WRITER_HPP
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+// streaming 8 bit RGBA png encoder without dependencies. rows go in top to bottom and are filtered and compressed as
+// they arrive, so the image never has to exist in memory as a whole. deflate uses the fixed huffman codes with lz77
+// matching over the full 32k window, which does well on fractal images where filtered rows are mostly repeats
+class PngWriter {
+public:
+	PngWriter() = default;
+	~PngWriter();
+	PngWriter(const PngWriter&) = delete;
+	PngWriter& operator=(const PngWriter&) = delete;
+
+	bool open(const std::string& path, int width, int height);
+	// width * 4 bytes of the next row down
+	bool writeRow(const unsigned char* rgba);
+	// false when rows are missing or the file could not be written, a failed file is removed
+	bool close();
+
+	int width() const { return m_width; }
+	int height() const { return m_height; }
+	int rowsWritten() const { return m_rows; }
+
+private:
+	void filterRow(const unsigned char* rgba);
+	void deflate(const unsigned char* data, size_t size);
+	void compressPiece(size_t size);
+	void putBits(uint32_t bits, int count);
+	void putHuffman(uint32_t code, int length);
+	void putLiteral(int symbol);
+	void putMatch(int length, int distance);
+	void updateAdler(const unsigned char* data, size_t size);
+	void flushChunk(bool force);
+	void writeChunk(const char type[4], const unsigned char* data, size_t size);
+
+	std::string m_path;
+	std::ofstream m_file;
+	bool m_failed = false;
+	int m_width = 0;
+	int m_height = 0;
+	int m_rows = 0;
+	std::vector<unsigned char> m_previous;              // unfiltered previous row, zeros above the first
+	std::vector<unsigned char> m_candidates;            // the five filtered versions of the current row, each with its filter byte
+
+	// deflate state, the window is a ring twice the lz77 distance so a whole input piece fits behind it
+	std::vector<unsigned char> m_window;
+	std::vector<int64_t> m_head;
+	std::vector<int64_t> m_chain;
+	int64_t m_position = 0;
+	uint32_t m_bit_buffer = 0;
+	int m_bit_count = 0;
+	std::vector<unsigned char> m_pending;               // compressed bytes waiting for the next IDAT chunk
+	uint32_t m_adler_a = 1;
+	uint32_t m_adler_b = 0;
+};
+
+// runs a PngWriter on a thread of its own so filtering and deflate overlap with whoever produces the pixels. bands of
+// rows are handed over whole, in GL order (bottom row first), and written top band first. at most depth bands wait
+// in the queue, acquire() blocks beyond that
+class PngBandEncoder {
+public:
+	PngBandEncoder() = default;
+	~PngBandEncoder();
+	PngBandEncoder(const PngBandEncoder&) = delete;
+	PngBandEncoder& operator=(const PngBandEncoder&) = delete;
+
+	bool open(const std::string& path, int width, int height, int depth);
+	// a buffer for the next band, recycled from the encoder when one is free
+	std::vector<unsigned char> acquire(int rows);
+	void submit(std::vector<unsigned char> band);
+	bool failed() const { return m_failed.load(); }
+	// waits for the queued bands, false when anything failed or rows are missing
+	bool close();
+
+private:
+	void encodeLoop();
+
+	PngWriter m_writer;
+	int m_width = 0;
+	int m_depth = 2;
+	std::thread m_thread;
+	std::mutex m_mutex;
+	std::condition_variable m_changed;
+	std::deque<std::vector<unsigned char>> m_queue;
+	std::vector<std::vector<unsigned char>> m_free;
+	bool m_closing = false;
+	std::atomic<bool> m_failed{ false };
+};
+
+#endif
@@ -0,0 +1,113 @@
+/*
+	Mesmer - An interactive and high-performance fractal generator and explorer.
+	Made by -> Titan // GH: https://github.com/titan3755/mesmer
+	[profiler.hpp]
+*/
+
+#pragma once
+#ifndef MESMER_PROFILER_HPP
+#define MESMER_PROFILER_HPP
+
+#include <array>
+#include <vector>
+#include <mutex>
+#include <chrono>
+
+// frames of history per pass, a few seconds at the usual frame rates
+constexpr int PROFILER_HISTORY = 240;
+constexpr int PROFILER_MAX_PASSES = 8;
+
+// frame profiler of the main loop. every pass gets a cpu timer and, when it issues gpu work, a GL_TIMESTAMP pair.
+// the queries live in a ring of frames and are read back a few frames late, so the cpu never waits on the gpu
+// (results that are still not in by then are dropped). nothing is measured while it is disabled
+class Profiler {
+public:
+	struct Percentiles {
+		float p50 = 0.0f;
+		float p95 = 0.0f;
+		float p99 = 0.0f;
+	};
+
+	// times the enclosing block as one pass
+	class Scope {
+	public:
+		Scope(Profiler& profiler, const char* name, bool gpu) : m_profiler(profiler), m_pass(profiler.beginPass(name, gpu)) {}
+		~Scope() { m_profiler.endPass(m_pass); }
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+
+	private:
+		Profiler& m_profiler;
+		int m_pass;
+	};
+
+	Profiler() = default;
+	Profiler(const Profiler&) = delete;
+	Profiler& operator=(const Profiler&) = delete;
+
+	// takes effect with the next frame, so a pass is never left half measured
+	void setEnabled(bool enabled) { m_requested = enabled; }
+	bool enabled() const { return m_enabled; }
+
+	void beginFrame();
+	void endFrame();
+	// passes are told apart by name, a string literal is expected. returns -1 when nothing is measured
+	int beginPass(const char* name, bool gpu);
+	void endPass(int pass);
+
+	// pre-render tiles report from the worker thread, gpu tiles with their GL_TIME_ELAPSED and cpu tiles with their wall time
+	void recordTile(bool gpu, float milliseconds);
+	void clearTiles();
+
+	void drawOverlay(bool* open);
+	// needs the context the queries were made on
+	void release();
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	struct History {
+		std::array<float, PROFILER_HISTORY> samples{};
+		int next = 0;
+		int count = 0;
+
+		void push(float value);
+		float last() const;
+		Percentiles percentiles() const;
+	};
+
+	struct Pass {
+		const char* name = nullptr;
+		bool gpu = false;
+		Clock::time_point cpu_start;
+		History cpu_ms;
+		History gpu_ms;
+	};
+
+	struct FrameQueries {
+		std::array<unsigned int, PROFILER_MAX_PASSES * 2> ids{}; // begin and end timestamp of each pass
+		std::array<bool, PROFILER_MAX_PASSES> issued{};
+		bool pending = false;
+	};
+
+	static constexpr int QUERY_FRAMES = 3;
+
+	void collect(FrameQueries& frame);
+	static Percentiles tilePercentiles(std::vector<float> samples);
+
+	bool m_requested = false;
+	bool m_enabled = false;
+	bool m_frame_open = false;
+	Clock::time_point m_frame_start;
+	History m_frame_ms;
+	std::array<Pass, PROFILER_MAX_PASSES> m_passes;
+	int m_pass_count = 0;
+	std::array<FrameQueries, QUERY_FRAMES> m_frames;
+	int m_frame_slot = 0;
+
+	std::mutex m_tile_mutex;
+	std::vector<float> m_gpu_tiles;
+	std::vector<float> m_cpu_tiles;
+};
+
+#endif
@@ -0,0 +1,120 @@
+/*
+	Mesmer - An interactive and high-performance fractal generator and explorer.
+	Made by -> Titan // GH: https://github.com/titan3755/mesmer
+	[progressive_renderer.hpp]
+*/
+
+#pragma once
+#ifndef MESMER_PROGRESSIVE_RENDERER_HPP
+#define MESMER_PROGRESSIVE_RENDERER_HPP
+
+#include <shader.hpp>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// coarsest level of the live view, 1/8 of the drawable in each direction. any whole divisor up to it can be picked
+constexpr int PROGRESSIVE_MAX_SCALE = 8;
+// refinement strips never get thinner than this, tiny draws cost more in overhead than they save
+constexpr int PROGRESSIVE_MIN_STRIP_ROWS = 8;
+constexpr float PROGRESSIVE_DEFAULT_BUDGET_MS = 10.0f;
+
+// live view accumulation: while the view changes every frame is drawn at the finest scale that fits the frame budget,
+// once it holds still the following frames refine it to full resolution in row strips sized to the same budget.
+// the fractal shader always covers the whole level viewport, strips only scissor it, so no shader has to know about levels
+class ProgressiveRenderer {
+public:
+	ProgressiveRenderer() = default;
+	ProgressiveRenderer(const ProgressiveRenderer&) = delete;
+	ProgressiveRenderer& operator=(const ProgressiveRenderer&) = delete;
+
+	// the next pass starts over at the interactive scale
+	void invalidate() { m_restart = true; }
+	// when disabled every frame is a full resolution pass, like a plain render
+	void setEnabled(bool enabled) { m_enabled = enabled; }
+	void setFrameBudget(float milliseconds) { m_budget_ms = milliseconds; }
+	// reduced levels are scaled up with this program (simple.vert quad) instead of a bilinear blit when it is set
+	void setUpscaler(Shader* shader, unsigned int vao) { m_upscaler = shader; m_upscaler_vao = vao; }
+	// keeps the finished image for a view that only panned or zoomed, new pixel p shows what old pixel p * scale + offset
+	// showed (drawable pixels, origin bottom left). a pan moves it by whole pixels and the next pass only shades the bands
+	// it exposed, a zoom turns it into a resampled preview that full resolution strips then replace.
+	// returns false when there is nothing worth keeping, the caller invalidates then
+	bool reproject(double scale, double offset_x, double offset_y);
+	// the finished image came out of full resolution strips over one unchanged view, so per pixel state the kernel kept
+	// in those strips covers all of it
+	bool resumable() const { return m_enabled && m_complete && m_full_pass; }
+	// the next passes run full resolution strips over the finished image in place, for a kernel that continues its kept
+	// state and leaves the final pixels alone. false when the image is not resumable
+	bool resume();
+	bool resuming() const { return m_resuming; }
+
+	// binds the accumulation target with this frame's viewport and scissor, returns false when the view is already complete
+	bool beginPass(int width, int height);
+	void endPass();
+	// scales the finished level up to the bound draw framebuffer and lays the refined strips of the next level over it
+	void present(int width, int height) const;
+	// gl objects are not freed by the destructor, the context is usually gone by then
+	void release();
+
+	bool complete() const { return m_complete; }
+	int scale() const { return m_level; }
+	// refined share of the current level
+	float progress() const;
+	// measured gpu cost of a full resolution pass, 0 until the first timings come back
+	double fullFrameMs() const;
+
+private:
+	struct PixelRect {
+		int x, y, width, height;
+	};
+
+	void allocate(int width, int height);
+	void beginPatchPass();
+	void presentLevel(int target, int level, int source_rows, int width, int screen_rows) const;
+	bool shift(double offset_x, double offset_y);
+	bool resample(double scale, double offset_x, double offset_y);
+	void collectTimings();
+	int interactiveScale() const;
+	int levelWidth(int level) const { return (m_width + level - 1) / level; }
+	int levelHeight(int level) const { return (m_height + level - 1) / level; }
+
+	static constexpr int QUERY_COUNT = 4;
+
+	bool m_enabled = true;
+	float m_budget_ms = PROGRESSIVE_DEFAULT_BUDGET_MS;
+	Shader* m_upscaler = nullptr;
+	unsigned int m_upscaler_vao = 0;
+	int m_width = 0;
+	int m_height = 0;
+	// [0] holds the last finished level, [1] the one being refined, swapped when it finishes
+	unsigned int m_textures[2] = { 0, 0 };
+	unsigned int m_fbos[2] = { 0, 0 };
+	unsigned int m_stencil = 0; // shared by both targets, masks the retained pixels during a patch pass
+	int m_finished_level = 0; // 0 until a level finished
+	int m_level = PROGRESSIVE_MAX_SCALE;
+	int m_rows_done = 0;
+	int m_pass_rows = 0;
+	bool m_restart = true;
+	bool m_complete = false;
+	bool m_full_pass = false; // see resumable()
+	bool m_resuming = false;
+
+	// bands a pan exposed, drawn at full resolution straight into the finished image by the next pass
+	std::vector<PixelRect> m_patches;
+	bool m_patch_pass = false;
+	int64_t m_pass_pixels = 0;
+	// the retained pixels show the view position p + residual, whole pixel shifts leave up to half a pixel behind
+	double m_residual_x = 0.0;
+	double m_residual_y = 0.0;
+
+	// GL_TIME_ELAPSED ring, results are read back frames later so the cpu never waits on them
+	std::array<unsigned int, QUERY_COUNT> m_queries{};
+	std::array<int64_t, QUERY_COUNT> m_query_pixels{};
+	std::array<bool, QUERY_COUNT> m_query_pending{};
+	int m_query_next = 0;
+	int m_pass_query = -1;
+	double m_ns_per_pixel = 0.0; // smoothed, 0 until measured
+};
+
+#endif
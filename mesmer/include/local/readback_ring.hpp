@@ -0,0 +1,54 @@
+/*
+	Mesmer - An interactive and high-performance fractal generator and explorer.
+	Made by -> Titan // GH: https://github.com/titan3755/mesmer
+	[readback_ring.hpp]
+*/
+
+#pragma once
+#ifndef MESMER_READBACK_RING_HPP
+#define MESMER_READBACK_RING_HPP
+
+#include <vector>
+#include <functional>
+#include <atomic>
+#include <glad/glad.h>
+
+// asynchronous RGBA8 read back through a ring of pixel pack buffers, each with its own fence. read() only queues the
+// copy, the pixels are mapped when the slot comes around again, so the gpu keeps rendering the next tiles while
+// earlier ones travel to the host. everything belongs to the context it was created on
+class ReadbackRing {
+public:
+	ReadbackRing() = default;
+	~ReadbackRing() = default;
+	ReadbackRing(const ReadbackRing&) = delete;
+	ReadbackRing& operator=(const ReadbackRing&) = delete;
+
+	// every slot holds up to width x height pixels
+	bool create(int slot_count, int width, int height);
+	void release();
+
+	bool full() const { return m_pending == (int)m_slots.size(); }
+	bool empty() const { return m_pending == 0; }
+	// queues a width x height read of the bound read framebuffer at (x, y), a slot has to be free
+	void read(int x, int y, int width, int height, int tag);
+	// waits for the oldest read, hands its tightly packed rows (bottom up, width * 4 bytes each) to consume and frees the slot.
+	// cancel is checked between the slices of the wait, a cancelled wait returns false and leaves the read queued
+	bool retire(const std::function<void(int tag, const unsigned char* pixels)>& consume, const std::atomic<bool>* cancel = nullptr);
+
+private:
+	struct Slot {
+		GLuint buffer = 0;
+		GLsync fence = nullptr;
+		int tag = 0;
+		int width = 0;
+		int height = 0;
+	};
+
+	std::vector<Slot> m_slots;
+	int m_width = 0;
+	int m_height = 0;
+	int m_next = 0;     // slot the next read goes to
+	int m_pending = 0;  // reads in flight, the oldest is m_pending slots behind m_next
+};
+
+#endif
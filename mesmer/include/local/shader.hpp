@@ -12,35 +12,96 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 
 class Shader {
 public:
+    // pre-resolved uniform, an invalid one (optimised out or misspelled) makes the setters no-ops like location -1 does
+    struct Uniform {
+        int index = -1;
+        bool valid() const { return index >= 0; }
+    };
+
     unsigned int ID;
     Shader(const char* vertexPath, const char* fragmentPath);
+    // with deferLink the compile and link are only submitted, so a batch of programs can build in parallel
+    // (GL_KHR_parallel_shader_compile), finishLink then waits for the driver and must run before the first use
+    Shader(const char* vertexPath, const char* fragmentPath, bool deferLink);
+    // a compute program, linked (or loaded from the cache) right away
+    explicit Shader(const char* computePath);
+    void finishLink();
     void use();
-    void setBool(const std::string& name, bool value) const;
-    void setInt(const std::string& name, int value) const;
-    void setFloat(const std::string& name, float value) const;
-    void setDouble(const std::string& name, double value) const;
-    void setDVec2(const std::string& name, double v1, double v2) const;
-    void setVec2(const std::string& name, const glm::vec2& value) const;
-    void setVec2(const std::string& name, float x, float y) const;
-    void setVec3(const std::string& name, const glm::vec3& value) const;
-    void setVec3(const std::string& name, float x, float y, float z) const;
-    void setVec4(const std::string& name, const glm::vec4& value) const;
-    void setVec4(const std::string& name, float x, float y, float z, float w) const;
-    void setMat2(const std::string& name, const glm::mat2& mat) const;
-    void setMat3(const std::string& name, const glm::mat3& mat) const;
-    void setMat4(const std::string& name, const glm::mat4& mat) const;
-    void setMat4(const std::string& name, const float* value) const;
-	void setIVec4(const std::string &name, int v1, int v2, int v3, int v4) const;
+    // the active uniforms are reflected once after linking, so this is a hash lookup and never reaches the driver
+    Uniform uniform(std::string_view name) const;
+
+    // the handle setters upload through glProgramUniform* and skip values the program already holds,
+    // the named ones resolve the handle first and take string literals without allocating
+    void setBool(Uniform uniform, bool value) const;
+    void setInt(Uniform uniform, int value) const;
+    void setFloat(Uniform uniform, float value) const;
+    void setDouble(Uniform uniform, double value) const;
+    void setDVec2(Uniform uniform, double v1, double v2) const;
+    void setVec2(Uniform uniform, float x, float y) const;
+    void setVec3(Uniform uniform, float x, float y, float z) const;
+    void setVec4(Uniform uniform, float x, float y, float z, float w) const;
+    void setIVec2(Uniform uniform, int v1, int v2) const;
+    void setIVec4(Uniform uniform, int v1, int v2, int v3, int v4) const;
+    void setIntArray(Uniform uniform, const int* values, int count) const;
+
+    void setBool(std::string_view name, bool value) const;
+    void setInt(std::string_view name, int value) const;
+    void setFloat(std::string_view name, float value) const;
+    void setDouble(std::string_view name, double value) const;
+    void setDVec2(std::string_view name, double v1, double v2) const;
+    void setVec2(std::string_view name, const glm::vec2& value) const;
+    void setVec2(std::string_view name, float x, float y) const;
+    void setVec3(std::string_view name, const glm::vec3& value) const;
+    void setVec3(std::string_view name, float x, float y, float z) const;
+    void setVec4(std::string_view name, const glm::vec4& value) const;
+    void setVec4(std::string_view name, float x, float y, float z, float w) const;
+    void setMat2(std::string_view name, const glm::mat2& mat) const;
+    void setMat3(std::string_view name, const glm::mat3& mat) const;
+    void setMat4(std::string_view name, const glm::mat4& mat) const;
+    void setMat4(std::string_view name, const float* value) const;
+	void setIVec2(std::string_view name, int v1, int v2) const;
+	void setIVec4(std::string_view name, int v1, int v2, int v3, int v4) const;
+	void setIntArray(std::string_view name, const int* values, int count) const;
 
 private:
     void checkCompileErrors(GLuint shader, std::string type);
+    // linked programs are cached on disk keyed by their source and the driver, a cached binary the driver rejects
+    // (driver update, different gpu) is dropped and the program is compiled again
+    bool loadProgramBinary(uint64_t key);
+    void saveProgramBinary(uint64_t key) const;
+    void reflectUniforms();
+    // true (and remembered) when the bytes differ from the last upload of the uniform
+    bool changed(Uniform uniform, const void* data, size_t bytes) const;
+    GLint location(Uniform uniform) const { return m_uniforms[uniform.index].location; }
+
+    struct UniformNameHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view name) const { return std::hash<std::string_view>{}(name); }
+    };
+    struct UniformSlot {
+        GLint location = -1;
+        size_t offset = 0;      // into m_uniform_values
+        size_t bytes = 0;       // whole uniform, every array element included
+        bool uploaded = false;
+    };
+    std::unordered_map<std::string, int, UniformNameHash, std::equal_to<>> m_uniform_index;
+    mutable std::vector<UniformSlot> m_uniforms;
+    mutable std::vector<unsigned char> m_uniform_values; // last uploaded value of every uniform
+    bool m_pending_link = false;
+    GLuint m_pending_vertex = 0;
+    GLuint m_pending_fragment = 0;
+    uint64_t m_pending_cache_key = 0;
 };
 
 #endif
@@ -0,0 +1,34 @@
+/*
+	Mesmer - An interactive and high-performance fractal generator and explorer.
+	Made by -> Titan // GH: https://github.com/titan3755/mesmer
+	[shader_precision.hpp]
+*/
+
+#pragma once
+#ifndef MESMER_SHADER_PRECISION_HPP
+#define MESMER_SHADER_PRECISION_HPP
+
+#include <string>
+
+// consumer gpus run fp64 at 1/16 - 1/64 of the fp32 rate, so the escape-time kernels also ship a df64 (float-float) twin
+enum class ShaderPrecision { AUTO, FP64, DF64 };
+
+// df64 keeps ~48 mantissa bits, once a pixel gets smaller than this the views go back to the fp64 kernels
+constexpr double DF64_MIN_PIXEL_SPACING = 1.0e-12;
+
+struct PrecisionBenchmark {
+	bool valid = false;
+	double fp64_ms = 0.0;
+	double df64_ms = 0.0;
+
+	// a small margin keeps cards where both are equally fast on the exact kernel
+	bool df64Faster() const { return valid && df64_ms < fp64_ms * 0.9; }
+};
+
+// times mandelbrot.frag against mandelbrot_df64.frag on an offscreen target, needs a current GL context and the screen quad
+PrecisionBenchmark benchmarkShaderPrecision(unsigned int vao);
+// shaders/x_df64.frag for fragment shaders with a df64 twin, empty otherwise
+std::string df64FragmentPath(const std::string& fragment_path);
+bool df64Usable(double zoom, int pixels);
+
+#endif
@@ -0,0 +1,74 @@
+/*
+	Mesmer - An interactive and high-performance fractal generator and explorer.
+	Made by -> Titan // GH: https://github.com/titan3755/mesmer
+	[shader_registry.hpp]
+*/
+
+#pragma once
+#ifndef MESMER_SHADER_REGISTRY_HPP
+#define MESMER_SHADER_REGISTRY_HPP
+
+#include <shader.hpp>
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <SDL.h>
+
+// owns every shader program of the application. the programs queued at startup are compiled on the worker context
+// in a background thread, objects are shared between the contexts so the main thread can use them once they are ready
+class ShaderRegistry {
+public:
+	ShaderRegistry() = default;
+	~ShaderRegistry();
+	ShaderRegistry(const ShaderRegistry&) = delete;
+	ShaderRegistry& operator=(const ShaderRegistry&) = delete;
+
+	void add(const std::string& vertex_path, const std::string& fragment_path);
+	// compiles everything queued so far, the worker context is current on the background thread until it finishes
+	void precompile(SDL_Window* window, SDL_GLContext worker_context);
+	// the linked program, compiled right here on the calling thread's context when the background thread has not
+	// reached it yet, or waited for (and moved to the front) when it is compiling it
+	Shader* get(const std::string& vertex_path, const std::string& fragment_path);
+	// compute programs are entries without a vertex stage
+	Shader* getCompute(const std::string& compute_path) { return get(std::string(), compute_path); }
+	bool ready(const std::string& vertex_path, const std::string& fragment_path) const;
+	int readyCount() const;
+	int total() const;
+	// blocks until the background thread has released the worker context
+	void waitForPrecompile();
+	// stops the background thread and deletes every program, needs a current context
+	void release();
+
+private:
+	enum class State { QUEUED, COMPILING, READY };
+	struct Entry {
+		std::string vertex_path;
+		std::string fragment_path;
+		std::unique_ptr<Shader> shader;
+		State state = State::QUEUED;
+	};
+
+	static std::string key(const std::string& vertex_path, const std::string& fragment_path);
+	static std::unique_ptr<Shader> build(const std::string& vertex_path, const std::string& fragment_path, bool defer_link);
+	Entry* findOrAdd(const std::string& vertex_path, const std::string& fragment_path);
+	void compileQueued(SDL_Window* window, SDL_GLContext worker_context);
+
+	mutable std::mutex m_mutex;
+	std::condition_variable m_program_ready;
+	std::vector<std::unique_ptr<Entry>> m_entries; // stable addresses, m_index and m_wanted point into it
+	std::unordered_map<std::string, Entry*> m_index;
+	Entry* m_wanted = nullptr;
+	int m_ready_count = 0;
+
+	std::mutex m_thread_mutex;
+	std::thread m_thread;
+	std::atomic<bool> m_stop{ false };
+};
+
+#endif
@@ -0,0 +1,80 @@
+/*
+	Mesmer - An interactive and high-performance fractal generator and explorer.
+	Made by -> Titan // GH: https://github.com/titan3755/mesmer
+	[tile_scheduler.hpp]
+*/
+
+#pragma once
+#ifndef MESMER_TILE_SCHEDULER_HPP
+#define MESMER_TILE_SCHEDULER_HPP
+
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <memory>
+
+struct ScheduledTile {
+	int x = 0;          // pixel rect inside the target image
+	int y = 0;
+	int width = 0;
+	int height = 0;
+	int grid_x = 0;     // tile coordinates, used for u_tile_info
+	int grid_y = 0;
+	double priority = 0.0; // lower runs first
+};
+
+// estimated gpu time of every cell of a coarse grid over the image, from a low resolution probe of the kernel
+struct TileCostMap {
+	int cell_size = 0;      // pixels per cell side
+	int cells_x = 0;
+	int cells_y = 0;
+	std::vector<float> cell_ms;
+
+	bool empty() const { return cell_ms.empty(); }
+	// cells count by the part of them the rect covers
+	double rectMs(int x, int y, int width, int height) const;
+};
+
+// per-worker deques with work stealing: owners pop their best tile from the front, idle workers steal from the back of the fullest deque
+class TileScheduler {
+public:
+	explicit TileScheduler(unsigned int worker_count);
+
+	// tiles are sorted by priority and dealt round-robin, so every deque is itself in priority order
+	void reset(std::vector<ScheduledTile> tiles);
+	bool acquire(unsigned int worker, ScheduledTile& tile);
+	void complete(const ScheduledTile& tile);
+
+	void cancel() { m_cancelled.store(true); }
+	bool cancelled() const { return m_cancelled.load(); }
+
+	unsigned int workerCount() const { return (unsigned int)m_queues.size(); }
+	int total() const { return m_total.load(); }
+	int completed() const { return m_completed.load(); }
+	int stolen() const { return m_stolen.load(); }
+	float progress() const;
+	bool finished() const { return m_completed.load() >= m_total.load(); }
+
+	// uniform grid over a width x height image, tiles closest to (focus_x, focus_y) first
+	static std::vector<ScheduledTile> makeGrid(int width, int height, int tile_size, double focus_x, double focus_y);
+	// quadtree over the cost map: a tile is split until its estimate fits budget_ms or it is min_tile wide, so cheap regions
+	// go out as max_tile squares and expensive ones as small tiles. edge tiles are cut to the image
+	static std::vector<ScheduledTile> makeAdaptive(int width, int height, int min_tile, int max_tile, const TileCostMap& cost, double budget_ms,
+		double focus_x, double focus_y);
+
+private:
+	bool steal(unsigned int thief, ScheduledTile& tile);
+
+	struct WorkerQueue {
+		std::mutex mutex;
+		std::deque<ScheduledTile> tiles;
+	};
+	std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+	std::atomic<int> m_total{ 0 };
+	std::atomic<int> m_completed{ 0 };
+	std::atomic<int> m_stolen{ 0 };
+	std::atomic<bool> m_cancelled{ false };
+};
+
+#endif
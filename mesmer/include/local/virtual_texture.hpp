@@ -0,0 +1,110 @@
+/*
+	Mesmer - An interactive and high-performance fractal generator and explorer.
+	Made by -> Titan // GH: https://github.com/titan3755/mesmer
+	[virtual_texture.hpp]
+*/
+
+#pragma once
+#ifndef MESMER_VIRTUAL_TEXTURE_HPP
+#define MESMER_VIRTUAL_TEXTURE_HPP
+
+#include <shader.hpp>
+
+#include <cstdint>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <SDL.h>
+
+// page size, cache size and level count are mirrored in texture_view.frag
+constexpr int VT_PAGE_SIZE = 256;
+constexpr int VT_CACHE_PAGES = 16;      // the physical cache holds VT_CACHE_PAGES x VT_CACHE_PAGES pages (4096^2 texels)
+constexpr int VT_MAX_LEVELS = 10;       // detail levels above the base texture, each one doubles the resolution
+
+// detail pyramid over the pre-render texture for the viewer. level l splits the pre-render image into
+// (base pages << l)^2 pages, the visible ones of the level the zoom asks for are rendered on the worker context and kept
+// as iteration g-buffer in a fixed atlas, so the colouring stays a view time pass. a page table holds the visible window
+// of every level, pages that are not in yet fall through to the coarser levels and finally to the base texture
+class VirtualTexture {
+public:
+	// binds the tiled pre-render kernel with the view uniforms on the worker context for an image of the given size,
+	// nullptr when it cannot draw
+	using KernelBinder = std::function<Shader*(int resolution)>;
+
+	VirtualTexture() = default;
+	~VirtualTexture() = default;
+	VirtualTexture(const VirtualTexture&) = delete;
+	VirtualTexture& operator=(const VirtualTexture&) = delete;
+
+	// base_resolution is the pre-render texture size. the worker context is shared with the pre-render and the export,
+	// context_mutex is held while it is current
+	bool create(int base_resolution, SDL_Window* window, SDL_GLContext worker_context, std::mutex* context_mutex,
+		unsigned int vbo, unsigned int ebo, KernelBinder bind_kernel);
+	// stops the worker, needs the main context
+	void release();
+	bool active() const { return m_value_atlas != 0; }
+
+	// once per frame before drawing: the view of texture_view.frag (centre and zoom in texture uv) on a drawable of the given size
+	void update(double center_u, double center_v, double zoom, int drawable_w, int drawable_h);
+	// the atlases go to the two texture units, the page table to its storage buffer binding
+	void bind(Shader* shader, int value_unit, int orbit_unit) const;
+
+	int level() const { return m_level; }
+	int residentPages() const;
+	int queuedPages() const;
+	// pages are still on their way, the viewer has to keep drawing to show them
+	bool busy() const;
+
+private:
+	enum class SlotState { EMPTY, QUEUED, RENDERING, RESIDENT };
+	struct Slot {
+		uint64_t key = 0;
+		SlotState state = SlotState::EMPTY;
+		uint64_t last_used = 0;
+	};
+	struct Window {
+		int x = 0;
+		int y = 0;
+		int width = 0;
+		int height = 0;
+	};
+
+	static uint64_t pageKey(int level, int x, int y) { return ((uint64_t)level << 48) | ((uint64_t)y << 24) | (uint64_t)x; }
+	int pagesPerSide(int level) const { return m_base_pages << level; }
+	int acquireSlot();
+	// forgets the pages no worker has picked up, m_mutex held
+	void dropQueued();
+	void workerLoop();
+
+	int m_base_pages = 1;
+	SDL_Window* m_window = nullptr;
+	SDL_GLContext m_worker_context = nullptr;
+	std::mutex* m_context_mutex = nullptr;
+	unsigned int m_vbo = 0;
+	unsigned int m_ebo = 0;
+	KernelBinder m_bind_kernel;
+
+	unsigned int m_value_atlas = 0;     // r32f
+	unsigned int m_orbit_atlas = 0;     // rgba8
+	unsigned int m_page_table = 0;      // ssbo: level windows, table offsets, slot per page
+	std::vector<int32_t> m_table;
+	int m_level = 0;
+	uint64_t m_frame = 0;
+
+	// slots and the queue are shared with the worker
+	mutable std::mutex m_mutex;
+	std::condition_variable m_wake;
+	std::vector<Slot> m_slots;
+	std::unordered_map<uint64_t, int> m_lookup;
+	std::deque<int> m_queue;            // queued slots, most wanted first
+	int m_rendering = 0;
+	std::thread m_thread;
+	std::atomic<bool> m_stop{ false };
+};
+
+#endif
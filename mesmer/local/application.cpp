@@ -63,6 +63,21 @@ void Application::run() {
 		glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
 		m_pre_render_highest_supported_resolution = maxTextureSize;
 
+		// cpu pre-render backend capabilities
+		m_cpu_simd_level = CpuRenderer::detectSimdLevel();
+		spdlog::info("CPU SIMD level available for the CPU pre-render backend: {}", CpuRenderer::simdLevelName(m_cpu_simd_level));
+
+		// fp64 vs df64 throughput on this gpu
+		m_precision_benchmark = benchmarkShaderPrecision(VAO);
+		if (m_precision_benchmark.valid) {
+			spdlog::info("Shader precision benchmark: fp64 {:.2f} ms, df64 {:.2f} ms -> using {} kernels where possible.",
+				m_precision_benchmark.fp64_ms, m_precision_benchmark.df64_ms, m_precision_benchmark.df64Faster() ? "df64" : "fp64");
+		}
+
+		// every program is compiled in the background while the menu is up
+		queueShaderPrograms();
+		m_shaders.precompile(window, m_worker_context);
+
 		// settings load
 		// bg menu settings load attempt
 		if (app_settings.getSetting("menu_bg_color_one") != "") {
@@ -169,20 +184,62 @@ void Application::run() {
 			}
 		}
 
+		// frame pacing, vsync sets the swap interval and max_fps caps the loop (0 leaves it uncapped)
+		if (app_settings.getSetting("vsync") != "") {
+			std::string bool_str = app_settings.getSetting("vsync");
+			m_vsync = bool_str == "true";
+			spdlog::info("Loaded vsync from settings: {}", bool_str);
+		}
+		if (SDL_GL_SetSwapInterval(m_vsync ? 1 : 0) != 0) {
+			spdlog::warn("Could not set the swap interval: {}", SDL_GetError());
+		}
+
+		if (app_settings.getSetting("max_fps") != "") {
+			std::string int_str = app_settings.getSetting("max_fps");
+			try {
+				int value = std::stoi(int_str);
+				if (value >= 0 && value <= 1000) {
+					m_max_fps = value;
+					spdlog::info("Loaded max_fps from settings: {}", int_str);
+				}
+				else {
+					spdlog::warn("max_fps in settings is out of range (0-1000). Using default value: 120");
+				}
+			}
+			catch (const std::exception& e) {
+				spdlog::error("Error parsing max_fps from settings: {}. Using default value: 120", e.what());
+			}
+		}
+
 		// <--
 
 
 		// --------------------------------- main loop ---------------------------------
 
 		while (!done) {
+			syncMandelbrotCenter();
+			// a finished static view is never redrawn, so the loop can sleep until input arrives
+			const int idle_timeout = idleWaitTimeout();
+			if (idle_timeout > 0) {
+				SDL_WaitEventTimeout(nullptr, idle_timeout);
+			}
+			m_frame_start = SDL_GetPerformanceCounter();
+			m_profiler.setEnabled(m_show_profiler);
+			m_profiler.beginFrame();
+			const int events_pass = m_profiler.beginPass("Events", false);
 			SDL_Event event;
 			while (SDL_PollEvent(&event)) {
+				m_active_frames = IDLE_SETTLE_FRAMES;
 				ImGuiIO& io = ImGui::GetIO();
 				ImGui_ImplSDL2_ProcessEvent(&event);
 				if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_h)
 				{
 					hud_toggle = !hud_toggle;
 				}
+				if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_j)
+				{
+					m_show_profiler = !m_show_profiler;
+				}
 				// prerender event handling
 				if (m_pre_render_complete && !io.WantCaptureMouse)
 				{
@@ -225,14 +282,7 @@ void Application::run() {
 					}
 					if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_SPACE) {
 						if (m_pre_render_complete) {
-							glDeleteTextures(1, &m_pre_render_texture);
-							glDeleteFramebuffers(1, &m_pre_render_fbo);
-							if (m_texture_view_shader != nullptr) {
-								delete m_texture_view_shader;
-								m_texture_view_shader = nullptr;
-							}
-							m_pre_render_texture = 0;
-							m_pre_render_fbo = 0;
+							releasePreRender();
 						}
 						m_pre_render_enabled = false;
 						m_pre_render_complete = false;
@@ -241,11 +291,7 @@ void Application::run() {
 						show_fractal_selection = false;
 						spdlog::info("'Space' key pressed - toggling main buttons.");
 						Application::m_currentFractal = FractalType::NONE;
-						if (ourShader != nullptr) {
-							delete ourShader;
-							ourShader = nullptr;
-						}
-						ourShader = new Shader("shaders/background.vert", "shaders/background.frag");
+						ourShader = m_shaders.get("shaders/background.vert", "shaders/background.frag");
 						spdlog::info("Reverted to background shader.");
 						sub = "Mesmer - Main Menu";
 						title_text_toggle = true;
@@ -256,14 +302,7 @@ void Application::run() {
 						spdlog::info("'Space' key pressed - attempting to cancel or reset pre-render.");
 						m_cancel_pre_render.store(true);
 						if (m_pre_render_complete) {
-							glDeleteTextures(1, &m_pre_render_texture);
-							glDeleteFramebuffers(1, &m_pre_render_fbo);
-							if (m_texture_view_shader != nullptr) {
-								delete m_texture_view_shader;
-								m_texture_view_shader = nullptr;
-							}
-							m_pre_render_texture = 0;
-							m_pre_render_fbo = 0;
+							releasePreRender();
 						}
 						m_pre_render_enabled = false;
 						m_pre_render_complete = false;
@@ -271,11 +310,7 @@ void Application::run() {
 						show_main_buttons = true;
 						show_fractal_selection = false;
 						Application::m_currentFractal = FractalType::NONE;
-						if (ourShader != nullptr) {
-							delete ourShader;
-							ourShader = nullptr;
-						}
-						ourShader = new Shader("shaders/background.vert", "shaders/background.frag");
+						ourShader = m_shaders.get("shaders/background.vert", "shaders/background.frag");
 						sub = "Mesmer - Main Menu";
 						title_text_toggle = true;
 						hud_toggle = true;
@@ -289,16 +324,15 @@ void Application::run() {
 					{
 						int mouseX, mouseY;
 						SDL_GetMouseState(&mouseX, &mouseY);
-						double mouse_real_before = (double)(mouseX - screenWidth / 2) / (0.5 * m_mandel_zoom * screenWidth) + m_mandel_center_x;
-						double mouse_imag_before = (double)(screenHeight / 2 - mouseY) / (0.5 * m_mandel_zoom * screenHeight) + m_mandel_center_y;
+						// cursor offset from the centre, the centre itself is left out so the difference survives deep zooms
+						double mouse_offset_x = (double)(mouseX - screenWidth / 2) / (0.5 * screenWidth);
+						double mouse_offset_y = (double)(screenHeight / 2 - mouseY) / (0.5 * screenHeight);
+						double zoom_before = m_mandel_zoom;
 						if (event.wheel.y > 0)
 							m_mandel_zoom *= 1.1;
 						else if (event.wheel.y < 0)
 							m_mandel_zoom /= 1.1;
-						double mouse_real_after = (double)(mouseX - screenWidth / 2) / (0.5 * m_mandel_zoom * screenWidth) + m_mandel_center_x;
-						double mouse_imag_after = (double)(screenHeight / 2 - mouseY) / (0.5 * m_mandel_zoom * screenHeight) + m_mandel_center_y;
-						m_mandel_center_x += mouse_real_before - mouse_real_after;
-						m_mandel_center_y += mouse_imag_before - mouse_imag_after;
+						panMandelbrot(mouse_offset_x / zoom_before - mouse_offset_x / m_mandel_zoom, mouse_offset_y / zoom_before - mouse_offset_y / m_mandel_zoom);
 					}
 					if (event.type == SDL_MOUSEBUTTONDOWN && event.button.button == SDL_BUTTON_LEFT)
 					{
@@ -317,8 +351,7 @@ void Application::run() {
 						double dx = -delta.x / (0.5 * m_mandel_zoom * screenWidth);
 						double dy = delta.y / (0.5 * m_mandel_zoom * screenHeight);
 
-						m_mandel_center_x += dx;
-						m_mandel_center_y += dy;
+						panMandelbrot(dx, dy);
 
 						m_drag_start_pos = current_pos;
 					}
@@ -327,10 +360,7 @@ void Application::run() {
 						show_fractal_selection = false;
 						spdlog::info("'Space' key pressed - toggling main buttons.");
 						Application::m_currentFractal = FractalType::NONE;
-						if (ourShader != nullptr) {
-							delete ourShader;
-						}
-						ourShader = new Shader("shaders/background.vert", "shaders/background.frag");
+						ourShader = m_shaders.get("shaders/background.vert", "shaders/background.frag");
 						spdlog::info("Reverted to background shader.");
 						sub = "Mesmer - Main Menu";
 						title_text_toggle = true;
@@ -387,10 +417,7 @@ void Application::run() {
 						show_fractal_selection = false;
 						spdlog::info("'Space' key pressed - toggling main buttons.");
 						Application::m_currentFractal = FractalType::NONE;
-						if (ourShader != nullptr) {
-							delete ourShader;
-						}
-						ourShader = new Shader("shaders/background.vert", "shaders/background.frag");
+						ourShader = m_shaders.get("shaders/background.vert", "shaders/background.frag");
 						spdlog::info("Reverted to background shader.");
 						sub = "Mesmer - Main Menu";
 						title_text_toggle = true;
@@ -457,10 +484,7 @@ void Application::run() {
 						show_fractal_selection = false;
 						spdlog::info("'Space' key pressed - toggling main buttons.");
 						Application::m_currentFractal = FractalType::NONE;
-						if (ourShader != nullptr) {
-							delete ourShader;
-						}
-						ourShader = new Shader("shaders/background.vert", "shaders/background.frag");
+						ourShader = m_shaders.get("shaders/background.vert", "shaders/background.frag");
 						spdlog::info("Reverted to background shader.");
 						sub = "Mesmer - Main Menu";
 						title_text_toggle = true;
@@ -509,10 +533,7 @@ void Application::run() {
 						show_fractal_selection = false;
 						spdlog::info("'Space' key pressed - toggling main buttons.");
 						Application::m_currentFractal = FractalType::NONE;
-						if (ourShader != nullptr) {
-							delete ourShader;
-						}
-						ourShader = new Shader("shaders/background.vert", "shaders/background.frag");
+						ourShader = m_shaders.get("shaders/background.vert", "shaders/background.frag");
 						spdlog::info("Reverted to background shader.");
 						sub = "Mesmer - Main Menu";
 						title_text_toggle = true;
@@ -562,10 +583,7 @@ void Application::run() {
 						show_fractal_selection = false;
 						spdlog::info("'Space' key pressed - toggling main buttons.");
 						Application::m_currentFractal = FractalType::NONE;
-						if (ourShader != nullptr) {
-							delete ourShader;
-						}
-						ourShader = new Shader("shaders/background.vert", "shaders/background.frag");
+						ourShader = m_shaders.get("shaders/background.vert", "shaders/background.frag");
 						spdlog::info("Reverted to background shader.");
 						sub = "Mesmer - Main Menu";
 						title_text_toggle = true;
@@ -607,10 +625,7 @@ void Application::run() {
 						show_fractal_selection = false;
 						spdlog::info("'Space' key pressed - toggling main buttons.");
 						Application::m_currentFractal = FractalType::NONE;
-						if (ourShader != nullptr) {
-							delete ourShader;
-						}
-						ourShader = new Shader("shaders/background.vert", "shaders/background.frag");
+						ourShader = m_shaders.get("shaders/background.vert", "shaders/background.frag");
 						spdlog::info("Reverted to background shader.");
 						sub = "Mesmer - Main Menu";
 						title_text_toggle = true;
@@ -660,10 +675,7 @@ void Application::run() {
 						show_fractal_selection = false;
 						spdlog::info("'Space' key pressed - toggling main buttons.");
 						Application::m_currentFractal = FractalType::NONE;
-						if (ourShader != nullptr) {
-							delete ourShader;
-						}
-						ourShader = new Shader("shaders/background.vert", "shaders/background.frag");
+						ourShader = m_shaders.get("shaders/background.vert", "shaders/background.frag");
 						spdlog::info("Reverted to background shader.");
 						sub = "Mesmer - Main Menu";
 						title_text_toggle = true;
@@ -713,10 +725,7 @@ void Application::run() {
 						show_fractal_selection = false;
 						spdlog::info("'Space' key pressed - toggling main buttons.");
 						Application::m_currentFractal = FractalType::NONE;
-						if (ourShader != nullptr) {
-							delete ourShader;
-						}
-						ourShader = new Shader("shaders/background.vert", "shaders/background.frag");
+						ourShader = m_shaders.get("shaders/background.vert", "shaders/background.frag");
 						spdlog::info("Reverted to background shader.");
 						sub = "Mesmer - Main Menu";
 						title_text_toggle = true;
@@ -766,10 +775,7 @@ void Application::run() {
 						show_fractal_selection = false;
 						spdlog::info("'Space' key pressed - toggling main buttons.");
 						Application::m_currentFractal = FractalType::NONE;
-						if (ourShader != nullptr) {
-							delete ourShader;
-						}
-						ourShader = new Shader("shaders/background.vert", "shaders/background.frag");
+						ourShader = m_shaders.get("shaders/background.vert", "shaders/background.frag");
 						spdlog::info("Reverted to background shader.");
 						sub = "Mesmer - Main Menu";
 						title_text_toggle = true;
@@ -819,10 +825,7 @@ void Application::run() {
 						show_fractal_selection = false;
 						spdlog::info("'Space' key pressed - toggling main buttons.");
 						Application::m_currentFractal = FractalType::NONE;
-						if (ourShader != nullptr) {
-							delete ourShader;
-						}
-						ourShader = new Shader("shaders/background.vert", "shaders/background.frag");
+						ourShader = m_shaders.get("shaders/background.vert", "shaders/background.frag");
 						spdlog::info("Reverted to background shader.");
 						sub = "Mesmer - Main Menu";
 						title_text_toggle = true;
@@ -838,6 +841,8 @@ void Application::run() {
 			}
 			
 
+			m_profiler.endPass(events_pass);
+			const int imgui_build_pass = m_profiler.beginPass("ImGui Build", false);
 			ImGui_ImplOpenGL3_NewFrame();
 			ImGui_ImplSDL2_NewFrame();
 			ImGui::NewFrame();
@@ -866,6 +871,102 @@ void Application::run() {
 
 					ImGui::Separator();
 					ImGui::SliderFloat("Color Density", &m_color_density, 0.01f, 0.5f, "%.3f");
+					const char* color_style_names[] = { "Smooth", "Distance Shaded", "Binary Decomposition" };
+					ImGui::Combo("Pre-Render Coloring", &m_color_style, color_style_names, IM_ARRAYSIZE(color_style_names));
+					if (ImGui::IsItemHovered()) {
+						ImGui::SetTooltip("Pre-renders keep the raw iteration data, so coloring, density and palette edits apply without re-rendering.\nDistance estimates (Mandelbrot, Julia) and orbit angles come from the GPU kernels only.");
+					}
+					ImGui::SliderFloat("Palette Cycling Speed", &m_palette_cycle_speed, 0.0f, 2.0f, "%.2f");
+					ImGui::Checkbox("Pre-Render Detail Pages", &m_virtual_texture_enabled);
+					if (ImGui::IsItemHovered()) {
+						ImGui::SetTooltip("Zooming past the pre-render's resolution renders the visible part again at the screen's resolution,\nin 256x256 pages kept in a fixed cache. Pages wait while an export is running.");
+					}
+					if (m_virtual_texture_enabled && m_virtual_texture.active()) {
+						ImGui::Text("Detail level %d: %d pages resident, %d queued", m_virtual_texture.level(), m_virtual_texture.residentPages(), m_virtual_texture.queuedPages());
+					}
+					else if (m_virtual_texture_enabled && m_pre_render_complete && m_pre_render_perturbed.load()) {
+						ImGui::TextWrapped("No detail pages: this pre-render was iterated against a reference orbit, the page kernels have no perturbation path.");
+					}
+					if (m_pre_render_complete) {
+						const int kept_iterations = m_pre_render_resume_iterations.load();
+						const bool resuming = m_pre_render_resuming.load();
+						// the pre-render settings are hidden while a fractal is shown, the limit to continue to is raised here
+						ImGui::BeginDisabled(kept_iterations == 0 || resuming);
+						ImGui::SliderInt("Pre-Render Iteration Limit", &m_pre_render_iterations, 100, 100000, "%d", ImGuiSliderFlags_Logarithmic);
+						ImGui::EndDisabled();
+						if (ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenDisabled)) {
+							ImGui::SetTooltip("Same limit as \"Pre-Render Iterations\", raise it above the kept orbits' limit and continue.");
+						}
+						ImGui::BeginDisabled(kept_iterations == 0 || resuming || m_pre_render_iterations <= kept_iterations);
+						if (ImGui::Button("Continue Iterations")) {
+							if (m_pre_render_resume_count.load() == 0) {
+								// every pixel settled below the old limit, nothing changes above it
+								m_pre_render_resume_iterations.store(m_pre_render_iterations);
+							}
+							else {
+								m_pre_render_resuming.store(true);
+								if (m_pre_render_thread.joinable()) m_pre_render_thread.join();
+								m_pre_render_thread = std::thread(&Application::preRenderResumeWorker, this);
+								m_pre_render_thread.detach();
+							}
+						}
+						ImGui::EndDisabled();
+						if (ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenDisabled)) {
+							ImGui::SetTooltip("Only pre-renders made with the compute kernel and Stream Compaction on (Mandelbrot or Julia, GPU tiles)\nkeep the orbits that reached the iteration limit. Raising the limit and continuing only iterates those pixels,\nfrom where they stopped.");
+						}
+						ImGui::SameLine();
+						if (resuming) {
+							ImGui::Text("continuing %d orbits...", m_pre_render_resume_count.load());
+						}
+						else if (kept_iterations > 0) {
+							ImGui::Text("%d orbits kept at %d iterations", m_pre_render_resume_count.load(), kept_iterations);
+						}
+						else {
+							ImGui::TextUnformatted("nothing kept, needs the compute kernel with Stream Compaction");
+						}
+					}
+					ImGui::Separator();
+					int precision = (int)m_shader_precision;
+					const char* precision_names[] = { "Auto", "FP64 (native doubles)", "DF64 (float-float)" };
+					if (ImGui::Combo("Shader Precision", &precision, precision_names, IM_ARRAYSIZE(precision_names))) {
+						m_shader_precision = (ShaderPrecision)precision;
+					}
+					if (ImGui::IsItemHovered()) {
+						if (m_precision_benchmark.valid) {
+							ImGui::SetTooltip("Mandelbrot, Burning Ship, Tricorn and Phoenix can iterate in df64 (~48 bit mantissa, fp32 instructions).\nStartup benchmark: fp64 %.2f ms, df64 %.2f ms, Auto picks %s.\nViews deeper than df64 can resolve always use fp64.",
+								m_precision_benchmark.fp64_ms, m_precision_benchmark.df64_ms, m_precision_benchmark.df64Faster() ? "df64" : "fp64");
+						}
+						else {
+							ImGui::SetTooltip("The startup benchmark did not run, Auto keeps the fp64 kernels.");
+						}
+					}
+					ImGui::Separator();
+					ImGui::Checkbox("Progressive Rendering", &m_progressive_rendering);
+					if (ImGui::IsItemHovered()) {
+						ImGui::SetTooltip("While the view changes it is drawn at reduced resolution within the frame budget,\nthen refined to full resolution over the following frames.");
+					}
+					if (m_progressive_rendering) {
+						ImGui::Checkbox("Budget From Frame Rate", &m_budget_from_frame_rate);
+						if (ImGui::IsItemHovered()) {
+							ImGui::SetTooltip("Sizes the frame budget from max_fps in settings.mesmer (or the display refresh rate\nwhen vsync caps lower), leaving the rest of the frame to the interface.");
+						}
+						ImGui::BeginDisabled(m_budget_from_frame_rate);
+						ImGui::SliderFloat("Frame Budget (ms)", &m_progressive_budget_ms, 2.0f, 33.0f, "%.1f");
+						ImGui::EndDisabled();
+						if (ImGui::Checkbox("Resume Iterations", &m_resume_iterations)) {
+							// the strips already drawn did not keep their orbits
+							m_progressive.invalidate();
+						}
+						if (ImGui::IsItemHovered()) {
+							ImGui::SetTooltip("Mandelbrot and Julia (FP64) keep the orbit of every pixel that reached the limit.\nRaising the iterations on an unchanged view continues those pixels instead of drawing the frame again.");
+						}
+						if (m_progressive.complete()) {
+							ImGui::Text("Live view: full resolution (%.1f ms per full frame)", m_progressive.fullFrameMs());
+						}
+						else {
+							ImGui::Text("Live view: 1/%d scale, %.0f%% refined", m_progressive.scale(), m_progressive.progress() * 100.0f);
+						}
+					}
 					ImGui::Separator();
 
 					ImGui::Checkbox("Apply Common Color Palette to All Fractals", &m_apply_common_color_palette);
@@ -902,9 +1003,31 @@ void Application::run() {
 						ImGui::SliderFloat3("Phase (d)", (float*)&m_palette_mandelbrot_d, 0.0f, 1.0f);
 						ImGui::Separator();
 
-						ImGui::InputDouble("Zoom", &m_mandel_zoom, 0.1, 0.0, "%.8f");
-						ImGui::InputDouble("Center X", &m_mandel_center_x, 0.01, 0.0, "%.8f");
-						ImGui::InputDouble("Center Y", &m_mandel_center_y, 0.01, 0.0, "%.8f");
+						ImGui::InputDouble("Zoom", &m_mandel_zoom, 0.1, 0.0, m_mandel_zoom < 1.0e6 ? "%.8f" : "%.6e");
+						// the centre is edited as decimal text so deep zoom coordinates keep every digit
+						const int center_digits = std::clamp((int)std::log10(std::max(m_mandel_zoom, 1.0)) + 10, 10, 400);
+						std::snprintf(m_mandel_center_x_text, sizeof(m_mandel_center_x_text), "%s", m_mandel_deep_center_x.toString(center_digits).c_str());
+						std::snprintf(m_mandel_center_y_text, sizeof(m_mandel_center_y_text), "%s", m_mandel_deep_center_y.toString(center_digits).c_str());
+						BigFloat edited_center;
+						if (ImGui::InputText("Center X", m_mandel_center_x_text, sizeof(m_mandel_center_x_text), ImGuiInputTextFlags_EnterReturnsTrue | ImGuiInputTextFlags_CharsScientific)) {
+							if (BigFloat::fromString(m_mandel_center_x_text, edited_center)) {
+								m_mandel_deep_center_x = edited_center;
+								m_mandel_center_x = m_mandel_center_mirror_x = edited_center.toDouble();
+							}
+						}
+						if (ImGui::InputText("Center Y", m_mandel_center_y_text, sizeof(m_mandel_center_y_text), ImGuiInputTextFlags_EnterReturnsTrue | ImGuiInputTextFlags_CharsScientific)) {
+							if (BigFloat::fromString(m_mandel_center_y_text, edited_center)) {
+								m_mandel_deep_center_y = edited_center;
+								m_mandel_center_y = m_mandel_center_mirror_y = edited_center.toDouble();
+							}
+						}
+						if (m_mandel_zoom >= DEEP_ZOOM_THRESHOLD) {
+							ImGui::TextWrapped("Deep zoom: perturbation from a %d iteration reference orbit.", m_reference_orbit ? m_reference_orbit->length() - 1 : 0);
+							ImGui::SliderInt("Deep Zoom Iterations", &m_mandel_deep_iterations, 1000, 10000000, "%d", ImGuiSliderFlags_Logarithmic);
+							if (ImGui::IsItemHovered()) {
+								ImGui::SetTooltip("Minimum iteration count while zoomed past %.0e, bilinear approximation skips most of them.", DEEP_ZOOM_THRESHOLD);
+							}
+						}
 
 						if (m_adaptive_iterations) {
 							ImGui::BeginDisabled();
@@ -927,6 +1050,7 @@ void Application::run() {
 							m_mandel_center_x = -0.75;
 							m_mandel_center_y = 0.0;
 							m_mandel_max_iterations = 200;
+							syncMandelbrotCenter();
 						}
 					}
 					else if (m_currentFractal == FractalType::JULIA)
@@ -1318,6 +1442,14 @@ void Application::run() {
 							ImGui::InputDouble("Pre-Render Zoom", &m_pre_render_zoom_threshold, 0.1, 0.0, "%.8f");
 							ImGui::InputDouble("Pre-Render Center X", &m_pre_render_center_x, 0.01, 0.0, "%.8f");
 							ImGui::InputDouble("Pre-Render Center Y", &m_pre_render_center_y, 0.01, 0.0, "%.8f");
+							if (ImGui::Button("Use Live View")) {
+								m_pre_render_center_x = m_mandel_center_x;
+								m_pre_render_center_y = m_mandel_center_y;
+								m_pre_render_zoom_threshold = m_mandel_zoom;
+							}
+							if (ImGui::IsItemHovered()) {
+								ImGui::SetTooltip("Takes the centre and zoom of the live view. Deep Mandelbrot pre-renders of it keep\nevery digit of the centre for the reference orbit, not just the doubles shown here.");
+							}
 							ImGui::TextWrapped("Adjust the settings in the fractal display settings tab to change color and color density");
 							ImGui::Separator();
 							ImGui::TextWrapped("Fractal Specific Parameter Customization");
@@ -1332,6 +1464,47 @@ void Application::run() {
 							ImGui::Separator();
 							ImGui::TextWrapped("Pre-Render Resolution Customization");
 							ImGui::SliderInt("Pre-Render Texture Resolution", &tex_res, 256, m_pre_render_highest_supported_resolution);
+							// the worker reads the limit while it continues a render
+							ImGui::BeginDisabled(m_pre_render_resuming.load());
+							ImGui::SliderInt("Pre-Render Iterations", &m_pre_render_iterations, 100, 100000, "%d", ImGuiSliderFlags_Logarithmic);
+							ImGui::EndDisabled();
+							if (ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenDisabled)) {
+								ImGui::SetTooltip("Iteration limit of the pre-render and its detail pages.\nA finished compacted render can be continued to a higher limit from the fractal display settings.");
+							}
+							ImGui::Separator();
+							ImGui::TextWrapped("Pre-Render Backend");
+							int backend = (int)m_pre_render_backend;
+							const char* backend_names[] = { "GPU (fragment shaders)", "CPU (multithreaded SIMD)", "Hybrid (GPU + CPU)" };
+							if (ImGui::Combo("Backend", &backend, backend_names, IM_ARRAYSIZE(backend_names))) {
+								m_pre_render_backend = (PreRenderBackend)backend;
+							}
+							if (ImGui::IsItemHovered()) {
+								ImGui::SetTooltip("The CPU backend renders Mandelbrot and Julia with %s kernels on %u threads, other fractals use the GPU.\nHybrid lets the GPU and the CPU threads take tiles from the same queue.",
+									CpuRenderer::simdLevelName(m_cpu_simd_level), std::max(1u, std::thread::hardware_concurrency()));
+							}
+							ImGui::Checkbox("Compute Kernel: Mandelbrot", &m_compute_kernel_mandelbrot);
+							ImGui::SameLine();
+							ImGui::Checkbox("Julia##compute_kernel", &m_compute_kernel_julia);
+							if (ImGui::IsItemHovered()) {
+								ImGui::SetTooltip("GPU tiles of these fractals run as a compute shader with persistent workgroups that take pixels from a shared counter,\nso lanes do not idle behind a slow interior pixel of their warp. Deep views full of interior gain the most. FP64 only.");
+							}
+							ImGui::Checkbox("Stream Compaction", &m_pre_render_compaction);
+							if (ImGui::IsItemHovered()) {
+								ImGui::SetTooltip("Mandelbrot and Julia iterate in chunks, the first one this many iterations long and every further one twice the last.\nOnly the pixels still running after a chunk are packed into the next, on the CPU SIMD lanes and in the compute kernels.");
+							}
+							if (m_pre_render_compaction) {
+								ImGui::SameLine();
+								ImGui::SetNextItemWidth(120.0f);
+								ImGui::SliderInt("First Chunk", &m_pre_render_compaction_chunk, 16, 4096, "%d", ImGuiSliderFlags_Logarithmic);
+							}
+							int subdivision = (int)m_pre_render_subdivision;
+							const char* subdivision_names[] = { "Off (production)", "Exact (production)", "Interior Fill (fast)", "Guess (preview)" };
+							if (ImGui::Combo("CPU Subdivision", &subdivision, subdivision_names, IM_ARRAYSIZE(subdivision_names))) {
+								m_pre_render_subdivision = (CpuSubdivision)subdivision;
+							}
+							if (ImGui::IsItemHovered()) {
+								ImGui::SetTooltip("Mariani-Silver subdivision for the CPU tiles: rectangle borders are iterated first and uniform rectangles are filled.\nExact only skips rectangles proven to lie in the main cardioid or period-2 bulb, its output matches Off.\nInterior Fill fills any rectangle bounded by set pixels, Guess also fills flat exterior bands and interpolates their colouring.\nBoth can paint over filaments thinner than a pixel.");
+							}
 							ImGui::Separator();
 							ImGui::Checkbox("Use Pre-Render Settings", &m_use_pre_render_params);
 							ImGui::Separator();
@@ -1344,6 +1517,42 @@ void Application::run() {
 						}
 					}
 				}
+				// export of the pre-render view, the size is free of the texture limit the viewer has
+				const ExportState export_state = m_export_state.load();
+				if ((m_pre_render_complete || export_state == ExportState::RUNNING) && ImGui::CollapsingHeader("Export"))
+				{
+					ImGui::BeginDisabled(export_state == ExportState::RUNNING);
+					ImGui::InputInt("Export Resolution", &m_export_resolution, EXPORT_TILE_SIZE * 16, EXPORT_TILE_SIZE * 64);
+					m_export_resolution = std::clamp(m_export_resolution, EXPORT_TILE_SIZE, EXPORT_MAX_RESOLUTION);
+					if (ImGui::IsItemHovered()) {
+						ImGui::SetTooltip("Square image of the pre-render view, rendered in %d pixel tiles.\nTiles are rendered, read back and written a row at a time, so only the disk limits the size.", EXPORT_TILE_SIZE);
+					}
+					ImGui::InputText("Export File", m_export_path, IM_ARRAYSIZE(m_export_path));
+					const double export_gb = (double)m_export_resolution * m_export_resolution * 4.0 / (1024.0 * 1024.0 * 1024.0);
+					ImGui::Text("%.2f GB uncompressed", export_gb);
+					if (ImGui::Button("Export PNG")) {
+						startExport();
+					}
+					ImGui::EndDisabled();
+					if (export_state == ExportState::RUNNING) {
+						const int export_total = std::max(1, m_export_tiles_total.load());
+						const int export_done = std::min(m_export_tiles_done.load(), export_total);
+						ImGui::ProgressBar((float)export_done / (float)export_total, ImVec2(-1.0f, 0.0f),
+							(std::to_string(export_done) + " / " + std::to_string(export_total) + " tiles").c_str());
+						if (ImGui::Button("Cancel Export")) {
+							m_cancel_export.store(true);
+						}
+					}
+					else if (export_state == ExportState::DONE) {
+						ImGui::TextColored(ImVec4(0.0f, 1.0f, 0.0f, 1.0f), "Exported to %s", m_export_path);
+					}
+					else if (export_state == ExportState::FAILED) {
+						ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "Export failed, see the log");
+					}
+					else if (export_state == ExportState::CANCELLED) {
+						ImGui::TextColored(ImVec4(1.0f, 1.0f, 0.0f, 1.0f), "Export cancelled");
+					}
+				}
 				ImGui::End();
 			}
 
@@ -1431,12 +1640,11 @@ void Application::run() {
 				if (ImGui::Button("Mandelbrot", ImVec2(button_width, 80))) {
 					spdlog::info("'Mandelbrot' button clicked!");
 					m_currentFractal = FractalType::MANDELBROT;
-					if (ourShader != nullptr) delete ourShader;
 					if (m_pre_render_enabled) {
-						ourShader = new Shader("shaders/mandelbrot.vert", "shaders/mandelbrot.frag");
+						ourShader = loadFractalShader("shaders/mandelbrot.vert", "shaders/mandelbrot.frag");
 						spdlog::info("Launching pre-render worker for Mandelbrot...");
 						m_is_loading = true;
-						m_loading_shader = new Shader("shaders/simple.vert", "shaders/loading_screen.frag");
+						m_loading_shader = m_shaders.get("shaders/simple.vert", "shaders/loading_screen.frag");
 						if (m_pre_render_thread.joinable()) m_pre_render_thread.join();
 						m_worker_finished_submission.store(false);
 						m_pre_render_thread = std::thread(&Application::preRenderWorker, this);
@@ -1444,7 +1652,7 @@ void Application::run() {
 						hud_toggle = false;
 					}
 					else {
-						ourShader = new Shader("shaders/mandelbrot.vert", "shaders/mandelbrot.frag");
+						ourShader = loadFractalShader("shaders/mandelbrot.vert", "shaders/mandelbrot.frag");
 						spdlog::info("Loaded Mandelbrot shader for real-time rendering.");
 					}
 
@@ -1464,12 +1672,11 @@ void Application::run() {
 				if (ImGui::Button("Julia", ImVec2(button_width, 80))) {
 					spdlog::info("'Julia' button clicked!");
 					m_currentFractal = FractalType::JULIA;
-					if (ourShader != nullptr) delete ourShader;
 					if (m_pre_render_enabled) {
-						ourShader = new Shader("shaders/julia.vert", "shaders/julia.frag");
+						ourShader = m_shaders.get("shaders/julia.vert", "shaders/julia.frag");
 						spdlog::info("Launching pre-render worker for Julia...");
 						m_is_loading = true;
-						m_loading_shader = new Shader("shaders/simple.vert", "shaders/loading_screen.frag");
+						m_loading_shader = m_shaders.get("shaders/simple.vert", "shaders/loading_screen.frag");
 						if (m_pre_render_thread.joinable()) m_pre_render_thread.join();
 						m_worker_finished_submission.store(false);
 						m_pre_render_thread = std::thread(&Application::preRenderWorker, this);
@@ -1478,7 +1685,7 @@ void Application::run() {
 					}
 					else
 					{
-						ourShader = new Shader("shaders/julia.vert", "shaders/julia.frag");
+						ourShader = m_shaders.get("shaders/julia.vert", "shaders/julia.frag");
 						spdlog::info("Loaded Julia shader for real-time rendering.");
 					}
 
@@ -1500,14 +1707,13 @@ void Application::run() {
 				if (ImGui::Button("Burning Ship", ImVec2(button_width, 80))) {
 					spdlog::info("'Burning Ship' button clicked!");
 					m_currentFractal = FractalType::BURNING_SHIP;
-					if (ourShader != nullptr) delete ourShader;
 
 					if (m_pre_render_enabled)
 					{
-						ourShader = new Shader("shaders/burningship.vert", "shaders/burningship.frag");
+						ourShader = loadFractalShader("shaders/burningship.vert", "shaders/burningship.frag");
 						spdlog::info("Launching pre-render worker for Burning Ship...");
 						m_is_loading = true;
-						m_loading_shader = new Shader("shaders/simple.vert", "shaders/loading_screen.frag");
+						m_loading_shader = m_shaders.get("shaders/simple.vert", "shaders/loading_screen.frag");
 						if (m_pre_render_thread.joinable()) m_pre_render_thread.join();
 						m_worker_finished_submission.store(false);
 						m_pre_render_thread = std::thread(&Application::preRenderWorker, this);
@@ -1516,7 +1722,7 @@ void Application::run() {
 					}
 					else 
 					{
-						ourShader = new Shader("shaders/burningship.vert", "shaders/burningship.frag");
+						ourShader = loadFractalShader("shaders/burningship.vert", "shaders/burningship.frag");
 						spdlog::info("Loaded Burning Ship shader.");
 					}
 
@@ -1541,13 +1747,12 @@ void Application::run() {
 				if (ImGui::Button("Tricorn", ImVec2(button_width, 80))) {
 					spdlog::info("'Tricorn' button clicked!");
 					m_currentFractal = FractalType::TRICORN;
-					if (ourShader != nullptr) delete ourShader;
 
 					if (m_pre_render_enabled) {
-						ourShader = new Shader("shaders/tricorn.vert", "shaders/tricorn.frag");
+						ourShader = loadFractalShader("shaders/tricorn.vert", "shaders/tricorn.frag");
 						spdlog::info("Launching pre-render worker for Tricorn...");
 						m_is_loading = true;
-						m_loading_shader = new Shader("shaders/simple.vert", "shaders/loading_screen.frag");
+						m_loading_shader = m_shaders.get("shaders/simple.vert", "shaders/loading_screen.frag");
 						if (m_pre_render_thread.joinable()) m_pre_render_thread.join();
 						m_worker_finished_submission.store(false);
 						m_pre_render_thread = std::thread(&Application::preRenderWorker, this);
@@ -1555,7 +1760,7 @@ void Application::run() {
 						hud_toggle = false;
 					}
 					else {
-						ourShader = new Shader("shaders/tricorn.vert", "shaders/tricorn.frag");
+						ourShader = loadFractalShader("shaders/tricorn.vert", "shaders/tricorn.frag");
 						spdlog::info("Loaded Tricorn shader.");
 					}
 
@@ -1580,13 +1785,12 @@ void Application::run() {
 				if (ImGui::Button("Phoenix", ImVec2(button_width, 80))) {
 					spdlog::info("'Phoenix' button clicked!");
 					m_currentFractal = FractalType::PHOENIX;
-					if (ourShader != nullptr) delete ourShader;
 
 					if (m_pre_render_enabled) {
-						ourShader = new Shader("shaders/phoenix.vert", "shaders/phoenix.frag");
+						ourShader = loadFractalShader("shaders/phoenix.vert", "shaders/phoenix.frag");
 						spdlog::info("Launching pre-render worker for Phoenix...");
 						m_is_loading = true;
-						m_loading_shader = new Shader("shaders/simple.vert", "shaders/loading_screen.frag");
+						m_loading_shader = m_shaders.get("shaders/simple.vert", "shaders/loading_screen.frag");
 						if (m_pre_render_thread.joinable()) m_pre_render_thread.join();
 						m_worker_finished_submission.store(false);
 						m_pre_render_thread = std::thread(&Application::preRenderWorker, this);
@@ -1594,7 +1798,7 @@ void Application::run() {
 						hud_toggle = false;
 					}
 					else {
-						ourShader = new Shader("shaders/phoenix.vert", "shaders/phoenix.frag");
+						ourShader = loadFractalShader("shaders/phoenix.vert", "shaders/phoenix.frag");
 						spdlog::info("Loaded Phoenix shader.");
 					}
 
@@ -1617,13 +1821,12 @@ void Application::run() {
 				if (ImGui::Button("Lyapunov", ImVec2(button_width, 80))) {
 					spdlog::info("'Lyapunov' button clicked!");
 					m_currentFractal = FractalType::LYAPUNOV;
-					if (ourShader != nullptr) delete ourShader;
 
 					if (m_pre_render_enabled) {
-						ourShader = new Shader("shaders/lyapunov.vert", "shaders/lyapunov.frag");
+						ourShader = m_shaders.get("shaders/lyapunov.vert", "shaders/lyapunov.frag");
 						spdlog::info("Launching pre-render worker for Lyapunov...");
 						m_is_loading = true;
-						m_loading_shader = new Shader("shaders/simple.vert", "shaders/loading_screen.frag");
+						m_loading_shader = m_shaders.get("shaders/simple.vert", "shaders/loading_screen.frag");
 						if (m_pre_render_thread.joinable()) m_pre_render_thread.join();
 						m_worker_finished_submission.store(false);
 						m_pre_render_thread = std::thread(&Application::preRenderWorker, this);
@@ -1631,7 +1834,7 @@ void Application::run() {
 						hud_toggle = false;
 					}
 					else {
-						ourShader = new Shader("shaders/lyapunov.vert", "shaders/lyapunov.frag");
+						ourShader = m_shaders.get("shaders/lyapunov.vert", "shaders/lyapunov.frag");
 						spdlog::info("Loaded Lyapunov shader.");
 					}
 
@@ -1658,13 +1861,12 @@ void Application::run() {
 				if (ImGui::Button("Newton", ImVec2(button_width, 80))) {
 					spdlog::info("'Newton' button clicked!");
 					m_currentFractal = FractalType::NEWTON;
-					if (ourShader != nullptr) delete ourShader;
 
 					if (m_pre_render_enabled) {
-						ourShader = new Shader("shaders/newton.vert", "shaders/newton.frag");
+						ourShader = m_shaders.get("shaders/newton.vert", "shaders/newton.frag");
 						spdlog::info("Launching pre-render worker for Newton...");
 						m_is_loading = true;
-						m_loading_shader = new Shader("shaders/simple.vert", "shaders/loading_screen.frag");
+						m_loading_shader = m_shaders.get("shaders/simple.vert", "shaders/loading_screen.frag");
 						if (m_pre_render_thread.joinable()) m_pre_render_thread.join();
 						m_worker_finished_submission.store(false);
 						m_pre_render_thread = std::thread(&Application::preRenderWorker, this);
@@ -1672,7 +1874,7 @@ void Application::run() {
 						hud_toggle = false;
 					}
 					else {
-						ourShader = new Shader("shaders/newton.vert", "shaders/newton.frag");
+						ourShader = m_shaders.get("shaders/newton.vert", "shaders/newton.frag");
 						spdlog::info("Loaded Newton shader.");
 					}
 
@@ -1695,13 +1897,12 @@ void Application::run() {
 				if (ImGui::Button("Multibrot", ImVec2(button_width, 80))) {
 					spdlog::info("'Multibrot' button clicked!");
 					m_currentFractal = FractalType::MULTIBROT;
-					if (ourShader != nullptr) delete ourShader;
 
 					if (m_pre_render_enabled) {
-						ourShader = new Shader("shaders/multibrot.vert", "shaders/multibrot.frag");
+						ourShader = m_shaders.get("shaders/multibrot.vert", "shaders/multibrot.frag");
 						spdlog::info("Launching pre-render worker for Multibrot...");
 						m_is_loading = true;
-						m_loading_shader = new Shader("shaders/simple.vert", "shaders/loading_screen.frag");
+						m_loading_shader = m_shaders.get("shaders/simple.vert", "shaders/loading_screen.frag");
 						if (m_pre_render_thread.joinable()) m_pre_render_thread.join();
 						m_worker_finished_submission.store(false);
 						m_pre_render_thread = std::thread(&Application::preRenderWorker, this);
@@ -1709,7 +1910,7 @@ void Application::run() {
 						hud_toggle = false;
 					}
 					else {
-						ourShader = new Shader("shaders/multibrot.vert", "shaders/multibrot.frag");
+						ourShader = m_shaders.get("shaders/multibrot.vert", "shaders/multibrot.frag");
 						spdlog::info("Loaded Multibrot shader.");
 					}
 
@@ -1734,13 +1935,12 @@ void Application::run() {
 				if (ImGui::Button("Nova", ImVec2(button_width, 80))) {
 					spdlog::info("'Nova' button clicked!");
 					m_currentFractal = FractalType::NOVA;
-					if (ourShader != nullptr) delete ourShader;
 
 					if (m_pre_render_enabled) {
-						ourShader = new Shader("shaders/nova.vert", "shaders/nova.frag");
+						ourShader = m_shaders.get("shaders/nova.vert", "shaders/nova.frag");
 						spdlog::info("Launching pre-render worker for Nova...");
 						m_is_loading = true;
-						m_loading_shader = new Shader("shaders/simple.vert", "shaders/loading_screen.frag");
+						m_loading_shader = m_shaders.get("shaders/simple.vert", "shaders/loading_screen.frag");
 						if (m_pre_render_thread.joinable()) m_pre_render_thread.join();
 						m_worker_finished_submission.store(false);
 						m_pre_render_thread = std::thread(&Application::preRenderWorker, this);
@@ -1748,7 +1948,7 @@ void Application::run() {
 						hud_toggle = false;
 					}
 					else {
-						ourShader = new Shader("shaders/nova.vert", "shaders/nova.frag");
+						ourShader = m_shaders.get("shaders/nova.vert", "shaders/nova.frag");
 						spdlog::info("Loaded Nova shader.");
 					}
 
@@ -1773,13 +1973,12 @@ void Application::run() {
 				if (ImGui::Button("Spider", ImVec2(button_width, 80))) {
 					spdlog::info("'Spider' button clicked!");
 					m_currentFractal = FractalType::SPIDER;
-					if (ourShader != nullptr) delete ourShader;
 
 					if (m_pre_render_enabled) {
-						ourShader = new Shader("shaders/spider.vert", "shaders/spider.frag");
+						ourShader = m_shaders.get("shaders/spider.vert", "shaders/spider.frag");
 						spdlog::info("Launching pre-render worker for Spider...");
 						m_is_loading = true;
-						m_loading_shader = new Shader("shaders/simple.vert", "shaders/loading_screen.frag");
+						m_loading_shader = m_shaders.get("shaders/simple.vert", "shaders/loading_screen.frag");
 						if (m_pre_render_thread.joinable()) m_pre_render_thread.join();
 						m_worker_finished_submission.store(false);
 						m_pre_render_thread = std::thread(&Application::preRenderWorker, this);
@@ -1787,7 +1986,7 @@ void Application::run() {
 						hud_toggle = false;
 					}
 					else {
-						ourShader = new Shader("shaders/spider.vert", "shaders/spider.frag");
+						ourShader = m_shaders.get("shaders/spider.vert", "shaders/spider.frag");
 						spdlog::info("Loaded Spider shader.");
 					}
 
@@ -1861,6 +2060,10 @@ void Application::run() {
 			if (show_demo_window) {
 				ImGui::ShowDemoWindow(&show_demo_window);
 			}
+			if (m_show_profiler) {
+				m_profiler.drawOverlay(&m_show_profiler);
+			}
+			m_profiler.endPass(imgui_build_pass);
 
 			int drawable_w, drawable_h;
 			SDL_GL_GetDrawableSize(window, &drawable_w, &drawable_h);
@@ -1877,28 +2080,51 @@ void Application::run() {
 				glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
 				ImDrawList* draw_list = ImGui::GetBackgroundDrawList();
 				addTextWithStroke(draw_list, m_font_large, 48.0f, ImVec2((float)screenWidth / 2 - 250.0f, (float)screenHeight / 2 - 80.0f), IM_COL32_WHITE, IM_COL32_BLACK, 2.0f, "Rendering, please wait...");
+				const int tiles_total = m_pre_render_tiles_total.load();
+				if (tiles_total > 0) {
+					const int tiles_done = std::min(m_pre_render_tiles_done.load(), tiles_total);
+					std::string progress_text = std::to_string(tiles_done) + " / " + std::to_string(tiles_total) + " tiles (" + std::to_string(tiles_done * 100 / tiles_total) + "%)";
+					addTextWithStroke(draw_list, m_font_large, 24.0f, ImVec2((float)screenWidth / 2 - 150.0f, (float)screenHeight / 2 - 20.0f), IM_COL32_WHITE, IM_COL32_BLACK, 1.0f, progress_text.c_str());
+				}
 
 				if (m_worker_finished_submission && m_pre_render_fence) {
 					GLenum wait_result = glClientWaitSync(m_pre_render_fence, 0, 0);
 					if (wait_result == GL_ALREADY_SIGNALED || wait_result == GL_CONDITION_SATISFIED) {
 						spdlog::info("Main thread: Fence signaled! GPU render is complete.");
 
+						// the kernels only wrote the g-buffer, the first colouring pass fills the texture the viewer samples
+						m_pre_render_colorized = false;
+						colorizePreRender();
 						glBindTexture(GL_TEXTURE_2D, m_pre_render_texture);
-						glGenerateMipmap(GL_TEXTURE_2D);
 						glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
 						glDeleteSync(m_pre_render_fence);
 						m_pre_render_fence = nullptr;
 
-						m_texture_view_shader = new Shader("shaders/simple.vert", "shaders/texture_view.frag");
+						m_texture_view_shader = m_shaders.get("shaders/simple.vert", "shaders/texture_view.frag");
+						createVirtualTexture();
 						m_pre_render_complete = true;
 						m_is_loading = false;
 
-						delete m_loading_shader; m_loading_shader = nullptr;
+						m_loading_shader = nullptr;
 					}
 				}
 			}
 			else if (m_pre_render_complete) {
+				Profiler::Scope profile_pass(m_profiler, "Texture View", true);
 				hud_toggle = true;
+				if (!m_pre_render_resuming.load() && m_pre_render_resume_fence) {
+					const GLenum wait_result = glClientWaitSync(m_pre_render_resume_fence, 0, 0);
+					if (wait_result == GL_ALREADY_SIGNALED || wait_result == GL_CONDITION_SATISFIED) {
+						glDeleteSync(m_pre_render_resume_fence);
+						m_pre_render_resume_fence = nullptr;
+						// the g-buffer holds the continued pixels, the detail pages were rendered at the old limit
+						m_pre_render_colorized = false;
+						m_virtual_texture.release();
+						createVirtualTexture();
+					}
+				}
+				// palette edits and cycling only rerun the colouring pass, never the kernels
+				colorizePreRender();
 				glViewport(0, 0, drawable_w, drawable_h);
 				glClearColor(clear_color.x* clear_color.w, clear_color.y* clear_color.w, clear_color.z* clear_color.w, clear_color.w);
 				glClear(GL_COLOR_BUFFER_BIT);
@@ -1907,6 +2133,15 @@ void Application::run() {
 				m_texture_view_shader->setVec2("iResolution", (float)drawable_w, (float)drawable_h);
 				m_texture_view_shader->setDVec2("u_center", m_view_center_x, m_view_center_y);
 				m_texture_view_shader->setDouble("u_zoom", m_view_zoom);
+				// past the texture's own resolution the finest resident detail pages are coloured in place
+				if (m_virtual_texture_enabled) {
+					m_virtual_texture.update(m_view_center_x, m_view_center_y, m_view_zoom, drawable_w, drawable_h);
+					setColorizeUniforms(m_texture_view_shader, colorizeState());
+					m_virtual_texture.bind(m_texture_view_shader, 1, 2);
+				}
+				else {
+					m_texture_view_shader->setInt("u_vt_level", 0);
+				}
 
 				glActiveTexture(GL_TEXTURE0);
 				glBindTexture(GL_TEXTURE_2D, m_pre_render_texture);
@@ -1915,10 +2150,17 @@ void Application::run() {
 				glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
 			}
 			else {
+				Profiler::Scope profile_pass(m_profiler, "Fractal", true);
 				glViewport(0, 0, drawable_w, drawable_h);
 				glClearColor(clear_color.x* clear_color.w, clear_color.y* clear_color.w, clear_color.z* clear_color.w, clear_color.w);
 				glClear(GL_COLOR_BUFFER_BIT);
 
+				// df64 runs out of mantissa before fp64 does, so the kernel follows the zoom (and the precision setting)
+				const bool has_df64_kernel = m_currentFractal == FractalType::MANDELBROT || m_currentFractal == FractalType::BURNING_SHIP ||
+					m_currentFractal == FractalType::TRICORN || m_currentFractal == FractalType::PHOENIX;
+				if (has_df64_kernel && !m_fractal_fragment_path.empty() && useDf64(m_mandel_zoom, drawable_h) != m_fractal_shader_df64) {
+					ourShader = loadFractalShader(m_fractal_vertex_path.c_str(), m_fractal_fragment_path.c_str());
+				}
 				ourShader->use();
 				ourShader->setFloat("iTime", SDL_GetTicks() / 1000.0f);
 				ourShader->setVec2("iResolution", (float)drawable_w, (float)drawable_h);
@@ -1932,20 +2174,57 @@ void Application::run() {
 					ourShader->setVec3("u_palette_c", m_palette_c.x, m_palette_c.y, m_palette_c.z);
 					ourShader->setVec3("u_palette_d", m_palette_d.x, m_palette_d.y, m_palette_d.z);
 				}
+				// fractals go into the progressive target, which only draws while the view is still refining,
+				// the animated menu background keeps drawing straight to the screen
+				const bool live_fractal = m_currentFractal != FractalType::NONE;
+				bool fractal_pass = true;
+				if (live_fractal) {
+					pollReferenceOrbit();
+					if (m_upscale_shader == nullptr) {
+						m_upscale_shader = m_shaders.get("shaders/simple.vert", "shaders/upscale.frag");
+						m_progressive.setUpscaler(m_upscale_shader, VAO);
+					}
+					if (m_budget_from_frame_rate) {
+						const float frame_ms = targetFrameMs();
+						m_progressive_budget_ms = frame_ms > 0.0f ? frame_ms * LIVE_FRAME_SHARE : PROGRESSIVE_DEFAULT_BUDGET_MS;
+					}
+					m_progressive.setEnabled(m_progressive_rendering);
+					m_progressive.setFrameBudget(m_progressive_budget_ms);
+					const LiveViewState view_state = liveViewState(drawable_w, drawable_h);
+					if (!(view_state == m_live_view_state)) {
+						// a raised limit continues the kept orbits, a pan or zoom keeps what it can of the last image,
+						// anything else starts over
+						double scale = 1.0, offset_x = 0.0, offset_y = 0.0;
+						if (!resumeLiveIterations(m_live_view_state, view_state) &&
+							(!liveViewTransform(m_live_view_state, view_state, scale, offset_x, offset_y) ||
+							!m_progressive.reproject(scale, offset_x, offset_y))) {
+							m_progressive.invalidate();
+						}
+						m_live_view_state = view_state;
+					}
+					fractal_pass = m_progressive.beginPass(drawable_w, drawable_h);
+				}
+				bool frame_drawn = false;
 				if (m_currentFractal == FractalType::MANDELBROT) {
 					ourShader->setDVec2("u_center", m_mandel_center_x, m_mandel_center_y);
 					ourShader->setDouble("u_zoom", m_mandel_zoom);
+					int mandel_iterations = m_mandel_max_iterations;
 					if (m_adaptive_iterations) {
 						int final_iterations = m_base_iterations;
 						if (m_adaptive_iterations && m_mandel_zoom > 1.0) {
 							final_iterations += static_cast<int>(150.0 * log(m_mandel_zoom));
 						}
 						final_adaptive_iterations = final_iterations;
+						mandel_iterations = final_iterations;
 						ourShader->setInt("u_max_iterations", final_iterations);
 					}
 					else {
 						ourShader->setInt("u_max_iterations", m_mandel_max_iterations);
 					}
+					// past the fp64 wall the view switches to perturbation, the plain shader covers the frames until a reference is ready
+					if (fractal_pass && m_mandel_zoom >= DEEP_ZOOM_THRESHOLD) {
+						frame_drawn = drawMandelbrotPerturbed(drawable_w, drawable_h, std::max(mandel_iterations, m_mandel_deep_iterations));
+					}
 					if (!m_apply_common_color_palette) {
 						ourShader->setVec3("u_palette_a", m_palette_mandelbrot_a.x, m_palette_mandelbrot_a.y, m_palette_mandelbrot_a.z);
 						ourShader->setVec3("u_palette_b", m_palette_mandelbrot_b.x, m_palette_mandelbrot_b.y, m_palette_mandelbrot_b.z);
@@ -2168,13 +2447,50 @@ void Application::run() {
 					// no fractal selected
 				}
 
-				glBindVertexArray(VAO);
-				glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+				// the fp64 mandelbrot and julia shaders keep the orbits of their full resolution passes, a resumed pass
+				// only iterates the pixels that ran out
+				if (live_fractal && (m_currentFractal == FractalType::MANDELBROT || m_currentFractal == FractalType::JULIA) && !m_fractal_shader_df64) {
+					const bool draws = fractal_pass && !frame_drawn;
+					const bool keep_state = draws && liveKeepsState() && m_progressive.scale() == 1 && m_iteration_state.allocate(drawable_w, drawable_h);
+					const int resume_from = keep_state && m_progressive.resuming() ? m_resume_from : 0;
+					if (keep_state) {
+						m_iteration_state.bind();
+						m_iteration_state.keep(liveIterationLimit());
+						// the last pass's orbit stores land before this one reads them
+						glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+					}
+					else if (draws) {
+						m_iteration_state.drop();
+					}
+					ourShader->setInt("u_state_width", keep_state ? drawable_w : 0);
+					ourShader->setInt("u_resume_from", resume_from);
+					ourShader->setInt("u_resume_save", periodSaveAfter(0, resume_from, PERIOD_FIRST_SAVE));
+				}
+				if (fractal_pass && !frame_drawn) {
+					glBindVertexArray(VAO);
+					glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+				}
+				if (live_fractal) {
+					if (fractal_pass) {
+						m_progressive.endPass();
+					}
+					glViewport(0, 0, drawable_w, drawable_h);
+					m_progressive.present(drawable_w, drawable_h);
+				}
 			}
 
-			ImGui::Render();
-			ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
-			SDL_GL_SwapWindow(window);
+			{
+				Profiler::Scope profile_pass(m_profiler, "ImGui Render", true);
+				ImGui::Render();
+				ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+			}
+			{
+				Profiler::Scope profile_pass(m_profiler, "Swap", true);
+				SDL_GL_SwapWindow(window);
+			}
+			m_profiler.endFrame();
+			limitFrameRate();
+			m_active_frames = std::max(m_active_frames - 1, 0);
 		}
 	}
 	catch (const std::exception& e) {
@@ -2275,7 +2591,7 @@ void Application::initImGui() {
 }
 
 void Application::initBG() {
-	ourShader = new Shader("shaders/background.vert", "shaders/background.frag");
+	ourShader = m_shaders.get("shaders/background.vert", "shaders/background.frag");
 	float vertices[] = {
 		-1.0f,  1.0f, 0.0f,  0.0f, 1.0f,
 		-1.0f, -1.0f, 0.0f,  0.0f, 0.0f,
@@ -2306,7 +2622,22 @@ void Application::initBG() {
 }
 
 void Application::cleanup() {
-	delete ourShader;
+	stopExport();
+	if (m_reference_future.valid()) {
+		m_cancel_reference.store(true);
+		m_reference_future.wait();
+	}
+	releasePreRender();
+	m_progressive.release();
+	m_iteration_state.release();
+	m_profiler.release();
+	m_shaders.release();
+	if (m_reference_orbit_ssbo) {
+		glDeleteBuffers(1, &m_reference_orbit_ssbo);
+	}
+	if (m_bla_ssbo) {
+		glDeleteBuffers(1, &m_bla_ssbo);
+	}
 	glDeleteVertexArrays(1, &VAO);
 	glDeleteBuffers(1, &VBO_vertices);
 	glDeleteBuffers(1, &EBO);
@@ -2615,11 +2946,7 @@ void Application::performPreRender() {
 	glGenerateMipmap(GL_TEXTURE_2D);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-	if (ourShader != nullptr) {
-		delete ourShader;
-		ourShader = nullptr;
-	}
-	m_texture_view_shader = new Shader("shaders/texture_view.vert", "shaders/texture_view.frag");
+	m_texture_view_shader = m_shaders.get("shaders/texture_view.vert", "shaders/texture_view.frag");
 	spdlog::info("Pre-render complete.");
 }
 
@@ -2627,6 +2954,11 @@ void Application::performPreRender() {
 void Application::preRenderWorker()
 {
 	m_cancel_pre_render.store(false);
+	// both draw on the worker context
+	stopExport();
+	std::lock_guard<std::mutex> context_lock(m_worker_context_mutex);
+	m_pre_render_tiles_total.store(0);
+	m_pre_render_tiles_done.store(0);
 	if (m_use_pre_render_params) {
 		spdlog::info("Worker thread: Using custom pre-render parameters.");
 		m_pre_render_resolution = tex_res;
@@ -2635,53 +2967,31 @@ void Application::preRenderWorker()
 		spdlog::info("Worker thread: Using default pre-render parameters.");
 		m_pre_render_resolution = m_pre_render_highest_supported_resolution / 2;
 	}
+	// the startup precompile borrows the same context
+	m_shaders.waitForPrecompile();
 	if (SDL_GL_MakeCurrent(window, m_worker_context) != 0) {
 		spdlog::critical("Worker thread could not set GL context! Error: {}", SDL_GetError());
 		m_worker_finished_submission.store(true);
 		return;
 	}
+	// every way out leaves the context free for the detail pages and the export, before the mutex is let go
+	struct ContextRelease {
+		SDL_Window* window;
+		~ContextRelease() { SDL_GL_MakeCurrent(window, nullptr); }
+	} context_release{ window };
 
 	spdlog::info("Worker thread: Starting {}K pre-render submission...", (m_pre_render_resolution / 1024));
-	Shader* workerShader;
-	if (m_currentFractal == FractalType::MANDELBROT) {
-		workerShader = new Shader("shaders/prerender.vert", "shaders/mandelbrot_prerender.frag");
-	}
-	else if (m_currentFractal == FractalType::JULIA) {
-		workerShader = new Shader("shaders/prerender.vert", "shaders/julia_prerender.frag");
-	}
-	else if (m_currentFractal == FractalType::BURNING_SHIP) {
-		workerShader = new Shader("shaders/prerender.vert", "shaders/burning_ship_prerender.frag");
-	}
-	else if (m_currentFractal == FractalType::TRICORN) {
-		workerShader = new Shader("shaders/prerender.vert", "shaders/tricorn_prerender.frag");
-	}
-	else if (m_currentFractal == FractalType::PHOENIX) {
-		workerShader = new Shader("shaders/prerender.vert", "shaders/phoenix_prerender.frag");
-	}
-	else if (m_currentFractal == FractalType::LYAPUNOV) {
-		workerShader = new Shader("shaders/prerender.vert", "shaders/lyapunov_prerender.frag");
-	}
-	else if (m_currentFractal == FractalType::NEWTON) {
-		workerShader = new Shader("shaders/prerender.vert", "shaders/newton_prerender.frag");
-	}
-	else if (m_currentFractal == FractalType::NOVA) {
-		workerShader = new Shader("shaders/prerender.vert", "shaders/nova_prerender.frag");
-	}
-	else if (m_currentFractal == FractalType::MULTIBROT) {
-		workerShader = new Shader("shaders/prerender.vert", "shaders/multibrot_prerender.frag");
-	}
-	else if (m_currentFractal == FractalType::SPIDER) {
-		workerShader = new Shader("shaders/prerender.vert", "shaders/spider_prerender.frag");
-	}
-	else {
+	const std::string worker_fragment_path = preRenderKernelPath(m_pre_render_resolution);
+	if (worker_fragment_path.empty()) {
 		spdlog::critical("Worker thread: No valid fractal type set for pre-render!");
 		m_worker_finished_submission.store(true);
 		return;
 	}
+	spdlog::info("Worker thread: pre-render kernel {}", worker_fragment_path);
+	Shader* workerShader = m_shaders.get("shaders/prerender.vert", worker_fragment_path.c_str());
 
 	if (workerShader == nullptr || workerShader->ID == 0) {
 		spdlog::critical("Worker thread: Failed to create or link the shader program!");
-		delete workerShader;
 		m_worker_finished_submission.store(true);
 		return;
 	}
@@ -2697,6 +3007,7 @@ void Application::preRenderWorker()
 	glEnableVertexAttribArray(1);
 	glGenFramebuffers(1, &m_pre_render_fbo);
 	glBindFramebuffer(GL_FRAMEBUFFER, m_pre_render_fbo);
+	// the viewer samples the colour texture, colorize.frag fills it from the g-buffer once the kernels are done
 	glGenTextures(1, &m_pre_render_texture);
 	glBindTexture(GL_TEXTURE_2D, m_pre_render_texture);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_pre_render_resolution, m_pre_render_resolution, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
@@ -2706,12 +3017,25 @@ void Application::preRenderWorker()
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
 	float borderColor[] = { 0.0f, 0.0f, 0.0f, 1.0f };
 	glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_pre_render_texture, 0);
+	const GLenum gbuffer_formats[2] = { GL_R32F, GL_RGBA8 };
+	unsigned int* gbuffer_textures[2] = { &m_pre_render_gbuffer_value, &m_pre_render_gbuffer_orbit };
+	for (int k = 0; k < 2; ++k) {
+		glGenTextures(1, gbuffer_textures[k]);
+		glBindTexture(GL_TEXTURE_2D, *gbuffer_textures[k]);
+		glTexStorage2D(GL_TEXTURE_2D, 1, gbuffer_formats[k], m_pre_render_resolution, m_pre_render_resolution);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + k, GL_TEXTURE_2D, *gbuffer_textures[k], 0);
+	}
+	const GLenum gbuffer_attachments[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+	glDrawBuffers(2, gbuffer_attachments);
 
 	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
 		spdlog::critical("Worker thread: Framebuffer is not complete!");
 		glBindFramebuffer(GL_FRAMEBUFFER, 0);
 		glDeleteTextures(1, &m_pre_render_texture);
+		glDeleteTextures(1, &m_pre_render_gbuffer_value);
+		glDeleteTextures(1, &m_pre_render_gbuffer_orbit);
 		glDeleteFramebuffers(1, &m_pre_render_fbo);
 		glDeleteVertexArrays(1, &workerVAO);
 		m_worker_finished_submission.store(true);
@@ -2719,301 +3043,1511 @@ void Application::preRenderWorker()
 	}
 
 	glViewport(0, 0, m_pre_render_resolution, m_pre_render_resolution);
+	// basin 0 everywhere, a cancelled render leaves the missing tiles in the fixed colour
+	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
 	glClear(GL_COLOR_BUFFER_BIT);
 	workerShader->use();
 	/*workerShader->setVec2("iResolution", (float)m_pre_render_resolution, (float)m_pre_render_resolution);*/ // not required in pre rendering
-	workerShader->setInt("u_max_iterations", 5000);
-	workerShader->setFloat("u_color_density", m_color_density);
-
-	if (m_currentFractal == FractalType::MANDELBROT) {
-		if (m_use_pre_render_params) {
-			workerShader->setDVec2("u_center", m_pre_render_center_x, m_pre_render_center_y);
-			workerShader->setDouble("u_zoom", m_pre_render_zoom_threshold);
+	if (!setPreRenderUniforms(workerShader)) {
+		spdlog::critical("Worker thread: No fractals selected, pre-render aborted ...");
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glDeleteTextures(1, &m_pre_render_texture);
+		glDeleteTextures(1, &m_pre_render_gbuffer_value);
+		glDeleteTextures(1, &m_pre_render_gbuffer_orbit);
+		glDeleteFramebuffers(1, &m_pre_render_fbo);
+		glDeleteVertexArrays(1, &workerVAO);
+		m_worker_finished_submission.store(true);
+		return;
+	}
+	CpuRenderParams cpu_params;
+	const bool cpu_supported = m_pre_render_backend != PreRenderBackend::GPU && buildCpuPreRenderParams(cpu_params);
+	if (m_pre_render_backend != PreRenderBackend::GPU && !cpu_supported) {
+		spdlog::warn("Worker thread: CPU backend does not support this fractal, falling back to the GPU.");
+	}
+	// the gpu pre-render shaders have no perturbation path, so deep views stay on the cpu even in hybrid mode
+	const bool use_gpu = cpu_supported ? (m_pre_render_backend == PreRenderBackend::HYBRID && !cpu_params.reference) : true;
+	m_pre_render_perturbed.store(cpu_supported && cpu_params.reference != nullptr);
+	// divergent views load balance better through the persistent compute kernel, where the fractal has one
+	Shader* computeShader = nullptr;
+	const std::string compute_path = use_gpu ? preRenderComputePath() : std::string();
+	if (!compute_path.empty()) {
+		computeShader = m_shaders.getCompute(compute_path);
+		// the compaction passes are sized on the gpu by a second small kernel
+		Shader* dispatchShader = m_pre_render_compaction ? m_shaders.getCompute("shaders/compaction_dispatch.comp") : nullptr;
+		const bool dispatch_ready = !m_pre_render_compaction || (dispatchShader != nullptr && dispatchShader->ID != 0);
+		if (computeShader == nullptr || computeShader->ID == 0 || !dispatch_ready || !setPreRenderUniforms(computeShader)) {
+			spdlog::warn("Worker thread: compute kernel {} is not usable, staying on the fragment shader.", compute_path);
+			computeShader = nullptr;
 		}
 		else {
-			workerShader->setDVec2("u_center", -0.75, 0.0);
-			workerShader->setDouble("u_zoom", 1.0);
+			spdlog::info("Worker thread: GPU tiles go through the compute kernel {}", compute_path);
 		}
-		if (!m_apply_common_color_palette) {
-			workerShader->setVec3("u_palette_a", m_palette_mandelbrot_a.x, m_palette_mandelbrot_a.y, m_palette_mandelbrot_a.z);
-			workerShader->setVec3("u_palette_b", m_palette_mandelbrot_b.x, m_palette_mandelbrot_b.y, m_palette_mandelbrot_b.z);
-			workerShader->setVec3("u_palette_c", m_palette_mandelbrot_c.x, m_palette_mandelbrot_c.y, m_palette_mandelbrot_c.z);
-			workerShader->setVec3("u_palette_d", m_palette_mandelbrot_d.x, m_palette_mandelbrot_d.y, m_palette_mandelbrot_d.z);
+	}
+	if (!preRenderTiles(workerShader, computeShader, workerVAO, PRE_RENDER_TILE_SIZE, use_gpu, cpu_supported ? &cpu_params : nullptr)) {
+		if (m_cancel_pre_render.load()) {
+			spdlog::warn("Worker thread: pre-render cancelled by user.");
 		}
 		else {
-			workerShader->setVec3("u_palette_a", m_palette_a.x, m_palette_a.y, m_palette_a.z);
-			workerShader->setVec3("u_palette_b", m_palette_b.x, m_palette_b.y, m_palette_b.z);
-			workerShader->setVec3("u_palette_c", m_palette_c.x, m_palette_c.y, m_palette_c.z);
-			workerShader->setVec3("u_palette_d", m_palette_d.x, m_palette_d.y, m_palette_d.z);
+			spdlog::critical("Worker thread: pre-render failed before all tiles were submitted!");
 		}
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		m_worker_finished_submission.store(true);
+		return;
+	}
+	spdlog::info("Worker thread: All tiles rendered.");
+	glDisable(GL_SCISSOR_TEST);
+	if (m_pre_render_fence) { glDeleteSync(m_pre_render_fence); }
+	m_pre_render_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	glFlush();
+	glDeleteVertexArrays(1, &workerVAO);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	m_worker_finished_submission.store(true);
+	spdlog::info("Worker thread: Render commands submitted.");
+	spdlog::info("Worker thread: Pre-render worker completed.");
+}
+
+// continues the orbits the last compacted pre-render kept from its limit up to the current one. only those pixels are
+// iterated, their new values go straight into the g-buffer and the main thread colours it again once the fence signals
+void Application::preRenderResumeWorker()
+{
+	stopExport();
+	std::lock_guard<std::mutex> context_lock(m_worker_context_mutex);
+	const int from = m_pre_render_resume_iterations.load();
+	auto finish = [this]() {
+		SDL_GL_MakeCurrent(window, nullptr);
+		m_pre_render_resuming.store(false);
+	};
+	if (SDL_GL_MakeCurrent(window, m_worker_context) != 0) {
+		spdlog::error("Worker thread could not set GL context! Error: {}", SDL_GetError());
+		m_pre_render_resuming.store(false);
+		return;
+	}
+	const char* kernel_path = m_currentFractal == FractalType::MANDELBROT ? "shaders/mandelbrot_compact.comp" :
+		m_currentFractal == FractalType::JULIA ? "shaders/julia_compact.comp" : nullptr;
+	Shader* kernel = kernel_path ? m_shaders.getCompute(kernel_path) : nullptr;
+	Shader* dispatch = m_shaders.getCompute("shaders/compaction_dispatch.comp");
+	if (kernel == nullptr || kernel->ID == 0 || dispatch == nullptr || dispatch->ID == 0 || m_pre_render_resume_list == 0 || !setPreRenderUniforms(kernel)) {
+		spdlog::error("Worker thread: the kept orbits cannot be continued.");
+		finish();
+		return;
+	}
+	spdlog::info("Worker thread: continuing {} orbits from {} to {} iterations.", m_pre_render_resume_count.load(), from, m_pre_render_iterations);
+	const auto start = std::chrono::steady_clock::now();
+	kernel->use();
+	kernel->setIVec2("u_image_size", m_pre_render_resolution, m_pre_render_resolution);
+	glBindImageTexture(0, m_pre_render_gbuffer_value, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+	glBindImageTexture(1, m_pre_render_gbuffer_orbit, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+	// the kept list is the first one read, the passes swap with a scratch list of its size
+	GLuint lists[2] = { m_pre_render_resume_list, 0 };
+	GLuint dispatch_args = 0;
+	glCreateBuffers(1, &lists[1]);
+	glNamedBufferStorage(lists[1], PRE_RENDER_COMPACTION_HEADER_BYTES + (GLsizeiptr)std::max(1, m_pre_render_resume_count.load()) * PRE_RENDER_COMPACTION_ORBIT_BYTES,
+		nullptr, GL_DYNAMIC_STORAGE_BIT);
+	glCreateBuffers(1, &dispatch_args);
+	glNamedBufferStorage(dispatch_args, 3 * sizeof(GLuint), nullptr, 0);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 8, dispatch_args);
+	glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, dispatch_args);
+	const int read = runCompactionPasses(kernel, dispatch, lists, 0, from, 0, 0);
+	for (GLuint binding = 6; binding <= 8; ++binding) {
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, 0);
+	}
+	glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, 0);
+	// the orbits that ran out again were appended to the list the last pass wrote, it is the one kept from now on
+	m_pre_render_resume_list = lists[1 - read];
+	glDeleteBuffers(1, &lists[read]);
+	glDeleteBuffers(1, &dispatch_args);
+	glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT);
+	GLuint kept = 0;
+	glGetNamedBufferSubData(m_pre_render_resume_list, 0, sizeof(GLuint), &kept);
+	m_pre_render_resume_count.store((int)kept);
+	m_pre_render_resume_iterations.store(m_pre_render_iterations);
+	const double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	spdlog::info("Worker thread: continued the render in {:.2f} ms, {} orbits still running.", milliseconds, kept);
+	if (m_pre_render_resume_fence) { glDeleteSync(m_pre_render_resume_fence); }
+	m_pre_render_resume_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	glFlush();
+	finish();
+}
+
+// the tiled kernel of the current fractal for an image of the given size, the pre-render and the export draw through the same one.
+// empty when no fractal is selected
+std::string Application::preRenderKernelPath(int resolution) const
+{
+	const char* fragment = nullptr;
+	if (m_currentFractal == FractalType::MANDELBROT) {
+		fragment = "shaders/mandelbrot_prerender.frag";
 	}
 	else if (m_currentFractal == FractalType::JULIA) {
-		if (m_use_pre_render_params) {
-			workerShader->setDVec2("u_center", m_pre_render_center_x, m_pre_render_center_y);
-			workerShader->setDouble("u_zoom", m_pre_render_zoom_threshold);
-			workerShader->setDVec2("u_julia_c", m_pre_render_julia_c_x, m_pre_render_julia_c_y);
-		}
-		else {
-			workerShader->setDVec2("u_center", 0.0, 0.0);
-			workerShader->setDouble("u_zoom", 1.0);
-			workerShader->setDVec2("u_julia_c", -0.7, 0.27015);
-		}
-		if (!m_apply_common_color_palette) {
-			workerShader->setVec3("u_palette_a", m_palette_julia_a.x, m_palette_julia_a.y, m_palette_julia_a.z);
-			workerShader->setVec3("u_palette_b", m_palette_julia_b.x, m_palette_julia_b.y, m_palette_julia_b.z);
-			workerShader->setVec3("u_palette_c", m_palette_julia_c.x, m_palette_julia_c.y, m_palette_julia_c.z);
-			workerShader->setVec3("u_palette_d", m_palette_julia_d.x, m_palette_julia_d.y, m_palette_julia_d.z);
-		}
-		else {
-			workerShader->setVec3("u_palette_a", m_palette_a.x, m_palette_a.y, m_palette_a.z);
-			workerShader->setVec3("u_palette_b", m_palette_b.x, m_palette_b.y, m_palette_b.z);
-			workerShader->setVec3("u_palette_c", m_palette_c.x, m_palette_c.y, m_palette_c.z);
-			workerShader->setVec3("u_palette_d", m_palette_d.x, m_palette_d.y, m_palette_d.z);
-		}
+		fragment = "shaders/julia_prerender.frag";
 	}
 	else if (m_currentFractal == FractalType::BURNING_SHIP) {
-		if (m_use_pre_render_params) {
-			workerShader->setDVec2("u_center", m_pre_render_center_x, m_pre_render_center_y);
-			workerShader->setDouble("u_zoom", m_pre_render_zoom_threshold);
-		}
-		else {
-			workerShader->setDVec2("u_center", -1.75, -0.04);
-			workerShader->setDouble("u_zoom", 22.0);
+		fragment = "shaders/burning_ship_prerender.frag";
+	}
+	else if (m_currentFractal == FractalType::TRICORN) {
+		fragment = "shaders/tricorn_prerender.frag";
+	}
+	else if (m_currentFractal == FractalType::PHOENIX) {
+		fragment = "shaders/phoenix_prerender.frag";
+	}
+	else if (m_currentFractal == FractalType::LYAPUNOV) {
+		fragment = "shaders/lyapunov_prerender.frag";
+	}
+	else if (m_currentFractal == FractalType::NEWTON) {
+		fragment = "shaders/newton_prerender.frag";
+	}
+	else if (m_currentFractal == FractalType::NOVA) {
+		fragment = "shaders/nova_prerender.frag";
+	}
+	else if (m_currentFractal == FractalType::MULTIBROT) {
+		fragment = "shaders/multibrot_prerender.frag";
+	}
+	else if (m_currentFractal == FractalType::SPIDER) {
+		fragment = "shaders/spider_prerender.frag";
+	}
+	else {
+		return "";
+	}
+	// same fp64 / df64 choice as the real-time view, made for the pre-render zoom and the image size
+	const std::string path = fragment;
+	const double zoom = m_use_pre_render_params ? m_pre_render_zoom_threshold : 1.0;
+	const std::string df64_path = df64FragmentPath(path);
+	return !df64_path.empty() && useDf64(zoom, resolution) ? df64_path : path;
+}
+
+// the compute kernel of the current fractal when it has one and it is switched on, empty otherwise: the compaction
+// kernel with stream compaction on, the persistent one otherwise. compute kernels are fp64 only, the precision setting
+// does not reach them
+std::string Application::preRenderComputePath() const
+{
+	if (m_currentFractal == FractalType::MANDELBROT && m_compute_kernel_mandelbrot) {
+		return m_pre_render_compaction ? "shaders/mandelbrot_compact.comp" : "shaders/mandelbrot_prerender.comp";
+	}
+	if (m_currentFractal == FractalType::JULIA && m_compute_kernel_julia) {
+		return m_pre_render_compaction ? "shaders/julia_compact.comp" : "shaders/julia_prerender.comp";
+	}
+	return "";
+}
+
+// the view the pre-render covers, the pre-render parameters when they are in use and every fractal's overview otherwise
+Application::PreRenderView Application::preRenderView() const
+{
+	PreRenderView view;
+	view.fractal = m_currentFractal;
+	view.max_iterations = m_pre_render_iterations;
+	const bool custom = m_use_pre_render_params;
+	view.center_x = m_pre_render_center_x;
+	view.center_y = m_pre_render_center_y;
+	view.zoom = m_pre_render_zoom_threshold;
+	if (m_currentFractal == FractalType::MANDELBROT) {
+		if (!custom) {
+			view.center_x = -0.75;
+			view.center_y = 0.0;
+			view.zoom = 1.0;
 		}
-		if (!m_apply_common_color_palette) {
-			workerShader->setVec3("u_palette_a", m_palette_burning_ship_a.x, m_palette_burning_ship_a.y, m_palette_burning_ship_a.z);
-			workerShader->setVec3("u_palette_b", m_palette_burning_ship_b.x, m_palette_burning_ship_b.y, m_palette_burning_ship_b.z);
-			workerShader->setVec3("u_palette_c", m_palette_burning_ship_c.x, m_palette_burning_ship_c.y, m_palette_burning_ship_c.z);
-			workerShader->setVec3("u_palette_d", m_palette_burning_ship_d.x, m_palette_burning_ship_d.y, m_palette_burning_ship_d.z);
+	}
+	else if (m_currentFractal == FractalType::JULIA) {
+		if (custom) {
+			view.c_x = m_pre_render_julia_c_x;
+			view.c_y = m_pre_render_julia_c_y;
 		}
 		else {
-			workerShader->setVec3("u_palette_a", m_palette_a.x, m_palette_a.y, m_palette_a.z);
-			workerShader->setVec3("u_palette_b", m_palette_b.x, m_palette_b.y, m_palette_b.z);
-			workerShader->setVec3("u_palette_c", m_palette_c.x, m_palette_c.y, m_palette_c.z);
-			workerShader->setVec3("u_palette_d", m_palette_d.x, m_palette_d.y, m_palette_d.z);
+			view.center_x = 0.0;
+			view.center_y = 0.0;
+			view.zoom = 1.0;
+			view.c_x = -0.7;
+			view.c_y = 0.27015;
 		}
 	}
-	else if (m_currentFractal == FractalType::TRICORN) {
-		if (m_use_pre_render_params) {
-			workerShader->setDVec2("u_center", m_pre_render_center_x, m_pre_render_center_y);
-			workerShader->setDouble("u_zoom", m_pre_render_zoom_threshold);
-		}
-		else {
-			workerShader->setDVec2("u_center", 0.0, 0.0);
-			workerShader->setDouble("u_zoom", 0.5);
+	else if (m_currentFractal == FractalType::BURNING_SHIP) {
+		if (!custom) {
+			view.center_x = -1.75;
+			view.center_y = -0.04;
+			view.zoom = 22.0;
 		}
-		if (!m_apply_common_color_palette) {
-			workerShader->setVec3("u_palette_a", m_palette_tricorn_a.x, m_palette_tricorn_a.y, m_palette_tricorn_a.z);
-			workerShader->setVec3("u_palette_b", m_palette_tricorn_b.x, m_palette_tricorn_b.y, m_palette_tricorn_b.z);
-			workerShader->setVec3("u_palette_c", m_palette_tricorn_c.x, m_palette_tricorn_c.y, m_palette_tricorn_c.z);
-			workerShader->setVec3("u_palette_d", m_palette_tricorn_d.x, m_palette_tricorn_d.y, m_palette_tricorn_d.z);
+	}
+	else if (m_currentFractal == FractalType::PHOENIX) {
+		if (custom) {
+			view.c_x = m_pre_render_phoenix_c_x;
+			view.c_y = m_pre_render_phoenix_c_y;
+			view.p = m_pre_render_phoenix_p;
 		}
 		else {
-			workerShader->setVec3("u_palette_a", m_palette_a.x, m_palette_a.y, m_palette_a.z);
-			workerShader->setVec3("u_palette_b", m_palette_b.x, m_palette_b.y, m_palette_b.z);
-			workerShader->setVec3("u_palette_c", m_palette_c.x, m_palette_c.y, m_palette_c.z);
-			workerShader->setVec3("u_palette_d", m_palette_d.x, m_palette_d.y, m_palette_d.z);
+			view.center_x = 0.0;
+			view.center_y = 0.0;
+			view.zoom = 0.5;
+			view.c_x = -0.5;
+			view.c_y = 0.0;
+			view.p = 0.56667;
 		}
 	}
-	else if (m_currentFractal == FractalType::PHOENIX) {
-		if (m_use_pre_render_params) {
-			workerShader->setDVec2("u_center", m_pre_render_center_x, m_pre_render_center_y);
-			workerShader->setDouble("u_zoom", m_pre_render_zoom_threshold);
-			workerShader->setDVec2("u_phoenix_c", m_pre_render_phoenix_c_x, m_pre_render_phoenix_c_y);
-			workerShader->setDouble("u_phoenix_p", m_pre_render_phoenix_p);
+	else if (m_currentFractal == FractalType::LYAPUNOV) {
+		view.center_x = custom ? m_pre_render_lyapunov_center_a : 3.0;
+		view.center_y = custom ? m_pre_render_lyapunov_center_b : 3.0;
+		view.zoom = custom ? m_pre_render_zoom_threshold : 1.0;
+	}
+	else if (m_currentFractal == FractalType::NOVA) {
+		if (custom) {
+			view.power = m_pre_render_nova_power;
+			view.relaxation = m_pre_render_nova_relaxation;
 		}
 		else {
-			workerShader->setDVec2("u_center", 0.0, 0.0);
-			workerShader->setDouble("u_zoom", 0.5);
-			workerShader->setDVec2("u_phoenix_c", -0.5, 0.0);
-			workerShader->setDouble("u_phoenix_p", 0.56667);
+			view.center_x = 0.0;
+			view.center_y = 0.0;
+			view.zoom = 0.5;
+			view.power = 3.0;
+			view.relaxation = 1.0;
 		}
-		if (!m_apply_common_color_palette) {
-			workerShader->setVec3("u_palette_a", m_palette_phoenix_a.x, m_palette_phoenix_a.y, m_palette_phoenix_a.z);
-			workerShader->setVec3("u_palette_b", m_palette_phoenix_b.x, m_palette_phoenix_b.y, m_palette_phoenix_b.z);
-			workerShader->setVec3("u_palette_c", m_palette_phoenix_c.x, m_palette_phoenix_c.y, m_palette_phoenix_c.z);
-			workerShader->setVec3("u_palette_d", m_palette_phoenix_d.x, m_palette_phoenix_d.y, m_palette_phoenix_d.z);
+	}
+	else if (m_currentFractal == FractalType::MULTIBROT) {
+		if (custom) {
+			view.power = m_pre_render_multibrot_power;
 		}
 		else {
-			workerShader->setVec3("u_palette_a", m_palette_a.x, m_palette_a.y, m_palette_a.z);
-			workerShader->setVec3("u_palette_b", m_palette_b.x, m_palette_b.y, m_palette_b.z);
-			workerShader->setVec3("u_palette_c", m_palette_c.x, m_palette_c.y, m_palette_c.z);
-			workerShader->setVec3("u_palette_d", m_palette_d.x, m_palette_d.y, m_palette_d.z);
+			view.center_x = 0.0;
+			view.center_y = 0.0;
+			view.zoom = 0.5;
+			view.power = 3.0;
 		}
 	}
-	else if (m_currentFractal == FractalType::LYAPUNOV) {
-		if (m_use_pre_render_params) {
-			workerShader->setDVec2("u_lyapunov_center", m_pre_render_lyapunov_center_a, m_pre_render_lyapunov_center_b);
-			workerShader->setDouble("u_lyapunov_zoom", m_pre_render_zoom_threshold);
+	else if (!custom) {
+		// tricorn, newton and spider
+		view.center_x = 0.0;
+		view.center_y = 0.0;
+		view.zoom = 0.5;
+	}
+	return view;
+}
+
+// uploads the view the pre-render covers to a tiled kernel, false when no fractal is selected
+bool Application::setPreRenderUniforms(Shader* shader) const
+{
+	return setPreRenderUniforms(shader, preRenderView());
+}
+
+bool Application::setPreRenderUniforms(Shader* shader, const PreRenderView& view)
+{
+	if (view.fractal == FractalType::NONE) {
+		return false;
+	}
+	shader->setInt("u_max_iterations", view.max_iterations);
+	if (view.fractal == FractalType::LYAPUNOV) {
+		shader->setDVec2("u_lyapunov_center", view.center_x, view.center_y);
+		shader->setDouble("u_lyapunov_zoom", view.zoom);
+		return true;
+	}
+	shader->setDVec2("u_center", view.center_x, view.center_y);
+	shader->setDouble("u_zoom", view.zoom);
+	if (view.fractal == FractalType::JULIA) {
+		shader->setDVec2("u_julia_c", view.c_x, view.c_y);
+	}
+	else if (view.fractal == FractalType::PHOENIX) {
+		shader->setDVec2("u_phoenix_c", view.c_x, view.c_y);
+		shader->setDouble("u_phoenix_p", view.p);
+	}
+	else if (view.fractal == FractalType::NOVA) {
+		shader->setDouble("u_power", view.power);
+		shader->setDouble("u_relaxation", view.relaxation);
+	}
+	else if (view.fractal == FractalType::MULTIBROT) {
+		shader->setDouble("u_power", view.power);
+	}
+	return true;
+}
+
+// fills the cpu engine parameters with the exact view the gpu pre-render shaders would get, false if the fractal has no cpu kernel
+// with_reference false leaves the reference orbit of a deep view to the caller, see preRenderReferenceCenter
+bool Application::buildCpuPreRenderParams(CpuRenderParams& params, bool with_reference) const
+{
+	if (m_currentFractal == FractalType::MANDELBROT) {
+		params.fractal = CpuFractal::MANDELBROT;
+		params.center_x = m_use_pre_render_params ? m_pre_render_center_x : -0.75;
+		params.center_y = m_use_pre_render_params ? m_pre_render_center_y : 0.0;
+		params.zoom = m_use_pre_render_params ? m_pre_render_zoom_threshold : 1.0;
+	}
+	else if (m_currentFractal == FractalType::JULIA) {
+		params.fractal = CpuFractal::JULIA;
+		params.center_x = m_use_pre_render_params ? m_pre_render_center_x : 0.0;
+		params.center_y = m_use_pre_render_params ? m_pre_render_center_y : 0.0;
+		params.zoom = m_use_pre_render_params ? m_pre_render_zoom_threshold : 1.0;
+		params.julia_c_x = m_use_pre_render_params ? m_pre_render_julia_c_x : -0.7;
+		params.julia_c_y = m_use_pre_render_params ? m_pre_render_julia_c_y : 0.27015;
+	}
+	else {
+		return false;
+	}
+	const ImVec4* palette[4];
+	fractalPalette(palette);
+	float* targets[4] = { params.palette_a, params.palette_b, params.palette_c, params.palette_d };
+	for (int k = 0; k < 4; ++k) {
+		targets[k][0] = palette[k]->x;
+		targets[k][1] = palette[k]->y;
+		targets[k][2] = palette[k]->z;
+	}
+	params.max_iterations = m_pre_render_iterations;
+	params.color_density = m_color_density;
+	params.subdivision = m_pre_render_subdivision;
+	params.compaction_chunk = m_pre_render_compaction ? m_pre_render_compaction_chunk : 0;
+	params.gbuffer = true;
+	params.width = m_pre_render_resolution;
+	params.height = m_pre_render_resolution;
+	BigFloat center_x;
+	BigFloat center_y;
+	if (preRenderReferenceCenter(params, center_x, center_y)) {
+		params.max_iterations = std::max(params.max_iterations, m_mandel_deep_iterations);
+		if (with_reference) {
+			params.reference = computeReferenceOrbit(center_x, center_y, params.zoom, params.max_iterations);
 		}
-		else {
-			workerShader->setDVec2("u_lyapunov_center", 3.0, 3.0);
-			workerShader->setDouble("u_lyapunov_zoom", 1.0);
+	}
+	return true;
+}
+
+// deep mandelbrot pre-renders iterate against a reference orbit at the pre-render centre. the doubles only hold the
+// centre to ~1e-16, a pre-render of the live view takes every digit of its BigFloat centre. false when no orbit is needed
+bool Application::preRenderReferenceCenter(const CpuRenderParams& params, BigFloat& center_x, BigFloat& center_y) const
+{
+	if (params.fractal != CpuFractal::MANDELBROT || params.zoom < DEEP_ZOOM_THRESHOLD) {
+		return false;
+	}
+	const bool live_center = m_mandel_deep_center_x.toDouble() == params.center_x && m_mandel_deep_center_y.toDouble() == params.center_y;
+	center_x = live_center ? m_mandel_deep_center_x : BigFloat::fromDouble(params.center_x);
+	center_y = live_center ? m_mandel_deep_center_y : BigFloat::fromDouble(params.center_y);
+	return true;
+}
+
+// runs the compaction kernel (view uniforms set) from iteration begin up to the pre-render limit, one pass per chunk of
+// iterations. begin 0 starts the first pixels of the tile rect, otherwise the first pass continues the orbits of
+// lists[read]. every pass appends to the other list and the next one reads it, the last one appends to resume_list
+// instead when there is one. the passes after the first run as many groups as the last one left orbits (dispatch sizes
+// them from the count in the list), the count never comes back to the host. returns the list the last pass read
+int Application::runCompactionPasses(Shader* kernel, Shader* dispatch, const GLuint lists[2], int read, int begin, int pixels, GLuint resume_list) const
+{
+	const int max_iterations = m_pre_render_iterations;
+	const int first_chunk = std::max(1, m_pre_render_compaction_chunk);
+	// the chunks double, a continued render picks the schedule up where it would be
+	int chunk = begin == 0 ? first_chunk : std::max(first_chunk, begin);
+	int save = periodSaveAfter(0, begin, PERIOD_FIRST_SAVE);
+	const Shader::Uniform iter_begin = kernel->uniform("u_iter_begin");
+	const Shader::Uniform iter_end = kernel->uniform("u_iter_end");
+	const Shader::Uniform next_save = kernel->uniform("u_next_save");
+	for (;;) {
+		const int end = (int)std::min<long long>((long long)begin + chunk, max_iterations);
+		const bool last = end >= max_iterations;
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, lists[read]);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 7, lists[1 - read]);
+		if (begin > 0) {
+			glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+			dispatch->use();
+			glDispatchCompute(1, 1, 1);
+			glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
 		}
-		if (!m_apply_common_color_palette) {
-			workerShader->setVec3("u_palette_a", m_palette_lyapunov_a.x, m_palette_lyapunov_a.y, m_palette_lyapunov_a.z);
-			workerShader->setVec3("u_palette_b", m_palette_lyapunov_b.x, m_palette_lyapunov_b.y, m_palette_lyapunov_b.z);
-			workerShader->setVec3("u_palette_c", m_palette_lyapunov_c.x, m_palette_lyapunov_c.y, m_palette_lyapunov_c.z);
-			workerShader->setVec3("u_palette_d", m_palette_lyapunov_d.x, m_palette_lyapunov_d.y, m_palette_lyapunov_d.z);
+		else if (!last || resume_list == 0) {
+			const GLuint zero = 0;
+			glClearNamedBufferSubData(lists[1 - read], GL_R32UI, 0, sizeof(GLuint), GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+		}
+		if (last && resume_list != 0) {
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 7, resume_list);
+		}
+		kernel->use();
+		kernel->setInt(iter_begin, begin);
+		kernel->setInt(iter_end, end);
+		kernel->setInt(next_save, save);
+		if (begin == 0) {
+			glDispatchCompute((GLuint)((pixels + PRE_RENDER_COMPACTION_GROUP - 1) / PRE_RENDER_COMPACTION_GROUP), 1, 1);
 		}
 		else {
-			workerShader->setVec3("u_palette_a", m_palette_a.x, m_palette_a.y, m_palette_a.z);
-			workerShader->setVec3("u_palette_b", m_palette_b.x, m_palette_b.y, m_palette_b.z);
-			workerShader->setVec3("u_palette_c", m_palette_c.x, m_palette_c.y, m_palette_c.z);
-			workerShader->setVec3("u_palette_d", m_palette_d.x, m_palette_d.y, m_palette_d.z);
+			glDispatchComputeIndirect(0);
 		}
+		if (last) {
+			return read;
+		}
+		save = periodSaveAfter(begin, end, save);
+		begin = end;
+		chunk = (int)std::min<long long>((long long)chunk * 2, max_iterations);
+		read = 1 - read;
 	}
-	else if (m_currentFractal == FractalType::NEWTON) {
-		if (m_use_pre_render_params) {
-			workerShader->setDVec2("u_center", m_pre_render_center_x, m_pre_render_center_y);
-			workerShader->setDouble("u_zoom", m_pre_render_zoom_threshold);
+}
+
+// drives the tile scheduler from the worker GL thread: worker 0 is this context (gpu), the cpu engine threads are the workers after it
+bool Application::preRenderTiles(Shader* shader, Shader* compute_shader, unsigned int vao, int tile_size, bool use_gpu, const CpuRenderParams* cpu_params)
+{
+	const int resolution = m_pre_render_resolution;
+	std::unique_ptr<CpuRenderer> cpu_renderer;
+	if (cpu_params) {
+		// leave a core for this thread when it is feeding the gpu as well
+		const unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+		cpu_renderer = std::make_unique<CpuRenderer>(use_gpu ? std::max(1u, cores - 1) : cores);
+	}
+	const unsigned int gpu_workers = use_gpu ? 1u : 0u;
+	TileScheduler scheduler(gpu_workers + (cpu_renderer ? cpu_renderer->threadCount() : 0u));
+	// the texture view opens on the middle of the texture, so that region is finished first
+	TileCostMap cost;
+	if (use_gpu && !probeTileCost(shader, cost)) {
+		return false;
+	}
+	if (cost.empty()) {
+		scheduler.reset(TileScheduler::makeGrid(resolution, resolution, tile_size, resolution * 0.5, resolution * 0.5));
+	}
+	else {
+		const int max_tile = cpu_renderer ? tile_size : PRE_RENDER_MAX_TILE;
+		scheduler.reset(TileScheduler::makeAdaptive(resolution, resolution, PRE_RENDER_MIN_TILE, max_tile, cost, PRE_RENDER_TILE_BUDGET_MS,
+			resolution * 0.5, resolution * 0.5));
+		spdlog::info("Worker thread: {} tiles planned from the cost probe, {:.0f} ms of GPU work estimated.", scheduler.total(),
+			cost.rectMs(0, 0, resolution, resolution));
+	}
+	m_pre_render_tiles_total.store(scheduler.total());
+	m_pre_render_tiles_done.store(0);
+	m_profiler.clearTiles();
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	if (cpu_renderer) {
+		spdlog::info("Worker thread: Rendering on the {} ({} CPU threads, {}, subdivision {}).", use_gpu ? "GPU and CPU" : "CPU",
+			cpu_renderer->threadCount(), CpuRenderer::simdLevelName(cpu_renderer->simdLevel()), CpuRenderer::subdivisionName(cpu_params->subdivision));
+		cpu_renderer->begin(*cpu_params, scheduler, gpu_workers);
+	}
+	CpuTile cpu_tile;
+	auto uploadCpuTile = [&]() {
+		glBindTexture(GL_TEXTURE_2D, m_pre_render_gbuffer_value);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, cpu_tile.x, cpu_tile.y, cpu_tile.width, cpu_tile.height, GL_RED, GL_FLOAT, cpu_tile.values.data());
+		glBindTexture(GL_TEXTURE_2D, m_pre_render_gbuffer_orbit);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, cpu_tile.x, cpu_tile.y, cpu_tile.width, cpu_tile.height, GL_RGBA, GL_UNSIGNED_BYTE, cpu_tile.pixels.data());
+		m_profiler.recordTile(false, cpu_tile.milliseconds);
+	};
+
+	glEnable(GL_SCISSOR_TEST);
+	glBindVertexArray(vao);
+	const Shader::Uniform tile_info = shader ? shader->uniform("u_tile_info") : Shader::Uniform{};
+	if (use_gpu) {
+		shader->setIVec2("u_image_size", resolution, resolution);
+	}
+	// the compute kernel stores straight into the g-buffer textures and takes its pixels from a counter reset per tile,
+	// or with stream compaction from the survivor lists of the last pass
+	const Shader::Uniform compute_tile_info = compute_shader ? compute_shader->uniform("u_tile_info") : Shader::Uniform{};
+	Shader* dispatch_shader = compute_shader && m_pre_render_compaction ? m_shaders.getCompute("shaders/compaction_dispatch.comp") : nullptr;
+	GLuint queue_buffer = 0;
+	GLuint compaction_lists[2] = { 0, 0 };
+	GLuint compaction_dispatch = 0;
+	if (compute_shader) {
+		compute_shader->use();
+		compute_shader->setIVec2("u_image_size", resolution, resolution);
+		glBindImageTexture(0, m_pre_render_gbuffer_value, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+		glBindImageTexture(1, m_pre_render_gbuffer_orbit, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+	}
+	if (dispatch_shader) {
+		const int largest_tile = std::min(resolution, std::max(tile_size, PRE_RENDER_MAX_TILE));
+		const GLsizeiptr list_bytes = PRE_RENDER_COMPACTION_HEADER_BYTES + (GLsizeiptr)largest_tile * largest_tile * PRE_RENDER_COMPACTION_ORBIT_BYTES;
+		glCreateBuffers(2, compaction_lists);
+		for (GLuint list : compaction_lists) {
+			glNamedBufferStorage(list, list_bytes, nullptr, GL_DYNAMIC_STORAGE_BIT);
 		}
-		else {
-			workerShader->setDVec2("u_center", 0.0, 0.0);
-			workerShader->setDouble("u_zoom", 0.5);
+		glCreateBuffers(1, &compaction_dispatch);
+		glNamedBufferStorage(compaction_dispatch, 3 * sizeof(GLuint), nullptr, 0);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 8, compaction_dispatch);
+		glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, compaction_dispatch);
+	}
+	else if (compute_shader) {
+		glGenBuffers(1, &queue_buffer);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, queue_buffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GLuint), nullptr, GL_DYNAMIC_DRAW);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, queue_buffer);
+	}
+	auto releaseQueue = [&]() {
+		if (compute_shader) {
+			// image stores are not coherent with the texture reads of the colouring pass
+			glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT);
 		}
-		if (!m_apply_common_color_palette) {
-			workerShader->setVec3("u_palette_a", m_palette_newton_a.x, m_palette_newton_a.y, m_palette_newton_a.z);
-			workerShader->setVec3("u_palette_b", m_palette_newton_b.x, m_palette_newton_b.y, m_palette_newton_b.z);
-			workerShader->setVec3("u_palette_c", m_palette_newton_c.x, m_palette_newton_c.y, m_palette_newton_c.z);
-			workerShader->setVec3("u_palette_d", m_palette_newton_d.x, m_palette_newton_d.y, m_palette_newton_d.z);
+		if (queue_buffer) {
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, 0);
+			glDeleteBuffers(1, &queue_buffer);
+			queue_buffer = 0;
 		}
-		else {
-			workerShader->setVec3("u_palette_a", m_palette_a.x, m_palette_a.y, m_palette_a.z);
-			workerShader->setVec3("u_palette_b", m_palette_b.x, m_palette_b.y, m_palette_b.z);
-			workerShader->setVec3("u_palette_c", m_palette_c.x, m_palette_c.y, m_palette_c.z);
-			workerShader->setVec3("u_palette_d", m_palette_d.x, m_palette_d.y, m_palette_d.z);
+		if (compaction_dispatch) {
+			for (GLuint binding = 6; binding <= 8; ++binding) {
+				glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, 0);
+			}
+			glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, 0);
+			glDeleteBuffers(2, compaction_lists);
+			glDeleteBuffers(1, &compaction_dispatch);
+			compaction_lists[0] = compaction_lists[1] = 0;
+			compaction_dispatch = 0;
 		}
+	};
+	// orbits that run out at the limit are kept to continue the render later
+	if (m_pre_render_resume_list) {
+		glDeleteBuffers(1, &m_pre_render_resume_list);
+		m_pre_render_resume_list = 0;
 	}
-	else if (m_currentFractal == FractalType::NOVA) {
-		if (m_use_pre_render_params) {
-			workerShader->setDVec2("u_center", m_pre_render_center_x, m_pre_render_center_y);
-			workerShader->setDouble("u_zoom", m_pre_render_zoom_threshold);
-			workerShader->setDouble("u_power", m_pre_render_nova_power);
-			workerShader->setDouble("u_relaxation", m_pre_render_nova_relaxation);
+	m_pre_render_resume_count.store(0);
+	m_pre_render_resume_iterations.store(0);
+	if (dispatch_shader) {
+		const GLuint zero = 0;
+		glCreateBuffers(1, &m_pre_render_resume_list);
+		glNamedBufferStorage(m_pre_render_resume_list, PRE_RENDER_COMPACTION_HEADER_BYTES + (GLsizeiptr)PRE_RENDER_RESUME_CAPACITY * PRE_RENDER_COMPACTION_ORBIT_BYTES,
+			nullptr, GL_DYNAMIC_STORAGE_BIT);
+		glClearNamedBufferSubData(m_pre_render_resume_list, GL_R32UI, 0, sizeof(GLuint), GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+	}
+	auto compactTile = [&](const ScheduledTile& tile) {
+		// the last tile's passes are done with the lists before the first pass of this one appends to them
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+		runCompactionPasses(compute_shader, dispatch_shader, compaction_lists, 0, 0, tile.width * tile.height, m_pre_render_resume_list);
+	};
+	bool gpu_active = use_gpu;
+	// tiles stay queued on the gpu while this thread hands out the next ones, it only blocks once the window is full
+	FenceRing fence_ring;
+	std::vector<ScheduledTile> in_flight(PRE_RENDER_MAX_TILES_IN_FLIGHT);
+	if (use_gpu && !fence_ring.create(PRE_RENDER_MAX_TILES_IN_FLIGHT, PRE_RENDER_QUEUE_TARGET_MS)) {
+		// without timer queries the window cannot follow the tile time, the cpu threads take every tile if there are any
+		fence_ring.release();
+		gpu_active = false;
+		if (!cpu_renderer) {
+			spdlog::critical("Worker thread: could not create the tile fence ring, the GPU-only pre-render cannot run!");
+			glDisable(GL_SCISSOR_TEST);
+			releaseQueue();
+			return false;
 		}
-		else {
-			workerShader->setDVec2("u_center", 0.0, 0.0);
-			workerShader->setDouble("u_zoom", 0.5);
-			workerShader->setDouble("u_power", 3.0);
-			workerShader->setDouble("u_relaxation", 1.0);
+		spdlog::error("Worker thread: could not create the tile fence ring, the CPU threads take every tile.");
+	}
+	auto retireTile = [&](int slot, float gpu_ms) {
+		m_profiler.recordTile(true, gpu_ms);
+		scheduler.complete(in_flight[slot]);
+	};
+	// tiles are only submitted while the ring is not full, so begin() always has a slot for them
+	auto submitTile = [&](const ScheduledTile& tile, const std::function<void()>& draw) {
+		const int slot = fence_ring.begin();
+		SDL_assert(slot >= 0);
+		in_flight[slot] = tile;
+		draw();
+		fence_ring.end();
+	};
+	for (;;) {
+		if (m_cancel_pre_render.load()) {
+			scheduler.cancel();
+			if (cpu_renderer) {
+				cpu_renderer->cancel();
+				cpu_renderer->finish();
+			}
+			glDisable(GL_SCISSOR_TEST);
+			fence_ring.release();
+			releaseQueue();
+			return false;
 		}
-		if (!m_apply_common_color_palette) {
-			workerShader->setVec3("u_palette_a", m_palette_nova_a.x, m_palette_nova_a.y, m_palette_nova_a.z);
-			workerShader->setVec3("u_palette_b", m_palette_nova_b.x, m_palette_nova_b.y, m_palette_nova_b.z);
-			workerShader->setVec3("u_palette_c", m_palette_nova_c.x, m_palette_nova_c.y, m_palette_nova_c.z);
-			workerShader->setVec3("u_palette_d", m_palette_nova_d.x, m_palette_nova_d.y, m_palette_nova_d.z);
+		while (fence_ring.retire(0, retireTile)) {
 		}
-		else {
-			workerShader->setVec3("u_palette_a", m_palette_a.x, m_palette_a.y, m_palette_a.z);
-			workerShader->setVec3("u_palette_b", m_palette_b.x, m_palette_b.y, m_palette_b.z);
-			workerShader->setVec3("u_palette_c", m_palette_c.x, m_palette_c.y, m_palette_c.z);
-			workerShader->setVec3("u_palette_d", m_palette_d.x, m_palette_d.y, m_palette_d.z);
+		while (cpu_renderer && cpu_renderer->pollTile(cpu_tile)) {
+			uploadCpuTile();
+		}
+		m_pre_render_tiles_done.store(scheduler.completed());
+		ScheduledTile tile;
+		if (gpu_active && !fence_ring.full()) {
+			if (scheduler.acquire(0, tile)) {
+				glViewport(tile.x, tile.y, tile.width, tile.height);
+				glScissor(tile.x, tile.y, tile.width, tile.height);
+				if (dispatch_shader) {
+					compute_shader->setIVec4(compute_tile_info, tile.x, tile.y, tile.width, tile.height);
+					submitTile(tile, [&]() { compactTile(tile); });
+					continue;
+				}
+				if (compute_shader) {
+					compute_shader->setIVec4(compute_tile_info, tile.x, tile.y, tile.width, tile.height);
+					// the previous tile's atomics land before the counter goes back to 0
+					glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+					const GLuint zero = 0;
+					glClearNamedBufferData(queue_buffer, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+					const int pixels = tile.width * tile.height;
+					const int groups = std::min(PRE_RENDER_PERSISTENT_GROUPS, (pixels + PRE_RENDER_PERSISTENT_GROUP_PIXELS - 1) / PRE_RENDER_PERSISTENT_GROUP_PIXELS);
+					submitTile(tile, [&]() { glDispatchCompute((GLuint)groups, 1, 1); });
+					continue;
+				}
+				shader->setIVec4(tile_info, tile.x, tile.y, tile.width, tile.height);
+				submitTile(tile, [&]() { glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0); });
+				continue;
+			}
+			gpu_active = false;
 		}
+		if (!fence_ring.empty()) {
+			// wait in short slices and upload finished cpu tiles in between
+			fence_ring.retire(cpu_renderer ? 1'000'000 : 5'000'000, retireTile);
+			continue;
+		}
+		// no tile left for the gpu, drain whatever the cpu threads still produce
+		if (!cpu_renderer || !cpu_renderer->waitTile(cpu_tile)) {
+			break;
+		}
+		uploadCpuTile();
 	}
-	else if (m_currentFractal == FractalType::MULTIBROT) {
-		if (m_use_pre_render_params) {
-			workerShader->setDVec2("u_center", m_pre_render_center_x, m_pre_render_center_y);
-			workerShader->setDouble("u_zoom", m_pre_render_zoom_threshold);
-			workerShader->setDouble("u_power", m_pre_render_multibrot_power);
+	if (cpu_renderer) {
+		cpu_renderer->finish();
+	}
+	glDisable(GL_SCISSOR_TEST);
+	if (use_gpu) {
+		spdlog::info("Worker thread: GPU tiles took {:.2f} ms, {} kept in flight.", fence_ring.drawMs(), fence_ring.depth());
+	}
+	fence_ring.release();
+	releaseQueue();
+	if (m_pre_render_resume_list && !m_cancel_pre_render.load()) {
+		// waits for the last tiles, the render is over by now anyway
+		GLuint kept = 0;
+		glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+		glGetNamedBufferSubData(m_pre_render_resume_list, 0, sizeof(GLuint), &kept);
+		if (kept > (GLuint)PRE_RENDER_RESUME_CAPACITY) {
+			spdlog::warn("Worker thread: {} orbits ran out at {} iterations, more than the {} kept to continue the render.", kept,
+				m_pre_render_iterations, PRE_RENDER_RESUME_CAPACITY);
+			glDeleteBuffers(1, &m_pre_render_resume_list);
+			m_pre_render_resume_list = 0;
 		}
 		else {
-			workerShader->setDVec2("u_center", 0.0, 0.0);
-			workerShader->setDouble("u_zoom", 0.5);
-			workerShader->setDouble("u_power", 3.0);
+			spdlog::info("Worker thread: {} orbits ran out at {} iterations and are kept to continue the render.", kept, m_pre_render_iterations);
+			m_pre_render_resume_count.store((int)kept);
+			m_pre_render_resume_iterations.store(m_pre_render_iterations);
 		}
-		if (!m_apply_common_color_palette) {
-			workerShader->setVec3("u_palette_a", m_palette_mandelbrot_a.x, m_palette_mandelbrot_a.y, m_palette_mandelbrot_a.z);
-			workerShader->setVec3("u_palette_b", m_palette_mandelbrot_b.x, m_palette_mandelbrot_b.y, m_palette_mandelbrot_b.z);
-			workerShader->setVec3("u_palette_c", m_palette_mandelbrot_c.x, m_palette_mandelbrot_c.y, m_palette_mandelbrot_c.z);
-			workerShader->setVec3("u_palette_d", m_palette_mandelbrot_d.x, m_palette_mandelbrot_d.y, m_palette_mandelbrot_d.z);
+	}
+	m_pre_render_tiles_done.store(scheduler.completed());
+	spdlog::info("Worker thread: {} of {} tiles done, {} stolen between workers.", scheduler.completed(), scheduler.total(), scheduler.stolen());
+	return !m_cancel_pre_render.load();
+}
+
+// times the kernel over a coarse grid of cells, each drawn at a fraction of its resolution into a scratch target. the
+// estimate scales the probe time by the skipped pixels after taking off
+// the cost every draw has, it errs high since a probe draw does not fill the gpu, which only makes tiles smaller
+bool Application::probeTileCost(Shader* shader, TileCostMap& cost)
+{
+	const int resolution = m_pre_render_resolution;
+	const int cell_size = std::max(PRE_RENDER_MIN_TILE, (resolution + PRE_RENDER_PROBE_CELLS - 1) / PRE_RENDER_PROBE_CELLS);
+	cost.cell_size = cell_size;
+	cost.cells_x = (resolution + cell_size - 1) / cell_size;
+	cost.cells_y = cost.cells_x;
+	const int cell_count = cost.cells_x * cost.cells_y;
+	// the probe draws into a scratch g-buffer of one probe cell, the real one only ever receives finished tiles
+	const int probe_size = (cell_size + PRE_RENDER_PROBE_SCALE - 1) / PRE_RENDER_PROBE_SCALE;
+	GLint target_fbo = 0;
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &target_fbo);
+	GLuint scratch_fbo = 0;
+	GLuint scratch_textures[2] = { 0, 0 };
+	const GLenum scratch_formats[2] = { GL_R32F, GL_RGBA8 };
+	glGenFramebuffers(1, &scratch_fbo);
+	glGenTextures(2, scratch_textures);
+	glBindFramebuffer(GL_FRAMEBUFFER, scratch_fbo);
+	for (int k = 0; k < 2; ++k) {
+		glBindTexture(GL_TEXTURE_2D, scratch_textures[k]);
+		glTexStorage2D(GL_TEXTURE_2D, 1, scratch_formats[k], probe_size, probe_size);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + k, GL_TEXTURE_2D, scratch_textures[k], 0);
+	}
+	const GLenum scratch_attachments[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+	glDrawBuffers(2, scratch_attachments);
+	auto releaseScratch = [&]() {
+		glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)target_fbo);
+		glDeleteFramebuffers(1, &scratch_fbo);
+		glDeleteTextures(2, scratch_textures);
+	};
+
+	std::vector<GLuint> queries(cell_count);
+	glGenQueries(cell_count, queries.data());
+	const Shader::Uniform tile_info = shader->uniform("u_tile_info");
+	shader->setIVec2("u_image_size", resolution, resolution);
+	for (int cell = 0; cell < cell_count; ++cell) {
+		const int x = (cell % cost.cells_x) * cell_size;
+		const int y = (cell / cost.cells_x) * cell_size;
+		const int width = std::min(cell_size, resolution - x);
+		const int height = std::min(cell_size, resolution - y);
+		const int probe_w = (width + PRE_RENDER_PROBE_SCALE - 1) / PRE_RENDER_PROBE_SCALE;
+		const int probe_h = (height + PRE_RENDER_PROBE_SCALE - 1) / PRE_RENDER_PROBE_SCALE;
+		glViewport(0, 0, probe_w, probe_h);
+		glScissor(0, 0, probe_w, probe_h);
+		shader->setIVec4(tile_info, x, y, width, height);
+		glBeginQuery(GL_TIME_ELAPSED, queries[cell]);
+		glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+		glEndQuery(GL_TIME_ELAPSED);
+	}
+	glFlush();
+	// the draws finish in order, so once the last result is available every one is and they are read in one go. polling
+	// it instead of a blocking read keeps a cancel responsive while the probe is still on the gpu
+	GLint available = 0;
+	for (;;) {
+		if (m_cancel_pre_render.load()) {
+			glDeleteQueries(cell_count, queries.data());
+			releaseScratch();
+			cost = TileCostMap{};
+			return false;
 		}
-		else {
-			workerShader->setVec3("u_palette_a", m_palette_a.x, m_palette_a.y, m_palette_a.z);
-			workerShader->setVec3("u_palette_b", m_palette_b.x, m_palette_b.y, m_palette_b.z);
-			workerShader->setVec3("u_palette_c", m_palette_c.x, m_palette_c.y, m_palette_c.z);
-			workerShader->setVec3("u_palette_d", m_palette_d.x, m_palette_d.y, m_palette_d.z);
+		glGetQueryObjectiv(queries[cell_count - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (available) {
+			break;
 		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
 	}
-	else if (m_currentFractal == FractalType::SPIDER) {
-		if (m_use_pre_render_params) {
-			workerShader->setDVec2("u_center", m_pre_render_center_x, m_pre_render_center_y);
-			workerShader->setDouble("u_zoom", m_pre_render_zoom_threshold);
+	std::vector<float> probe_ms(cell_count);
+	for (int cell = 0; cell < cell_count; ++cell) {
+		GLuint64 elapsed_ns = 0;
+		glGetQueryObjectui64v(queries[cell], GL_QUERY_RESULT, &elapsed_ns);
+		probe_ms[cell] = (float)((double)elapsed_ns / 1.0e6);
+	}
+	releaseScratch();
+	glDeleteQueries(cell_count, queries.data());
+	const float overhead_ms = *std::min_element(probe_ms.begin(), probe_ms.end());
+	const float pixel_ratio = (float)(PRE_RENDER_PROBE_SCALE * PRE_RENDER_PROBE_SCALE);
+	cost.cell_ms.resize(cell_count);
+	for (int cell = 0; cell < cell_count; ++cell) {
+		cost.cell_ms[cell] = (probe_ms[cell] - overhead_ms) * pixel_ratio;
+	}
+	return true;
+}
+
+void Application::startExport()
+{
+	std::lock_guard<std::mutex> lock(m_export_mutex);
+	if (m_export_state.load() == ExportState::RUNNING) {
+		return;
+	}
+	if (m_export_thread.joinable()) {
+		m_export_thread.join();
+	}
+	const int resolution = std::clamp(m_export_resolution, EXPORT_TILE_SIZE, EXPORT_MAX_RESOLUTION);
+	m_export_resolution = resolution;
+	m_cancel_export.store(false);
+	m_export_tiles_done.store(0);
+	m_export_tiles_total.store(0);
+	m_export_state.store(ExportState::RUNNING);
+	// the view and the colouring are taken as they are on screen now, edits during the export do not tear the image
+	ExportJob job;
+	job.path = m_export_path;
+	job.resolution = resolution;
+	job.kernel_path = preRenderKernelPath(resolution);
+	job.view = preRenderView();
+	job.color_state = colorizeState();
+	// deep mandelbrot views come from the cpu perturbation engine, the fp64 kernel only shows blocks there
+	job.deep = buildCpuPreRenderParams(job.deep_params, false) && preRenderReferenceCenter(job.deep_params, job.deep_center_x, job.deep_center_y);
+	job.deep_params.width = resolution;
+	job.deep_params.height = resolution;
+	job.deep_params.subdivision = CpuSubdivision::OFF;
+	m_export_thread = std::thread(&Application::exportWorker, this, std::move(job));
+}
+
+void Application::stopExport()
+{
+	std::lock_guard<std::mutex> lock(m_export_mutex);
+	if (m_export_thread.joinable()) {
+		m_cancel_export.store(true);
+		m_export_thread.join();
+	}
+}
+
+// renders the pre-render view tile by tile on the worker context and streams it into a png, host memory stays at a
+// few rows of tiles however large the image is
+void Application::exportWorker(ExportJob job)
+{
+	const std::string& path = job.path;
+	const int resolution = job.resolution;
+	// the last column and the top row of tiles are cut to the image
+	const int tiles = (resolution + EXPORT_TILE_SIZE - 1) / EXPORT_TILE_SIZE;
+	struct TileRect { int x, y, width, height; };
+	// the png starts at the top, so does the export: tile 0 is the top left one
+	auto tileRect = [&](int tile) {
+		const int x = (tile % tiles) * EXPORT_TILE_SIZE;
+		const int y = (tiles - 1 - tile / tiles) * EXPORT_TILE_SIZE;
+		return TileRect{ x, y, std::min(EXPORT_TILE_SIZE, resolution - x), std::min(EXPORT_TILE_SIZE, resolution - y) };
+	};
+	m_export_tiles_total.store(tiles * tiles);
+	m_shaders.waitForPrecompile();
+	// the reference orbit is the slow part of a deep view, it is iterated here rather than on the main thread
+	CpuRenderParams& deep_params = job.deep_params;
+	if (job.deep) {
+		deep_params.reference = computeReferenceOrbit(job.deep_center_x, job.deep_center_y, deep_params.zoom, deep_params.max_iterations, &m_cancel_export);
+	}
+	const bool deep = deep_params.reference != nullptr;
+	// the detail pages hand the context back between batches
+	std::lock_guard<std::mutex> context_lock(m_worker_context_mutex);
+	if (SDL_GL_MakeCurrent(window, m_worker_context) != 0) {
+		spdlog::error("Export: could not set GL context! Error: {}", SDL_GetError());
+		m_export_state.store(ExportState::FAILED);
+		return;
+	}
+	spdlog::info("Export: {}x{} ({} tiles) to {}", resolution, resolution, tiles * tiles, path);
+	Shader* kernel = job.kernel_path.empty() ? nullptr : m_shaders.get("shaders/prerender.vert", job.kernel_path.c_str());
+	// a program of its own: the viewer keeps colouring with the shared one on the main thread and uniform values are per program
+	Shader colorize("shaders/simple.vert", "shaders/colorize.frag");
+
+	GLuint vao = 0;
+	glGenVertexArrays(1, &vao);
+	glBindVertexArray(vao);
+	glBindBuffer(GL_ARRAY_BUFFER, VBO_vertices);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
+	glEnableVertexAttribArray(1);
+
+	// one tile of g-buffer for the kernel and one tile of colour for the read back
+	GLuint fbos[2] = { 0, 0 };
+	GLuint textures[3] = { 0, 0, 0 };
+	const GLenum formats[3] = { GL_R32F, GL_RGBA8, GL_RGBA8 };
+	glGenFramebuffers(2, fbos);
+	glGenTextures(3, textures);
+	for (int k = 0; k < 3; ++k) {
+		glBindTexture(GL_TEXTURE_2D, textures[k]);
+		glTexStorage2D(GL_TEXTURE_2D, 1, formats[k], EXPORT_TILE_SIZE, EXPORT_TILE_SIZE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, fbos[0]);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[0], 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, textures[1], 0);
+	const GLenum gbuffer_attachments[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+	glDrawBuffers(2, gbuffer_attachments);
+	bool ok = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+	glBindFramebuffer(GL_FRAMEBUFFER, fbos[1]);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[2], 0);
+	ok = ok && glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+	if (!ok) {
+		spdlog::error("Export: tile framebuffers are not complete!");
+	}
+	// deep tiles are iterated on the cpu against the reference orbit and go through the same colour pass. one render over the
+	// whole image deals them to the threads in export order, they finish out of order and the ones ahead of the tile the
+	// colour pass needs next wait in deep_arrived
+	std::unique_ptr<TileScheduler> deep_scheduler;
+	std::unique_ptr<CpuRenderer> deep_renderer;
+	std::map<int, CpuTile> deep_arrived;
+	ok = ok && colorize.ID != 0 && (deep || (kernel != nullptr && kernel->ID != 0 && setPreRenderUniforms(kernel, job.view)));
+	if (ok && deep) {
+		deep_renderer = std::make_unique<CpuRenderer>();
+		deep_scheduler = std::make_unique<TileScheduler>(deep_renderer->threadCount());
+		std::vector<ScheduledTile> export_tiles(tiles * tiles);
+		for (int tile = 0; tile < tiles * tiles; ++tile) {
+			const TileRect rect = tileRect(tile);
+			ScheduledTile& scheduled = export_tiles[tile];
+			scheduled.x = rect.x;
+			scheduled.y = rect.y;
+			scheduled.width = rect.width;
+			scheduled.height = rect.height;
+			scheduled.grid_x = rect.x / EXPORT_TILE_SIZE;
+			scheduled.grid_y = rect.y / EXPORT_TILE_SIZE;
+			scheduled.priority = (double)tile;
 		}
-		else {
-			workerShader->setDVec2("u_center", 0.0, 0.0);
-			workerShader->setDouble("u_zoom", 0.5);
+		deep_scheduler->reset(std::move(export_tiles));
+		deep_renderer->begin(deep_params, *deep_scheduler);
+		spdlog::info("Export: deep view, tiles are iterated on {} cpu threads against the reference orbit.", deep_renderer->threadCount());
+	}
+	setColorizeUniforms(&colorize, job.color_state);
+
+	// the kernels run ahead, read backs follow EXPORT_READBACK_SLOTS tiles behind them and the encoder thread a band behind those
+	ReadbackRing readback;
+	PngBandEncoder encoder;
+	ok = ok && readback.create(EXPORT_READBACK_SLOTS, EXPORT_TILE_SIZE, EXPORT_TILE_SIZE);
+	ok = ok && encoder.open(path, resolution, resolution, EXPORT_ENCODE_DEPTH);
+	std::deque<std::vector<unsigned char>> bands; // rows of tiles still being filled, oldest first
+	int band_tiles_copied = 0;
+	const size_t band_stride = (size_t)resolution * 4;
+	// read backs retire in submission order, so the front band is always the one the tile belongs to
+	auto copyTile = [&](int tile, const unsigned char* pixels) {
+		const TileRect rect = tileRect(tile);
+		const size_t tile_stride = (size_t)rect.width * 4;
+		unsigned char* dst = bands.front().data() + (size_t)rect.x * 4;
+		for (int row = 0; row < rect.height; ++row) {
+			std::memcpy(dst + row * band_stride, pixels + row * tile_stride, tile_stride);
 		}
-		if (!m_apply_common_color_palette) {
-			workerShader->setVec3("u_palette_a", m_palette_spider_a.x, m_palette_spider_a.y, m_palette_spider_a.z);
-			workerShader->setVec3("u_palette_b", m_palette_spider_b.x, m_palette_spider_b.y, m_palette_spider_b.z);
-			workerShader->setVec3("u_palette_c", m_palette_spider_c.x, m_palette_spider_c.y, m_palette_spider_c.z);
-			workerShader->setVec3("u_palette_d", m_palette_spider_d.x, m_palette_spider_d.y, m_palette_spider_d.z);
+		m_export_tiles_done.fetch_add(1);
+		if (++band_tiles_copied == tiles) {
+			encoder.submit(std::move(bands.front()));
+			bands.pop_front();
+			band_tiles_copied = 0;
+		}
+	};
+	// uploads the deep tile from the cpu render, earlier reads are retired while it is still being iterated. false when the
+	// render stopped without it
+	auto uploadDeepTile = [&](int tile, const TileRect& rect) {
+		CpuTile done;
+		for (;;) {
+			// a render seen stopped before the poll has nothing left to hand over after it
+			const bool stopped = !deep_renderer->running();
+			while (deep_renderer->pollTile(done)) {
+				const int index = (tiles - 1 - done.y / EXPORT_TILE_SIZE) * tiles + done.x / EXPORT_TILE_SIZE;
+				deep_arrived[index] = std::move(done);
+			}
+			if (deep_arrived.count(tile) != 0 || stopped || !ok || m_cancel_export.load()) {
+				break;
+			}
+			if (!readback.empty()) {
+				ok = readback.retire(copyTile, &m_cancel_export) && ok;
+			}
+			else {
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+		}
+		const auto found = deep_arrived.find(tile);
+		if (found == deep_arrived.end()) {
+			return false;
+		}
+		glBindTexture(GL_TEXTURE_2D, textures[0]);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, rect.width, rect.height, GL_RED, GL_FLOAT, found->second.values.data());
+		glBindTexture(GL_TEXTURE_2D, textures[1]);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, rect.width, rect.height, GL_RGBA, GL_UNSIGNED_BYTE, found->second.pixels.data());
+		deep_arrived.erase(found);
+		return true;
+	};
+	const Shader::Uniform tile_info = kernel ? kernel->uniform("u_tile_info") : Shader::Uniform{};
+	if (kernel) {
+		kernel->setIVec2("u_image_size", resolution, resolution);
+	}
+	bool cancelled = false;
+	for (int tile = 0; ok && tile < tiles * tiles; ++tile) {
+		if (m_cancel_export.load()) {
+			cancelled = true;
+			break;
+		}
+		const TileRect rect = tileRect(tile);
+		if (rect.x == 0) {
+			ok = !encoder.failed();
+			bands.push_back(encoder.acquire(rect.height));
+		}
+		// edge tiles only use the bottom left of the tile textures, the colour pass reads them 1:1
+		glViewport(0, 0, rect.width, rect.height);
+		if (deep) {
+			if (!uploadDeepTile(tile, rect)) {
+				cancelled = m_cancel_export.load();
+				ok = false;
+				break;
+			}
 		}
 		else {
-			workerShader->setVec3("u_palette_a", m_palette_a.x, m_palette_a.y, m_palette_a.z);
-			workerShader->setVec3("u_palette_b", m_palette_b.x, m_palette_b.y, m_palette_b.z);
-			workerShader->setVec3("u_palette_c", m_palette_c.x, m_palette_c.y, m_palette_c.z);
-			workerShader->setVec3("u_palette_d", m_palette_d.x, m_palette_d.y, m_palette_d.z);
+			glBindFramebuffer(GL_FRAMEBUFFER, fbos[0]);
+			kernel->use();
+			kernel->setIVec4(tile_info, rect.x, rect.y, rect.width, rect.height);
+			glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+		}
+		glBindFramebuffer(GL_FRAMEBUFFER, fbos[1]);
+		colorize.use();
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, textures[0]);
+		glActiveTexture(GL_TEXTURE1);
+		glBindTexture(GL_TEXTURE_2D, textures[1]);
+		glActiveTexture(GL_TEXTURE0);
+		glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+		// the slot this read needs was filled EXPORT_READBACK_SLOTS tiles ago, mapping it rarely waits
+		if (readback.full() && !readback.retire(copyTile, &m_cancel_export)) {
+			ok = false;
+			break;
 		}
+		readback.read(0, 0, rect.width, rect.height, tile);
+	}
+	if (deep_renderer) {
+		deep_renderer->cancel();
+		deep_renderer->finish();
+	}
+	while (ok && !cancelled && !readback.empty()) {
+		ok = readback.retire(copyTile, &m_cancel_export);
+	}
+	// a cancel can also end the run inside a read back wait
+	cancelled = cancelled || (!ok && m_cancel_export.load());
+	readback.release();
+	// an unfinished file is removed by the writer
+	ok = encoder.close() && ok && !cancelled;
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glDeleteFramebuffers(2, fbos);
+	glDeleteTextures(3, textures);
+	glDeleteVertexArrays(1, &vao);
+	if (colorize.ID != 0) {
+		glDeleteProgram(colorize.ID);
+	}
+	glFinish();
+	SDL_GL_MakeCurrent(window, nullptr);
+
+	if (cancelled) {
+		spdlog::warn("Export: cancelled after {} of {} tiles.", m_export_tiles_done.load(), tiles * tiles);
+		m_export_state.store(ExportState::CANCELLED);
+	}
+	else if (ok) {
+		spdlog::info("Export: wrote {}", path);
+		m_export_state.store(ExportState::DONE);
 	}
 	else {
-		spdlog::critical("Worker thread: No fractals selected, pre-render aborted ...");
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
-		glDeleteTextures(1, &m_pre_render_texture);
-		glDeleteFramebuffers(1, &m_pre_render_fbo);
-		glDeleteVertexArrays(1, &workerVAO);
-		delete workerShader;
-		m_worker_finished_submission.store(true);
-		return;
+		spdlog::error("Export: failed, nothing was written to {}", path);
+		m_export_state.store(ExportState::FAILED);
 	}
-	// tiled rendering parameters
-	const int TILE_SIZE = 256;
-	const int BATCH_SIZE = 4;
-	const int num_tiles = m_pre_render_resolution / TILE_SIZE;
-	int batch_counter = 0;
-	glEnable(GL_SCISSOR_TEST);
-	for (int tile_y = 0; tile_y < num_tiles; ++tile_y) {
-		for (int tile_x = 0; tile_x < num_tiles; ++tile_x) {
-			if (m_cancel_pre_render.load()) {
-				spdlog::warn("Worker thread: pre-render cancelled by user.");
-				glBindFramebuffer(GL_FRAMEBUFFER, 0);
-				SDL_GL_MakeCurrent(window, nullptr);
-				m_worker_finished_submission.store(true);
-				return;
+}
+
+// moves the mandelbrot centre by a view space delta, the addition happens in BigFloat so tiny steps are never lost
+void Application::panMandelbrot(double dx, double dy)
+{
+	syncMandelbrotCenter();
+	m_mandel_deep_center_x += BigFloat::fromDouble(dx);
+	m_mandel_deep_center_y += BigFloat::fromDouble(dy);
+	m_mandel_center_x = m_mandel_center_mirror_x = m_mandel_deep_center_x.toDouble();
+	m_mandel_center_y = m_mandel_center_mirror_y = m_mandel_deep_center_y.toDouble();
+}
+
+// the double centre is shared with the other fractals, adopt it whenever something other than panMandelbrot changed it
+void Application::syncMandelbrotCenter()
+{
+	if (m_mandel_center_x != m_mandel_center_mirror_x) {
+		m_mandel_deep_center_x = BigFloat::fromDouble(m_mandel_center_x);
+		m_mandel_center_mirror_x = m_mandel_center_x;
+	}
+	if (m_mandel_center_y != m_mandel_center_mirror_y) {
+		m_mandel_deep_center_y = BigFloat::fromDouble(m_mandel_center_y);
+		m_mandel_center_mirror_y = m_mandel_center_y;
+	}
+}
+
+// deep zoom path of the live mandelbrot view, false while no reference orbit is available yet
+// uploads a reference orbit the background computation finished, the live view restarts on the new orbit
+void Application::pollReferenceOrbit()
+{
+	if (m_reference_future.valid() && m_reference_future.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+		std::shared_ptr<ReferenceOrbit> reference = m_reference_future.get();
+		if (reference) {
+			if (m_reference_orbit_ssbo == 0) {
+				glGenBuffers(1, &m_reference_orbit_ssbo);
 			}
-			int x_pos = tile_x * TILE_SIZE;
-			int y_pos = tile_y * TILE_SIZE;
-			glViewport(x_pos, y_pos, TILE_SIZE, TILE_SIZE);
-			glScissor(x_pos, y_pos, TILE_SIZE, TILE_SIZE);
-			workerShader->setIVec4("u_tile_info", tile_x, tile_y, num_tiles, num_tiles);
-			glBindVertexArray(workerVAO);
-			glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-			glFlush();
-			GLsync tileFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
-			GLenum waitRes;
-			do {
-				waitRes = glClientWaitSync(tileFence, GL_SYNC_FLUSH_COMMANDS_BIT, 5'000'000);
-			} while (waitRes == GL_TIMEOUT_EXPIRED);
-			glDeleteSync(tileFence);
-			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_reference_orbit_ssbo);
+			glBufferData(GL_SHADER_STORAGE_BUFFER, reference->points.size() * sizeof(double), reference->points.data(), GL_STATIC_DRAW);
+			// the shader declares the table either way, an empty one still gets a (dummy) buffer
+			if (m_bla_ssbo == 0) {
+				glGenBuffers(1, &m_bla_ssbo);
+			}
+			const std::vector<double>& bla_entries = reference->bla.entries;
+			const double empty_entry[6] = {};
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_bla_ssbo);
+			glBufferData(GL_SHADER_STORAGE_BUFFER, bla_entries.empty() ? sizeof(empty_entry) : bla_entries.size() * sizeof(double),
+				bla_entries.empty() ? empty_entry : bla_entries.data(), GL_STATIC_DRAW);
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+			m_reference_orbit = reference;
+			spdlog::info("Reference orbit ready: {} iterations{}, {} bla levels.", reference->length() - 1, reference->escaped ? " (escaped)" : "", reference->bla.levels());
 		}
 	}
-	spdlog::info("Worker thread: All tiles rendered.");
-	spdlog::info("Worker thread: Generating mipmaps...");
+}
+
+bool Application::drawMandelbrotPerturbed(int drawable_w, int drawable_h, int max_iterations)
+{
+	double offset_x = 0.0;
+	double offset_y = 0.0;
+	if (m_reference_orbit) {
+		offset_x = (m_mandel_deep_center_x - m_reference_orbit->center_x).toDouble();
+		offset_y = (m_mandel_deep_center_y - m_reference_orbit->center_y).toDouble();
+	}
+	// the old orbit keeps rendering (rebasing keeps it correct) while the replacement is computed in the background
+	if (!m_reference_future.valid() && (!m_reference_orbit || !referenceOrbitUsable(*m_reference_orbit, offset_x, offset_y, m_mandel_zoom, max_iterations))) {
+		m_cancel_reference.store(false);
+		m_reference_future = std::async(std::launch::async, computeReferenceOrbit, m_mandel_deep_center_x, m_mandel_deep_center_y,
+			m_mandel_zoom, max_iterations, &m_cancel_reference);
+	}
+	if (!m_reference_orbit) {
+		return false;
+	}
+
+	if (m_perturb_shader == nullptr) {
+		m_perturb_shader = m_shaders.get("shaders/mandelbrot.vert", "shaders/mandelbrot_perturb.frag");
+	}
+	const ImVec4* palette[4] = { &m_palette_a, &m_palette_b, &m_palette_c, &m_palette_d };
+	if (!m_apply_common_color_palette) {
+		palette[0] = &m_palette_mandelbrot_a;
+		palette[1] = &m_palette_mandelbrot_b;
+		palette[2] = &m_palette_mandelbrot_c;
+		palette[3] = &m_palette_mandelbrot_d;
+	}
+	m_perturb_shader->use();
+	m_perturb_shader->setVec2("iResolution", (float)drawable_w, (float)drawable_h);
+	m_perturb_shader->setDouble("u_zoom", m_mandel_zoom);
+	m_perturb_shader->setDVec2("u_reference_offset", offset_x, offset_y);
+	m_perturb_shader->setInt("u_orbit_length", m_reference_orbit->length());
+	// the bla radii only hold for |dc| up to the c_max the table was built for, a stale reference renders without it
+	const BlaTable& bla = m_reference_orbit->bla;
+	const double aspect = (double)drawable_w / (double)drawable_h;
+	const double dc_max = std::hypot(offset_x, offset_y) + std::hypot(aspect, 1.0) / m_mandel_zoom;
+	const bool use_bla = m_mandel_zoom >= BLA_MIN_ZOOM && bla.levels() > 0 && dc_max <= bla.c_max;
+	m_perturb_shader->setInt("u_bla_levels", use_bla ? std::min(bla.levels(), 32) : 0);
+	if (use_bla) {
+		m_perturb_shader->setIntArray("u_bla_offset", bla.level_offsets.data(), std::min(bla.levels(), 32));
+		m_perturb_shader->setIntArray("u_bla_count", bla.level_counts.data(), std::min(bla.levels(), 32));
+	}
+	m_perturb_shader->setInt("u_max_iterations", max_iterations);
+	m_perturb_shader->setFloat("u_color_density", m_color_density);
+	m_perturb_shader->setVec3("u_palette_a", palette[0]->x, palette[0]->y, palette[0]->z);
+	m_perturb_shader->setVec3("u_palette_b", palette[1]->x, palette[1]->y, palette[1]->z);
+	m_perturb_shader->setVec3("u_palette_c", palette[2]->x, palette[2]->y, palette[2]->z);
+	m_perturb_shader->setVec3("u_palette_d", palette[3]->x, palette[3]->y, palette[3]->z);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_reference_orbit_ssbo);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_bla_ssbo);
+	glBindVertexArray(VAO);
+	glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+	return true;
+}
+
+bool Application::useDf64(double zoom, int pixels) const
+{
+	const bool selected = m_shader_precision == ShaderPrecision::DF64 ||
+		(m_shader_precision == ShaderPrecision::AUTO && m_precision_benchmark.df64Faster());
+	return selected && df64Usable(zoom, pixels);
+}
+
+// everything the menu, the real-time views and the pre-render can ask for, in roughly the order they are needed
+void Application::queueShaderPrograms()
+{
+	m_shaders.add("shaders/background.vert", "shaders/background.frag");
+	m_shaders.add("shaders/simple.vert", "shaders/loading_screen.frag");
+	m_shaders.add("shaders/simple.vert", "shaders/texture_view.frag");
+	m_shaders.add("shaders/simple.vert", "shaders/colorize.frag");
+	m_shaders.add("shaders/simple.vert", "shaders/upscale.frag");
+	const char* const live_kernels[][2] = {
+		{ "shaders/mandelbrot.vert", "shaders/mandelbrot.frag" },
+		{ "shaders/julia.vert", "shaders/julia.frag" },
+		{ "shaders/burningship.vert", "shaders/burningship.frag" },
+		{ "shaders/tricorn.vert", "shaders/tricorn.frag" },
+		{ "shaders/phoenix.vert", "shaders/phoenix.frag" },
+		{ "shaders/lyapunov.vert", "shaders/lyapunov.frag" },
+		{ "shaders/newton.vert", "shaders/newton.frag" },
+		{ "shaders/multibrot.vert", "shaders/multibrot.frag" },
+		{ "shaders/nova.vert", "shaders/nova.frag" },
+		{ "shaders/spider.vert", "shaders/spider.frag" },
+	};
+	for (const auto& kernel : live_kernels) {
+		m_shaders.add(kernel[0], kernel[1]);
+		const std::string df64_path = df64FragmentPath(kernel[1]);
+		if (!df64_path.empty()) {
+			m_shaders.add(kernel[0], df64_path);
+		}
+	}
+	m_shaders.add("shaders/mandelbrot.vert", "shaders/mandelbrot_perturb.frag");
+	const char* const pre_render_kernels[] = {
+		"shaders/mandelbrot_prerender.frag", "shaders/julia_prerender.frag", "shaders/burning_ship_prerender.frag",
+		"shaders/tricorn_prerender.frag", "shaders/phoenix_prerender.frag", "shaders/lyapunov_prerender.frag",
+		"shaders/newton_prerender.frag", "shaders/nova_prerender.frag", "shaders/multibrot_prerender.frag",
+		"shaders/spider_prerender.frag",
+	};
+	for (const char* kernel : pre_render_kernels) {
+		m_shaders.add("shaders/prerender.vert", kernel);
+		const std::string df64_path = df64FragmentPath(kernel);
+		if (!df64_path.empty()) {
+			m_shaders.add("shaders/prerender.vert", df64_path);
+		}
+	}
+}
+
+// real-time shader for fractals that may have a df64 twin, remembers the fp64 paths so the render loop can swap kernels later
+Shader* Application::loadFractalShader(const char* vertex_path, const char* fragment_path)
+{
+	m_fractal_vertex_path = vertex_path;
+	m_fractal_fragment_path = fragment_path;
+	const std::string df64_path = df64FragmentPath(m_fractal_fragment_path);
+	m_fractal_shader_df64 = !df64_path.empty() && useDf64(m_mandel_zoom, screenHeight);
+	spdlog::info("Loading {} kernel for {}.", m_fractal_shader_df64 ? "df64" : "fp64", fragment_path);
+	return m_shaders.get(vertex_path, m_fractal_shader_df64 ? df64_path.c_str() : fragment_path);
+}
+
+// palette of the current fractal, shared by the live view state and the pre-render passes
+void Application::fractalPalette(const ImVec4* palette[4]) const
+{
+	palette[0] = &m_palette_a;
+	palette[1] = &m_palette_b;
+	palette[2] = &m_palette_c;
+	palette[3] = &m_palette_d;
+	if (m_apply_common_color_palette) {
+		return;
+	}
+	switch (m_currentFractal) {
+	case FractalType::MANDELBROT:
+	case FractalType::MULTIBROT:
+		palette[0] = &m_palette_mandelbrot_a; palette[1] = &m_palette_mandelbrot_b; palette[2] = &m_palette_mandelbrot_c; palette[3] = &m_palette_mandelbrot_d;
+		break;
+	case FractalType::JULIA:
+		palette[0] = &m_palette_julia_a; palette[1] = &m_palette_julia_b; palette[2] = &m_palette_julia_c; palette[3] = &m_palette_julia_d;
+		break;
+	case FractalType::BURNING_SHIP:
+		palette[0] = &m_palette_burning_ship_a; palette[1] = &m_palette_burning_ship_b; palette[2] = &m_palette_burning_ship_c; palette[3] = &m_palette_burning_ship_d;
+		break;
+	case FractalType::TRICORN:
+		palette[0] = &m_palette_tricorn_a; palette[1] = &m_palette_tricorn_b; palette[2] = &m_palette_tricorn_c; palette[3] = &m_palette_tricorn_d;
+		break;
+	case FractalType::PHOENIX:
+		palette[0] = &m_palette_phoenix_a; palette[1] = &m_palette_phoenix_b; palette[2] = &m_palette_phoenix_c; palette[3] = &m_palette_phoenix_d;
+		break;
+	case FractalType::LYAPUNOV:
+		palette[0] = &m_palette_lyapunov_a; palette[1] = &m_palette_lyapunov_b; palette[2] = &m_palette_lyapunov_c; palette[3] = &m_palette_lyapunov_d;
+		break;
+	case FractalType::NEWTON:
+		palette[0] = &m_palette_newton_a; palette[1] = &m_palette_newton_b; palette[2] = &m_palette_newton_c; palette[3] = &m_palette_newton_d;
+		break;
+	case FractalType::NOVA:
+		palette[0] = &m_palette_nova_a; palette[1] = &m_palette_nova_b; palette[2] = &m_palette_nova_c; palette[3] = &m_palette_nova_d;
+		break;
+	case FractalType::SPIDER:
+		palette[0] = &m_palette_spider_a; palette[1] = &m_palette_spider_b; palette[2] = &m_palette_spider_c; palette[3] = &m_palette_spider_d;
+		break;
+	default:
+		break;
+	}
+}
+
+// everything colorize.frag reads besides the g-buffer: the palette, density, cycling phase, style and mode
+std::array<float, 16> Application::colorizeState() const
+{
+	const ImVec4* palette[4];
+	fractalPalette(palette);
+	const float offset = m_palette_cycle_speed != 0.0f ? std::fmod(SDL_GetTicks() / 1000.0f * m_palette_cycle_speed, 1.0f) : 0.0f;
+	const int mode = m_currentFractal == FractalType::NEWTON ? 1 : m_currentFractal == FractalType::LYAPUNOV ? 2 : 0;
+	return {
+		palette[0]->x, palette[0]->y, palette[0]->z, palette[1]->x, palette[1]->y, palette[1]->z,
+		palette[2]->x, palette[2]->y, palette[2]->z, palette[3]->x, palette[3]->y, palette[3]->z,
+		m_color_density, offset, (float)m_color_style, (float)mode
+	};
+}
+
+void Application::setColorizeUniforms(Shader* shader, const std::array<float, 16>& state)
+{
+	shader->setInt("u_gbuffer_value", 0);
+	shader->setInt("u_gbuffer_orbit", 1);
+	shader->setVec3("u_palette_a", state[0], state[1], state[2]);
+	shader->setVec3("u_palette_b", state[3], state[4], state[5]);
+	shader->setVec3("u_palette_c", state[6], state[7], state[8]);
+	shader->setVec3("u_palette_d", state[9], state[10], state[11]);
+	shader->setFloat("u_color_density", state[12]);
+	shader->setFloat("u_palette_offset", state[13]);
+	shader->setInt("u_color_style", (int)state[14]);
+	shader->setInt("u_colorize_mode", (int)state[15]);
+}
+
+// maps the pre-render g-buffer into the colour texture the viewer samples, one cheap pass that only runs when the colouring changed
+void Application::colorizePreRender()
+{
+	if (m_pre_render_gbuffer_value == 0 || m_pre_render_gbuffer_orbit == 0 || m_pre_render_texture == 0) {
+		return;
+	}
+	const std::array<float, 16> state = colorizeState();
+	if (m_pre_render_colorized && state == m_pre_render_color_state) {
+		return;
+	}
+
+	if (m_colorize_shader == nullptr) {
+		m_colorize_shader = m_shaders.get("shaders/simple.vert", "shaders/colorize.frag");
+	}
+	if (m_pre_render_color_fbo == 0) {
+		glGenFramebuffers(1, &m_pre_render_color_fbo);
+		glBindFramebuffer(GL_FRAMEBUFFER, m_pre_render_color_fbo);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_pre_render_texture, 0);
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+			spdlog::error("Colour pass framebuffer is not complete!");
+		}
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, m_pre_render_color_fbo);
+	glViewport(0, 0, m_pre_render_resolution, m_pre_render_resolution);
+	m_colorize_shader->use();
+	setColorizeUniforms(m_colorize_shader, state);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, m_pre_render_gbuffer_value);
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, m_pre_render_gbuffer_orbit);
+	glActiveTexture(GL_TEXTURE0);
+	glBindVertexArray(VAO);
+	glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 	glBindTexture(GL_TEXTURE_2D, m_pre_render_texture);
 	glGenerateMipmap(GL_TEXTURE_2D);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-	spdlog::info("Worker thread: Mipmaps generated.");
-	glDisable(GL_SCISSOR_TEST);
-	if (m_pre_render_fence) { glDeleteSync(m_pre_render_fence); }
-	m_pre_render_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
-	glFlush();
-	delete workerShader;
-	glDeleteVertexArrays(1, &workerVAO);
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-	SDL_GL_MakeCurrent(window, nullptr);
-	m_worker_finished_submission.store(true);
-	spdlog::info("Worker thread: Render commands submitted.");
-	spdlog::info("Worker thread: Pre-render worker completed.");
-}
\ No newline at end of file
+	m_pre_render_color_state = state;
+	m_pre_render_colorized = true;
+}
+
+// the detail pages continue the pre-render's image, with its kernel and view
+void Application::createVirtualTexture()
+{
+	// the fp64 kernel would page in blocks over a perturbed deep pre-render, such a view is only magnified
+	if (m_pre_render_perturbed.load()) {
+		spdlog::info("Detail pages are off for this pre-render, it was iterated against a reference orbit.");
+		return;
+	}
+	m_virtual_texture.create(m_pre_render_resolution, window, m_worker_context, &m_worker_context_mutex,
+		VBO_vertices, EBO, [this](int resolution) -> Shader* {
+			const std::string kernel_path = preRenderKernelPath(resolution);
+			Shader* kernel = kernel_path.empty() ? nullptr : m_shaders.get("shaders/prerender.vert", kernel_path.c_str());
+			if (kernel == nullptr || kernel->ID == 0 || !setPreRenderUniforms(kernel)) {
+				return nullptr;
+			}
+			kernel->use();
+			return kernel;
+		});
+}
+
+// drops the pre-render textures, the g-buffer and the colouring pass objects
+void Application::releasePreRender()
+{
+	m_virtual_texture.release();
+	{
+		// a continued render may still be iterating the kept orbits
+		std::lock_guard<std::mutex> context_lock(m_worker_context_mutex);
+		glDeleteBuffers(1, &m_pre_render_resume_list);
+		m_pre_render_resume_list = 0;
+		m_pre_render_resume_count.store(0);
+		m_pre_render_resume_iterations.store(0);
+	}
+	if (m_pre_render_resume_fence) {
+		glDeleteSync(m_pre_render_resume_fence);
+		m_pre_render_resume_fence = nullptr;
+	}
+	glDeleteTextures(1, &m_pre_render_texture);
+	glDeleteTextures(1, &m_pre_render_gbuffer_value);
+	glDeleteTextures(1, &m_pre_render_gbuffer_orbit);
+	glDeleteFramebuffers(1, &m_pre_render_fbo);
+	glDeleteFramebuffers(1, &m_pre_render_color_fbo);
+	// the programs belong to the registry
+	m_texture_view_shader = nullptr;
+	m_colorize_shader = nullptr;
+	m_pre_render_texture = 0;
+	m_pre_render_gbuffer_value = 0;
+	m_pre_render_gbuffer_orbit = 0;
+	m_pre_render_fbo = 0;
+	m_pre_render_color_fbo = 0;
+	m_pre_render_colorized = false;
+}
+
+Application::LiveViewState Application::liveViewState(int drawable_w, int drawable_h) const
+{
+	LiveViewState state;
+	state.fractal = m_currentFractal;
+	state.drawable = { drawable_w, drawable_h };
+	// past the fp64 wall the doubles stop moving when panning, the BigFloat centre is what changes
+	if (m_currentFractal == FractalType::MANDELBROT && m_mandel_zoom >= DEEP_ZOOM_THRESHOLD) {
+		state.deep_center_x = m_mandel_deep_center_x;
+		state.deep_center_y = m_mandel_deep_center_y;
+		state.reference = m_reference_orbit.get();
+	}
+	state.view = {
+		m_mandel_center_x, m_mandel_center_y, m_mandel_zoom, m_julia_c_x, m_julia_c_y,
+		m_phoenix_c_x, m_phoenix_c_y, m_phoenix_p, m_lyapunov_center_a, m_lyapunov_center_b, m_lyapunov_zoom,
+		m_multibrot_power, m_nova_power, m_nova_relaxation
+	};
+	state.iterations = { m_adaptive_iterations ? 1 : 0, m_base_iterations, m_mandel_max_iterations, m_mandel_deep_iterations };
+	const ImVec4* palette[4];
+	fractalPalette(palette);
+	for (int i = 0; i < 4; ++i) {
+		state.coloring[i * 3] = palette[i]->x;
+		state.coloring[i * 3 + 1] = palette[i]->y;
+		state.coloring[i * 3 + 2] = palette[i]->z;
+	}
+	state.coloring[12] = m_color_density;
+	state.df64 = m_fractal_shader_df64;
+	return state;
+}
+
+bool Application::liveKeepsState() const
+{
+	if (!m_resume_iterations || m_fractal_shader_df64) {
+		return false;
+	}
+	// perturbation has its own orbits
+	if (m_currentFractal == FractalType::MANDELBROT) {
+		return m_mandel_zoom < DEEP_ZOOM_THRESHOLD;
+	}
+	return m_currentFractal == FractalType::JULIA;
+}
+
+// the limit the mandelbrot and julia shaders run to in the live view
+int Application::liveIterationLimit() const
+{
+	if (!m_adaptive_iterations) {
+		return m_mandel_max_iterations;
+	}
+	int iterations = m_base_iterations;
+	if (m_mandel_zoom > 1.0) {
+		iterations += static_cast<int>(150.0 * log(m_mandel_zoom));
+	}
+	return iterations;
+}
+
+// a view that only raised the iteration limit over a finished full resolution image continues the kept orbits in
+// place, false when it has to be drawn some other way
+bool Application::resumeLiveIterations(const LiveViewState& from, const LiveViewState& to)
+{
+	const int kept = m_iteration_state.iterations();
+	if (!liveKeepsState() || kept == 0) {
+		return false;
+	}
+	LiveViewState raised = to;
+	raised.iterations = from.iterations;
+	if (!(raised == from) || liveIterationLimit() <= kept || !m_progressive.resume()) {
+		return false;
+	}
+	m_resume_from = kept;
+	return true;
+}
+
+// maps the pixels of one live view onto another that differs only in centre and zoom:
+// pixel p of the new view shows what pixel p * scale + offset showed in the old one (drawable pixels, origin bottom left)
+bool Application::liveViewTransform(const LiveViewState& from, const LiveViewState& to, double& scale, double& offset_x, double& offset_y) const
+{
+	const bool lyapunov = to.fractal == FractalType::LYAPUNOV;
+	// centre and zoom slots of LiveViewState::view
+	const size_t center_x = lyapunov ? 8 : 0;
+	const size_t center_y = center_x + 1;
+	const size_t zoom = center_x + 2;
+	LiveViewState moved = to;
+	moved.view[center_x] = from.view[center_x];
+	moved.view[center_y] = from.view[center_y];
+	moved.view[zoom] = from.view[zoom];
+	moved.deep_center_x = from.deep_center_x;
+	moved.deep_center_y = from.deep_center_y;
+	if (!(moved == from) || !(from.view[zoom] > 0.0) || !(to.view[zoom] > 0.0)) {
+		return false;
+	}
+	double dx = to.view[center_x] - from.view[center_x];
+	double dy = to.view[center_y] - from.view[center_y];
+	// past the fp64 wall only the BigFloat centres still resolve a pixel
+	if (to.fractal == FractalType::MANDELBROT && from.view[zoom] >= DEEP_ZOOM_THRESHOLD && to.view[zoom] >= DEEP_ZOOM_THRESHOLD) {
+		dx = (to.deep_center_x - from.deep_center_x).toDouble();
+		dy = (to.deep_center_y - from.deep_center_y).toDouble();
+	}
+	const double width = to.drawable[0];
+	const double height = to.drawable[1];
+	// the kernels keep pixels square, lyapunov stretches its plane over the window instead
+	const double pixels_per_unit_x = 0.5 * from.view[zoom] * (lyapunov ? width : height);
+	const double pixels_per_unit_y = 0.5 * from.view[zoom] * height;
+	scale = from.view[zoom] / to.view[zoom];
+	offset_x = 0.5 * width * (1.0 - scale) + dx * pixels_per_unit_x;
+	offset_y = 0.5 * height * (1.0 - scale) + dy * pixels_per_unit_y;
+	return true;
+}
+
+// frame time the loop aims for, 0 when neither max_fps nor vsync limit it
+float Application::targetFrameMs() const
+{
+	int fps = m_max_fps;
+	SDL_DisplayMode mode;
+	if (m_vsync && SDL_GetWindowDisplayMode(window, &mode) == 0 && mode.refresh_rate > 0 && (fps <= 0 || mode.refresh_rate < fps)) {
+		fps = mode.refresh_rate;
+	}
+	return fps > 0 ? 1000.0f / (float)fps : 0.0f;
+}
+
+// sleeps off the rest of the frame when it finished early, vsync alone only caps at the refresh rate
+void Application::limitFrameRate() const
+{
+	if (m_max_fps <= 0) {
+		return;
+	}
+	const Uint64 frequency = SDL_GetPerformanceFrequency();
+	const Uint64 frame_ticks = frequency / (Uint64)m_max_fps;
+	const Uint64 elapsed = SDL_GetPerformanceCounter() - m_frame_start;
+	if (elapsed < frame_ticks) {
+		SDL_Delay((Uint32)((frame_ticks - elapsed) * 1000 / frequency));
+	}
+}
+
+// how long the main loop may block waiting for events, 0 while anything on screen is still moving
+int Application::idleWaitTimeout() const
+{
+	if (SDL_GetWindowFlags(window) & SDL_WINDOW_MINIMIZED) {
+		return IDLE_WAIT_TIMEOUT_MS;
+	}
+	if (m_active_frames > 0 || m_is_loading || m_is_dragging) {
+		return 0;
+	}
+	if (m_pre_render_complete) {
+		// detail pages show up as soon as they land
+		return m_palette_cycle_speed != 0.0f || m_virtual_texture.busy() ? 0 : IDLE_WAIT_TIMEOUT_MS;
+	}
+	// the menu background is animated
+	if (m_currentFractal == FractalType::NONE) {
+		return 0;
+	}
+	// a reference orbit still on its way has to be picked up as soon as it lands
+	if (!m_progressive.complete() || m_reference_future.valid()) {
+		return 0;
+	}
+	return IDLE_WAIT_TIMEOUT_MS;
+}
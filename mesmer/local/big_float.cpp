@@ -0,0 +1,288 @@
+/*
+	Mesmer - An interactive and high-performance fractal generator and explorer.
+	Made by -> Titan // GH: https://github.com/titan3755/mesmer
+	[big_float.cpp]
+*/
+
+#include <big_float.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+
+BigFloat::BigFloat(int fraction_limbs) {
+	m_limbs.assign((size_t)std::max(1, fraction_limbs) + 1, 0u);
+}
+
+BigFloat BigFloat::fromDouble(double value, int fraction_limbs) {
+	BigFloat result(fraction_limbs);
+	if (!std::isfinite(value) || value == 0.0) {
+		return result;
+	}
+	result.m_negative = value < 0.0;
+	double magnitude = std::min(std::fabs(value), 4294967295.0);
+	const double integer_part = std::floor(magnitude);
+	result.m_limbs.back() = (uint32_t)integer_part;
+	// scaling by 2^32 and dropping the integer part is exact, so this copies every mantissa bit
+	double fraction = magnitude - integer_part;
+	for (int i = result.fractionLimbs() - 1; i >= 0 && fraction != 0.0; --i) {
+		fraction *= 4294967296.0;
+		const double limb = std::floor(fraction);
+		result.m_limbs[i] = (uint32_t)limb;
+		fraction -= limb;
+	}
+	return result;
+}
+
+bool BigFloat::fromString(const std::string& text, BigFloat& out, int fraction_limbs) {
+	size_t pos = 0;
+	while (pos < text.size() && std::isspace((unsigned char)text[pos])) ++pos;
+	bool negative = false;
+	if (pos < text.size() && (text[pos] == '-' || text[pos] == '+')) {
+		negative = text[pos] == '-';
+		++pos;
+	}
+	std::string digits;
+	long long point = -1;
+	for (; pos < text.size(); ++pos) {
+		const char ch = text[pos];
+		if (std::isdigit((unsigned char)ch)) {
+			digits.push_back(ch);
+		}
+		else if (ch == '.' && point < 0) {
+			point = (long long)digits.size();
+		}
+		else {
+			break;
+		}
+	}
+	if (digits.empty()) {
+		return false;
+	}
+	if (point < 0) {
+		point = (long long)digits.size();
+	}
+	if (pos < text.size() && (text[pos] == 'e' || text[pos] == 'E')) {
+		++pos;
+		bool exponent_negative = false;
+		if (pos < text.size() && (text[pos] == '-' || text[pos] == '+')) {
+			exponent_negative = text[pos] == '-';
+			++pos;
+		}
+		long long exponent = 0;
+		bool exponent_digits = false;
+		for (; pos < text.size() && std::isdigit((unsigned char)text[pos]); ++pos) {
+			exponent = std::min(exponent * 10 + (text[pos] - '0'), 100000LL);
+			exponent_digits = true;
+		}
+		if (!exponent_digits) {
+			return false;
+		}
+		point += exponent_negative ? -exponent : exponent;
+	}
+	while (pos < text.size() && std::isspace((unsigned char)text[pos])) ++pos;
+	if (pos != text.size()) {
+		return false;
+	}
+
+	// move the decimal point, then split into integer and fraction digits
+	if (point < 0) {
+		digits.insert(0, (size_t)(-point), '0');
+		point = 0;
+	}
+	if (point > (long long)digits.size()) {
+		digits.append((size_t)(point - (long long)digits.size()), '0');
+	}
+	unsigned long long integer_part = 0;
+	for (long long i = 0; i < point; ++i) {
+		integer_part = integer_part * 10 + (unsigned long long)(digits[(size_t)i] - '0');
+		if (integer_part > 0xFFFFFFFFull) {
+			return false;
+		}
+	}
+
+	BigFloat result(fraction_limbs);
+	result.m_limbs.back() = (uint32_t)integer_part;
+	// horner from the last fraction digit: f = (digit + f) / 10, digits past the precision cannot change the result
+	const long long max_digits = (long long)result.fractionLimbs() * 10 + 10;
+	const long long last = std::min((long long)digits.size(), point + max_digits);
+	for (long long i = last - 1; i >= point; --i) {
+		uint64_t remainder = (uint64_t)(digits[(size_t)i] - '0');
+		for (int limb = result.fractionLimbs() - 1; limb >= 0; --limb) {
+			const uint64_t current = (remainder << 32) | result.m_limbs[limb];
+			result.m_limbs[limb] = (uint32_t)(current / 10);
+			remainder = current % 10;
+		}
+	}
+	result.m_negative = negative && !result.isZero();
+	out = std::move(result);
+	return true;
+}
+
+std::string BigFloat::toString(int digits) const {
+	std::string integer_text = std::to_string(m_limbs.back());
+	std::string fraction_text;
+	std::vector<uint32_t> fraction(m_limbs.begin(), m_limbs.end() - 1);
+	// one extra digit to round on, the parser truncates so 0.1 comes back as 0.0999...
+	for (int k = 0; k <= digits; ++k) {
+		uint64_t carry = 0;
+		for (uint32_t& limb : fraction) {
+			const uint64_t current = (uint64_t)limb * 10 + carry;
+			limb = (uint32_t)current;
+			carry = current >> 32;
+		}
+		fraction_text.push_back((char)('0' + carry));
+	}
+	const bool round_up = fraction_text.back() >= '5';
+	fraction_text.pop_back();
+	if (round_up) {
+		int i = (int)fraction_text.size() - 1;
+		for (; i >= 0 && fraction_text[i] == '9'; --i) {
+			fraction_text[i] = '0';
+		}
+		if (i >= 0) {
+			++fraction_text[i];
+		}
+		else {
+			integer_text = std::to_string((unsigned long long)m_limbs.back() + 1);
+		}
+	}
+	while (!fraction_text.empty() && fraction_text.back() == '0') {
+		fraction_text.pop_back();
+	}
+	std::string text;
+	if (m_negative && (integer_text != "0" || !fraction_text.empty())) {
+		text.push_back('-');
+	}
+	text += integer_text;
+	if (!fraction_text.empty()) {
+		text += "." + fraction_text;
+	}
+	return text;
+}
+
+double BigFloat::toDouble() const {
+	double value = 0.0;
+	int significant = 0;
+	const int fraction_limbs = fractionLimbs();
+	for (int i = (int)m_limbs.size() - 1; i >= 0 && significant < 3; --i) {
+		if (m_limbs[i] != 0 || significant > 0) {
+			value += std::ldexp((double)m_limbs[i], 32 * (i - fraction_limbs));
+			++significant;
+		}
+	}
+	return m_negative ? -value : value;
+}
+
+BigFloat BigFloat::withPrecision(int fraction_limbs) const {
+	BigFloat result(fraction_limbs);
+	const int shift = result.fractionLimbs() - fractionLimbs();
+	for (int i = 0; i < (int)m_limbs.size(); ++i) {
+		const int target = i + shift;
+		if (target >= 0) {
+			result.m_limbs[target] = m_limbs[i];
+		}
+	}
+	result.m_negative = m_negative && !result.isZero();
+	return result;
+}
+
+bool BigFloat::isZero() const {
+	return std::all_of(m_limbs.begin(), m_limbs.end(), [](uint32_t limb) { return limb == 0; });
+}
+
+BigFloat BigFloat::operator-() const {
+	BigFloat result = *this;
+	result.m_negative = !m_negative && !isZero();
+	return result;
+}
+
+BigFloat BigFloat::operator+(const BigFloat& other) const {
+	return addSigned(*this, other, false);
+}
+
+BigFloat BigFloat::operator-(const BigFloat& other) const {
+	return addSigned(*this, other, true);
+}
+
+int BigFloat::compareMagnitude(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b) {
+	for (int i = (int)a.size() - 1; i >= 0; --i) {
+		if (a[i] != b[i]) {
+			return a[i] < b[i] ? -1 : 1;
+		}
+	}
+	return 0;
+}
+
+BigFloat BigFloat::addSigned(const BigFloat& a, const BigFloat& b, bool negate_b) {
+	const int fraction_limbs = std::max(a.fractionLimbs(), b.fractionLimbs());
+	const BigFloat& lhs = a.fractionLimbs() == fraction_limbs ? a : a.withPrecision(fraction_limbs);
+	BigFloat rhs_copy;
+	const BigFloat* rhs = &b;
+	if (b.fractionLimbs() != fraction_limbs) {
+		rhs_copy = b.withPrecision(fraction_limbs);
+		rhs = &rhs_copy;
+	}
+	const bool lhs_negative = lhs.m_negative;
+	const bool rhs_negative = rhs->m_negative != negate_b;
+
+	BigFloat result(fraction_limbs);
+	const size_t count = result.m_limbs.size();
+	if (lhs_negative == rhs_negative) {
+		uint64_t carry = 0;
+		for (size_t i = 0; i < count; ++i) {
+			const uint64_t sum = (uint64_t)lhs.m_limbs[i] + rhs->m_limbs[i] + carry;
+			result.m_limbs[i] = (uint32_t)sum;
+			carry = sum >> 32;
+		}
+		result.m_negative = lhs_negative;
+	}
+	else {
+		const bool lhs_larger = compareMagnitude(lhs.m_limbs, rhs->m_limbs) >= 0;
+		const std::vector<uint32_t>& larger = lhs_larger ? lhs.m_limbs : rhs->m_limbs;
+		const std::vector<uint32_t>& smaller = lhs_larger ? rhs->m_limbs : lhs.m_limbs;
+		int64_t borrow = 0;
+		for (size_t i = 0; i < count; ++i) {
+			int64_t difference = (int64_t)larger[i] - (int64_t)smaller[i] - borrow;
+			borrow = difference < 0 ? 1 : 0;
+			result.m_limbs[i] = (uint32_t)(difference + (borrow << 32));
+		}
+		result.m_negative = lhs_larger ? lhs_negative : rhs_negative;
+	}
+	if (result.isZero()) {
+		result.m_negative = false;
+	}
+	return result;
+}
+
+BigFloat BigFloat::operator*(const BigFloat& other) const {
+	const size_t na = m_limbs.size();
+	const size_t nb = other.m_limbs.size();
+	std::vector<uint32_t> product(na + nb, 0u);
+	for (size_t i = 0; i < na; ++i) {
+		if (m_limbs[i] == 0) continue;
+		uint64_t carry = 0;
+		for (size_t j = 0; j < nb; ++j) {
+			const uint64_t current = (uint64_t)m_limbs[i] * other.m_limbs[j] + product[i + j] + carry;
+			product[i + j] = (uint32_t)current;
+			carry = current >> 32;
+		}
+		product[i + nb] = (uint32_t)carry;
+	}
+	// the product carries fa + fb fraction limbs, keep the top ones (truncating) and a single integer limb
+	const int fraction_limbs = std::max(fractionLimbs(), other.fractionLimbs());
+	const size_t drop = (size_t)(fractionLimbs() + other.fractionLimbs() - fraction_limbs);
+	BigFloat result(fraction_limbs);
+	for (size_t i = 0; i < result.m_limbs.size(); ++i) {
+		result.m_limbs[i] = product[i + drop];
+	}
+	result.m_negative = (m_negative != other.m_negative) && !result.isZero();
+	return result;
+}
+
+bool BigFloat::operator==(const BigFloat& other) const {
+	const int fraction_limbs = std::max(fractionLimbs(), other.fractionLimbs());
+	const BigFloat lhs = withPrecision(fraction_limbs);
+	const BigFloat rhs = other.withPrecision(fraction_limbs);
+	return lhs.m_negative == rhs.m_negative && lhs.m_limbs == rhs.m_limbs;
+}
@@ -0,0 +1,1033 @@
+/*
+	Mesmer - An interactive and high-performance fractal generator and explorer.
+	Made by -> Titan // GH: https://github.com/titan3755/mesmer
+	[cpu_renderer.cpp]
+*/
+
+#include <cpu_renderer.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define MESMER_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#else
+#define MESMER_X86 0
+#endif
+
+// msvc exposes every intrinsic set unconditionally, gcc/clang need the kernels tagged with their target isa
+#if MESMER_X86 && (defined(__GNUC__) || defined(__clang__))
+#define MESMER_TARGET(isa) __attribute__((target(isa)))
+#else
+#define MESMER_TARGET(isa)
+#endif
+
+// the kernels have to round like the glsl dvec2 code, so the compiler must not fuse mul+add into fma
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(_MSC_VER)
+#pragma fp_contract(off)
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+namespace {
+
+	// keeps the completed tile queue bounded when the consumer (the GL upload) is slower than the workers
+	constexpr size_t MAX_PENDING_TILES_PER_THREAD = 4;
+
+	// brent cycle detection, same schedule and tolerance as the glsl kernels: every 8th iteration z is compared with a
+	// point saved at doubling intervals, an orbit that returns to it sits on an attracting cycle and never escapes
+	constexpr double PERIOD_EPSILON = 1.0e-14;
+	constexpr int PERIOD_CHECK_MASK = 7;
+
+	// subdivision stops at rectangles this small, their border already covers most of the pixels
+	constexpr int SUBDIVISION_MIN_SIZE = 8;
+	constexpr int SUBDIVISION_UNKNOWN = -1;
+	constexpr int SUBDIVISION_QUEUED = -2;
+
+	// compacted regions iterate this many pixels per batch, so the survivors of several rows fill the lanes together
+	constexpr int COMPACTION_BATCH_PIXELS = 16384;
+
+	// log2 channels of the g-buffer orbit word cover [-8, 8], same constant as gbuffer.glsl
+	constexpr float GBUFFER_LOG_RANGE = 16.0f;
+
+	// the main cardioid and the period-2 bulb of the mandelbrot set never escape
+	inline bool insideCardioid(double cx, double cy) {
+		const double x = cx - 0.25;
+		const double q = x * x + cy * cy;
+		return q * (q + x) <= 0.25 * cy * cy;
+	}
+
+	inline bool insideBulb(double cx, double cy) {
+		const double b = cx + 1.0;
+		return b * b + cy * cy <= 0.0625;
+	}
+
+	inline bool insideCardioidOrBulb(double cx, double cy) {
+		return insideCardioid(cx, cy) || insideBulb(cx, cy);
+	}
+
+	// scalar reference kernel, also handles the tail lanes of the vector kernels
+	void iterateScalar(int count, double* z_re, double* z_im, const double* c_re, const double* c_im, double* saved_re, double* saved_im,
+		int iter_begin, int iter_end, int next_save, int max_iter, int* out_iter, double* out_mag2)
+	{
+		const int end = std::min(iter_end, max_iter);
+		for (int n = 0; n < count; ++n) {
+			double zx = z_re[n];
+			double zy = z_im[n];
+			const double cx = c_re[n];
+			const double cy = c_im[n];
+			double mag2 = 0.0;
+			double saved_x = saved_re[n];
+			double saved_y = saved_im[n];
+			int lane_save = next_save;
+			bool done = false;
+			int i;
+			for (i = iter_begin; i < end; ++i) {
+				double x_temp = zx * zx - zy * zy + cx;
+				zy = 2.0 * zx * zy + cy;
+				zx = x_temp;
+				mag2 = zx * zx + zy * zy;
+				if (mag2 > 4.0) {
+					done = true;
+					break;
+				}
+				if ((i & PERIOD_CHECK_MASK) == 0) {
+					if (std::fabs(zx - saved_x) + std::fabs(zy - saved_y) < PERIOD_EPSILON) {
+						i = max_iter;
+						done = true;
+						break;
+					}
+					if (i >= lane_save) {
+						saved_x = zx;
+						saved_y = zy;
+						lane_save *= 2;
+					}
+				}
+			}
+			if (!done && end < max_iter) {
+				z_re[n] = zx;
+				z_im[n] = zy;
+				saved_re[n] = saved_x;
+				saved_im[n] = saved_y;
+				out_iter[n] = -1;
+				continue;
+			}
+			out_iter[n] = i;
+			out_mag2[n] = mag2;
+		}
+	}
+
+#if MESMER_X86
+	MESMER_TARGET("sse2")
+	void iterateSse2(int count, double* z_re, double* z_im, const double* c_re, const double* c_im, double* saved_re, double* saved_im,
+		int iter_begin, int iter_end, int next_save, int max_iter, int* out_iter, double* out_mag2)
+	{
+		const int end = std::min(iter_end, max_iter);
+		const __m128d four = _mm_set1_pd(4.0);
+		const __m128d sign = _mm_set1_pd(-0.0);
+		const __m128d epsilon = _mm_set1_pd(PERIOD_EPSILON);
+		int n = 0;
+		for (; n + 2 <= count; n += 2) {
+			__m128d zx = _mm_loadu_pd(z_re + n);
+			__m128d zy = _mm_loadu_pd(z_im + n);
+			const __m128d cx = _mm_loadu_pd(c_re + n);
+			const __m128d cy = _mm_loadu_pd(c_im + n);
+			__m128d active = _mm_castsi128_pd(_mm_set1_epi32(-1));
+			__m128d iter = _mm_set1_pd((double)max_iter);
+			__m128d mag2 = _mm_setzero_pd();
+			__m128d saved_x = _mm_loadu_pd(saved_re + n);
+			__m128d saved_y = _mm_loadu_pd(saved_im + n);
+			int lane_save = next_save;
+			for (int i = iter_begin; i < end; ++i) {
+				__m128d xx = _mm_mul_pd(zx, zx);
+				__m128d yy = _mm_mul_pd(zy, zy);
+				__m128d xy = _mm_mul_pd(zx, zy);
+				__m128d nx = _mm_add_pd(_mm_sub_pd(xx, yy), cx);
+				__m128d ny = _mm_add_pd(_mm_add_pd(xy, xy), cy);
+				zx = _mm_or_pd(_mm_and_pd(active, nx), _mm_andnot_pd(active, zx));
+				zy = _mm_or_pd(_mm_and_pd(active, ny), _mm_andnot_pd(active, zy));
+				__m128d m = _mm_add_pd(_mm_mul_pd(zx, zx), _mm_mul_pd(zy, zy));
+				__m128d escaped = _mm_and_pd(_mm_cmpgt_pd(m, four), active);
+				if (_mm_movemask_pd(escaped)) {
+					iter = _mm_or_pd(_mm_and_pd(escaped, _mm_set1_pd((double)i)), _mm_andnot_pd(escaped, iter));
+					mag2 = _mm_or_pd(_mm_and_pd(escaped, m), _mm_andnot_pd(escaped, mag2));
+					active = _mm_andnot_pd(escaped, active);
+					if (!_mm_movemask_pd(active)) break;
+				}
+				if ((i & PERIOD_CHECK_MASK) == 0) {
+					__m128d distance = _mm_add_pd(_mm_andnot_pd(sign, _mm_sub_pd(zx, saved_x)), _mm_andnot_pd(sign, _mm_sub_pd(zy, saved_y)));
+					__m128d periodic = _mm_and_pd(_mm_cmplt_pd(distance, epsilon), active);
+					if (_mm_movemask_pd(periodic)) {
+						active = _mm_andnot_pd(periodic, active);
+						if (!_mm_movemask_pd(active)) break;
+					}
+					if (i >= lane_save) {
+						saved_x = zx;
+						saved_y = zy;
+						lane_save *= 2;
+					}
+				}
+			}
+			if (end < max_iter) {
+				// lanes still running hand their state to the next chunk
+				iter = _mm_or_pd(_mm_and_pd(active, _mm_set1_pd(-1.0)), _mm_andnot_pd(active, iter));
+				_mm_storeu_pd(z_re + n, zx);
+				_mm_storeu_pd(z_im + n, zy);
+				_mm_storeu_pd(saved_re + n, saved_x);
+				_mm_storeu_pd(saved_im + n, saved_y);
+			}
+			alignas(16) double it[2], mg[2];
+			_mm_store_pd(it, iter);
+			_mm_store_pd(mg, mag2);
+			for (int k = 0; k < 2; ++k) {
+				out_iter[n + k] = (int)it[k];
+				out_mag2[n + k] = mg[k];
+			}
+		}
+		iterateScalar(count - n, z_re + n, z_im + n, c_re + n, c_im + n, saved_re + n, saved_im + n, iter_begin, iter_end, next_save, max_iter,
+			out_iter + n, out_mag2 + n);
+	}
+
+	MESMER_TARGET("avx2")
+	void iterateAvx2(int count, double* z_re, double* z_im, const double* c_re, const double* c_im, double* saved_re, double* saved_im,
+		int iter_begin, int iter_end, int next_save, int max_iter, int* out_iter, double* out_mag2)
+	{
+		const int end = std::min(iter_end, max_iter);
+		const __m256d four = _mm256_set1_pd(4.0);
+		const __m256d sign = _mm256_set1_pd(-0.0);
+		const __m256d epsilon = _mm256_set1_pd(PERIOD_EPSILON);
+		int n = 0;
+		for (; n + 4 <= count; n += 4) {
+			__m256d zx = _mm256_loadu_pd(z_re + n);
+			__m256d zy = _mm256_loadu_pd(z_im + n);
+			const __m256d cx = _mm256_loadu_pd(c_re + n);
+			const __m256d cy = _mm256_loadu_pd(c_im + n);
+			__m256d active = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+			__m256d iter = _mm256_set1_pd((double)max_iter);
+			__m256d mag2 = _mm256_setzero_pd();
+			__m256d saved_x = _mm256_loadu_pd(saved_re + n);
+			__m256d saved_y = _mm256_loadu_pd(saved_im + n);
+			int lane_save = next_save;
+			for (int i = iter_begin; i < end; ++i) {
+				__m256d xx = _mm256_mul_pd(zx, zx);
+				__m256d yy = _mm256_mul_pd(zy, zy);
+				__m256d xy = _mm256_mul_pd(zx, zy);
+				__m256d nx = _mm256_add_pd(_mm256_sub_pd(xx, yy), cx);
+				__m256d ny = _mm256_add_pd(_mm256_add_pd(xy, xy), cy);
+				zx = _mm256_blendv_pd(zx, nx, active);
+				zy = _mm256_blendv_pd(zy, ny, active);
+				__m256d m = _mm256_add_pd(_mm256_mul_pd(zx, zx), _mm256_mul_pd(zy, zy));
+				__m256d escaped = _mm256_and_pd(_mm256_cmp_pd(m, four, _CMP_GT_OQ), active);
+				if (_mm256_movemask_pd(escaped)) {
+					iter = _mm256_blendv_pd(iter, _mm256_set1_pd((double)i), escaped);
+					mag2 = _mm256_blendv_pd(mag2, m, escaped);
+					active = _mm256_andnot_pd(escaped, active);
+					if (!_mm256_movemask_pd(active)) break;
+				}
+				if ((i & PERIOD_CHECK_MASK) == 0) {
+					__m256d distance = _mm256_add_pd(_mm256_andnot_pd(sign, _mm256_sub_pd(zx, saved_x)), _mm256_andnot_pd(sign, _mm256_sub_pd(zy, saved_y)));
+					__m256d periodic = _mm256_and_pd(_mm256_cmp_pd(distance, epsilon, _CMP_LT_OQ), active);
+					if (_mm256_movemask_pd(periodic)) {
+						active = _mm256_andnot_pd(periodic, active);
+						if (!_mm256_movemask_pd(active)) break;
+					}
+					if (i >= lane_save) {
+						saved_x = zx;
+						saved_y = zy;
+						lane_save *= 2;
+					}
+				}
+			}
+			if (end < max_iter) {
+				iter = _mm256_blendv_pd(iter, _mm256_set1_pd(-1.0), active);
+				_mm256_storeu_pd(z_re + n, zx);
+				_mm256_storeu_pd(z_im + n, zy);
+				_mm256_storeu_pd(saved_re + n, saved_x);
+				_mm256_storeu_pd(saved_im + n, saved_y);
+			}
+			alignas(32) double it[4], mg[4];
+			_mm256_store_pd(it, iter);
+			_mm256_store_pd(mg, mag2);
+			for (int k = 0; k < 4; ++k) {
+				out_iter[n + k] = (int)it[k];
+				out_mag2[n + k] = mg[k];
+			}
+		}
+		iterateSse2(count - n, z_re + n, z_im + n, c_re + n, c_im + n, saved_re + n, saved_im + n, iter_begin, iter_end, next_save, max_iter,
+			out_iter + n, out_mag2 + n);
+	}
+
+	MESMER_TARGET("avx512f")
+	void iterateAvx512(int count, double* z_re, double* z_im, const double* c_re, const double* c_im, double* saved_re, double* saved_im,
+		int iter_begin, int iter_end, int next_save, int max_iter, int* out_iter, double* out_mag2)
+	{
+		const int end = std::min(iter_end, max_iter);
+		const __m512d four = _mm512_set1_pd(4.0);
+		const __m512d epsilon = _mm512_set1_pd(PERIOD_EPSILON);
+		int n = 0;
+		for (; n + 8 <= count; n += 8) {
+			__m512d zx = _mm512_loadu_pd(z_re + n);
+			__m512d zy = _mm512_loadu_pd(z_im + n);
+			const __m512d cx = _mm512_loadu_pd(c_re + n);
+			const __m512d cy = _mm512_loadu_pd(c_im + n);
+			__mmask8 active = 0xFF;
+			__m512d iter = _mm512_set1_pd((double)max_iter);
+			__m512d mag2 = _mm512_setzero_pd();
+			__m512d saved_x = _mm512_loadu_pd(saved_re + n);
+			__m512d saved_y = _mm512_loadu_pd(saved_im + n);
+			int lane_save = next_save;
+			for (int i = iter_begin; i < end; ++i) {
+				__m512d xx = _mm512_mul_pd(zx, zx);
+				__m512d yy = _mm512_mul_pd(zy, zy);
+				__m512d xy = _mm512_mul_pd(zx, zy);
+				zx = _mm512_mask_add_pd(zx, active, _mm512_sub_pd(xx, yy), cx);
+				zy = _mm512_mask_add_pd(zy, active, _mm512_add_pd(xy, xy), cy);
+				__m512d m = _mm512_add_pd(_mm512_mul_pd(zx, zx), _mm512_mul_pd(zy, zy));
+				__mmask8 escaped = _mm512_mask_cmp_pd_mask(active, m, four, _CMP_GT_OQ);
+				if (escaped) {
+					iter = _mm512_mask_blend_pd(escaped, iter, _mm512_set1_pd((double)i));
+					mag2 = _mm512_mask_blend_pd(escaped, mag2, m);
+					active = (__mmask8)(active & ~escaped);
+					if (!active) break;
+				}
+				if ((i & PERIOD_CHECK_MASK) == 0) {
+					__m512d distance = _mm512_add_pd(_mm512_abs_pd(_mm512_sub_pd(zx, saved_x)), _mm512_abs_pd(_mm512_sub_pd(zy, saved_y)));
+					__mmask8 periodic = _mm512_mask_cmp_pd_mask(active, distance, epsilon, _CMP_LT_OQ);
+					if (periodic) {
+						active = (__mmask8)(active & ~periodic);
+						if (!active) break;
+					}
+					if (i >= lane_save) {
+						saved_x = zx;
+						saved_y = zy;
+						lane_save *= 2;
+					}
+				}
+			}
+			if (end < max_iter) {
+				iter = _mm512_mask_blend_pd(active, iter, _mm512_set1_pd(-1.0));
+				_mm512_storeu_pd(z_re + n, zx);
+				_mm512_storeu_pd(z_im + n, zy);
+				_mm512_storeu_pd(saved_re + n, saved_x);
+				_mm512_storeu_pd(saved_im + n, saved_y);
+			}
+			alignas(64) double it[8], mg[8];
+			_mm512_store_pd(it, iter);
+			_mm512_store_pd(mg, mag2);
+			for (int k = 0; k < 8; ++k) {
+				out_iter[n + k] = (int)it[k];
+				out_mag2[n + k] = mg[k];
+			}
+		}
+		iterateAvx2(count - n, z_re + n, z_im + n, c_re + n, c_im + n, saved_re + n, saved_im + n, iter_begin, iter_end, next_save, max_iter,
+			out_iter + n, out_mag2 + n);
+	}
+#endif
+
+	// perturbation kernels, same operation order as mandelbrot_perturb.frag
+	void perturbScalar(int count, const double* dc_re, const double* dc_im, const double* orbit, int orbit_length,
+		int max_iter, int* out_iter, double* out_mag2)
+	{
+		for (int n = 0; n < count; ++n) {
+			const double cx = dc_re[n];
+			const double cy = dc_im[n];
+			double dx = 0.0;
+			double dy = 0.0;
+			int ref = 0;
+			double mag2 = 0.0;
+			int i;
+			for (i = 0; i < max_iter; ++i) {
+				const double rx = orbit[2 * ref];
+				const double ry = orbit[2 * ref + 1];
+				const double nx = 2.0 * (rx * dx - ry * dy) + (dx * dx - dy * dy) + cx;
+				const double ny = 2.0 * (rx * dy + ry * dx) + 2.0 * dx * dy + cy;
+				dx = nx;
+				dy = ny;
+				++ref;
+				const double zx = orbit[2 * ref] + dx;
+				const double zy = orbit[2 * ref + 1] + dy;
+				mag2 = zx * zx + zy * zy;
+				if (mag2 > 4.0) break;
+				// rebase onto the start of the orbit when the pixel gets closer to 0 than to the reference
+				if (mag2 < dx * dx + dy * dy || ref == orbit_length - 1) {
+					dx = zx;
+					dy = zy;
+					ref = 0;
+				}
+			}
+			out_iter[n] = i;
+			out_mag2[n] = mag2;
+		}
+	}
+
+	// perturbation with bla jumps, lanes would diverge on every jump so this one stays scalar
+	void perturbBlaScalar(int count, const double* dc_re, const double* dc_im, const ReferenceOrbit& reference,
+		int max_iter, int* out_iter, double* out_mag2)
+	{
+		const double* orbit = reference.points.data();
+		const int orbit_length = reference.length();
+		for (int n = 0; n < count; ++n) {
+			const double cx = dc_re[n];
+			const double cy = dc_im[n];
+			double dx = 0.0;
+			double dy = 0.0;
+			int ref = 0;
+			int iterations = 0;
+			bool escaped = false;
+			double mag2 = 0.0;
+			while (iterations < max_iter) {
+				int steps = reference.bla.apply(ref, max_iter - iterations, cx, cy, dx, dy);
+				if (steps == 0) {
+					const double rx = orbit[2 * ref];
+					const double ry = orbit[2 * ref + 1];
+					const double nx = 2.0 * (rx * dx - ry * dy) + (dx * dx - dy * dy) + cx;
+					const double ny = 2.0 * (rx * dy + ry * dx) + 2.0 * dx * dy + cy;
+					dx = nx;
+					dy = ny;
+					steps = 1;
+				}
+				ref += steps;
+				iterations += steps;
+				const double zx = orbit[2 * ref] + dx;
+				const double zy = orbit[2 * ref + 1] + dy;
+				mag2 = zx * zx + zy * zy;
+				if (mag2 > 4.0) {
+					escaped = true;
+					break;
+				}
+				if (mag2 < dx * dx + dy * dy || ref == orbit_length - 1) {
+					dx = zx;
+					dy = zy;
+					ref = 0;
+				}
+			}
+			out_iter[n] = escaped ? iterations - 1 : max_iter;
+			out_mag2[n] = mag2;
+		}
+	}
+
+#if MESMER_X86
+	// lanes rebase independently, so the orbit is read with gathers
+	MESMER_TARGET("avx2")
+	void perturbAvx2(int count, const double* dc_re, const double* dc_im, const double* orbit, int orbit_length,
+		int max_iter, int* out_iter, double* out_mag2)
+	{
+		const __m256d four = _mm256_set1_pd(4.0);
+		const __m256d two = _mm256_set1_pd(2.0);
+		const __m256i one = _mm256_set1_epi64x(1);
+		const __m256i last = _mm256_set1_epi64x(orbit_length - 1);
+		int n = 0;
+		for (; n + 4 <= count; n += 4) {
+			const __m256d cx = _mm256_loadu_pd(dc_re + n);
+			const __m256d cy = _mm256_loadu_pd(dc_im + n);
+			__m256d dx = _mm256_setzero_pd();
+			__m256d dy = _mm256_setzero_pd();
+			__m256i ref = _mm256_setzero_si256();
+			__m256d active = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+			__m256d iter = _mm256_set1_pd((double)max_iter);
+			__m256d mag2 = _mm256_setzero_pd();
+			for (int i = 0; i < max_iter; ++i) {
+				__m256i index = _mm256_slli_epi64(ref, 1);
+				const __m256d rx = _mm256_i64gather_pd(orbit, index, 8);
+				const __m256d ry = _mm256_i64gather_pd(orbit + 1, index, 8);
+				const __m256d nx = _mm256_add_pd(_mm256_add_pd(
+					_mm256_mul_pd(two, _mm256_sub_pd(_mm256_mul_pd(rx, dx), _mm256_mul_pd(ry, dy))),
+					_mm256_sub_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy))), cx);
+				const __m256d ny = _mm256_add_pd(_mm256_add_pd(
+					_mm256_mul_pd(two, _mm256_add_pd(_mm256_mul_pd(rx, dy), _mm256_mul_pd(ry, dx))),
+					_mm256_mul_pd(_mm256_mul_pd(two, dx), dy)), cy);
+				dx = nx;
+				dy = ny;
+				ref = _mm256_add_epi64(ref, one);
+				index = _mm256_slli_epi64(ref, 1);
+				const __m256d zx = _mm256_add_pd(_mm256_i64gather_pd(orbit, index, 8), dx);
+				const __m256d zy = _mm256_add_pd(_mm256_i64gather_pd(orbit + 1, index, 8), dy);
+				const __m256d m = _mm256_add_pd(_mm256_mul_pd(zx, zx), _mm256_mul_pd(zy, zy));
+				const __m256d escaped = _mm256_and_pd(_mm256_cmp_pd(m, four, _CMP_GT_OQ), active);
+				if (_mm256_movemask_pd(escaped)) {
+					iter = _mm256_blendv_pd(iter, _mm256_set1_pd((double)i), escaped);
+					mag2 = _mm256_blendv_pd(mag2, m, escaped);
+					active = _mm256_andnot_pd(escaped, active);
+					if (!_mm256_movemask_pd(active)) break;
+				}
+				const __m256d dz2 = _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy));
+				const __m256d rebase = _mm256_or_pd(_mm256_cmp_pd(m, dz2, _CMP_LT_OQ), _mm256_castsi256_pd(_mm256_cmpeq_epi64(ref, last)));
+				dx = _mm256_blendv_pd(dx, zx, rebase);
+				dy = _mm256_blendv_pd(dy, zy, rebase);
+				ref = _mm256_andnot_si256(_mm256_castpd_si256(rebase), ref);
+			}
+			alignas(32) double it[4], mg[4];
+			_mm256_store_pd(it, iter);
+			_mm256_store_pd(mg, mag2);
+			for (int k = 0; k < 4; ++k) {
+				out_iter[n + k] = (int)it[k];
+				out_mag2[n + k] = mg[k];
+			}
+		}
+		perturbScalar(count - n, dc_re + n, dc_im + n, orbit, orbit_length, max_iter, out_iter + n, out_mag2 + n);
+	}
+#endif
+
+	CpuRenderer::PerturbFn selectPerturbKernel(CpuRenderer::SimdLevel level) {
+#if MESMER_X86
+		if (level == CpuRenderer::SimdLevel::AVX512 || level == CpuRenderer::SimdLevel::AVX2) {
+			return perturbAvx2;
+		}
+#endif
+		return perturbScalar;
+	}
+
+	CpuRenderer::IterateFn selectKernel(CpuRenderer::SimdLevel level) {
+#if MESMER_X86
+		switch (level) {
+		case CpuRenderer::SimdLevel::AVX512: return iterateAvx512;
+		case CpuRenderer::SimdLevel::AVX2: return iterateAvx2;
+		case CpuRenderer::SimdLevel::SSE2: return iterateSse2;
+		default: break;
+		}
+#endif
+		return iterateScalar;
+	}
+
+	// same conversion the GL does when writing a float fragment into an RGBA8 attachment
+	unsigned char toUnorm8(float v) {
+		v = std::clamp(v, 0.0f, 1.0f);
+		return (unsigned char)std::lround(v * 255.0f);
+	}
+
+}
+
+CpuRenderer::CpuRenderer(unsigned int thread_count) {
+	m_thread_count = thread_count != 0 ? thread_count : std::max(1u, std::thread::hardware_concurrency());
+	m_simd_level = detectSimdLevel();
+	m_iterate = selectKernel(m_simd_level);
+	m_perturb = selectPerturbKernel(m_simd_level);
+	spdlog::info("CPU renderer: {} threads, {} kernels", m_thread_count, simdLevelName(m_simd_level));
+}
+
+CpuRenderer::~CpuRenderer() {
+	cancel();
+	finish();
+}
+
+CpuRenderer::SimdLevel CpuRenderer::detectSimdLevel() {
+#if MESMER_X86
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	const int max_leaf = info[0];
+	__cpuid(info, 1);
+	const bool sse2 = (info[3] & (1 << 26)) != 0;
+	const bool osxsave = (info[2] & (1 << 27)) != 0;
+	const bool avx = (info[2] & (1 << 28)) != 0;
+	bool avx2 = false;
+	bool avx512f = false;
+	if (max_leaf >= 7) {
+		__cpuidex(info, 7, 0);
+		avx2 = (info[1] & (1 << 5)) != 0;
+		avx512f = (info[1] & (1 << 16)) != 0;
+	}
+	// the os has to save the ymm/zmm state on context switches, otherwise the instructions fault
+	const unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+	const bool ymm_state = (xcr0 & 0x6) == 0x6;
+	const bool zmm_state = (xcr0 & 0xE6) == 0xE6;
+	if (avx512f && zmm_state) return SimdLevel::AVX512;
+	if (avx && avx2 && ymm_state) return SimdLevel::AVX2;
+	if (sse2) return SimdLevel::SSE2;
+#else
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f")) return SimdLevel::AVX512;
+	if (__builtin_cpu_supports("avx2")) return SimdLevel::AVX2;
+	if (__builtin_cpu_supports("sse2")) return SimdLevel::SSE2;
+#endif
+#endif
+	return SimdLevel::SCALAR;
+}
+
+const char* CpuRenderer::simdLevelName(SimdLevel level) {
+	switch (level) {
+	case SimdLevel::AVX512: return "AVX-512";
+	case SimdLevel::AVX2: return "AVX2";
+	case SimdLevel::SSE2: return "SSE2";
+	default: return "Scalar";
+	}
+}
+
+const char* CpuRenderer::subdivisionName(CpuSubdivision mode) {
+	switch (mode) {
+	case CpuSubdivision::EXACT: return "Exact";
+	case CpuSubdivision::FILL: return "Interior fill";
+	case CpuSubdivision::GUESS: return "Guess";
+	default: return "Off";
+	}
+}
+
+void CpuRenderer::begin(const CpuRenderParams& params, TileScheduler& scheduler, unsigned int first_worker) {
+	finish();
+	m_params = params;
+	m_scheduler = &scheduler;
+	m_cancelled.store(false);
+	m_tiles_done.store(0);
+	m_done_tiles.clear();
+	m_active_workers.store(m_thread_count);
+	for (unsigned int t = 0; t < m_thread_count; ++t) {
+		m_threads.emplace_back(&CpuRenderer::workerLoop, this, first_worker + t);
+	}
+}
+
+bool CpuRenderer::waitTile(CpuTile& tile) {
+	std::unique_lock<std::mutex> lock(m_done_mutex);
+	m_done_cv.wait(lock, [this] {
+		return !m_done_tiles.empty() || m_cancelled.load() || m_active_workers.load() == 0;
+	});
+	if (m_done_tiles.empty() || m_cancelled.load()) {
+		return false;
+	}
+	tile = std::move(m_done_tiles.front());
+	m_done_tiles.pop_front();
+	m_done_cv.notify_all();
+	return true;
+}
+
+bool CpuRenderer::pollTile(CpuTile& tile) {
+	std::lock_guard<std::mutex> lock(m_done_mutex);
+	if (m_done_tiles.empty() || m_cancelled.load()) {
+		return false;
+	}
+	tile = std::move(m_done_tiles.front());
+	m_done_tiles.pop_front();
+	m_done_cv.notify_all();
+	return true;
+}
+
+void CpuRenderer::cancel() {
+	m_cancelled.store(true);
+	if (m_scheduler) {
+		m_scheduler->cancel();
+	}
+	std::lock_guard<std::mutex> lock(m_done_mutex);
+	m_done_cv.notify_all();
+}
+
+void CpuRenderer::finish() {
+	for (auto& thread : m_threads) {
+		if (thread.joinable()) thread.join();
+	}
+	m_threads.clear();
+	m_scheduler = nullptr;
+}
+
+void CpuRenderer::workerLoop(unsigned int worker) {
+	ScheduledTile rect;
+	while (!m_cancelled.load() && m_scheduler->acquire(worker, rect)) {
+		CpuTile tile;
+		tile.x = rect.x;
+		tile.y = rect.y;
+		tile.width = rect.width;
+		tile.height = rect.height;
+		tile.pixels.resize((size_t)rect.width * rect.height * 4);
+		const auto start = std::chrono::steady_clock::now();
+		if (m_params.gbuffer) {
+			tile.values.resize((size_t)rect.width * rect.height);
+			renderRegionGBuffer(m_params, rect.x, rect.y, rect.width, rect.height, tile.values.data(), rect.width, tile.pixels.data(), rect.width * 4);
+		}
+		else {
+			renderRegion(m_params, rect.x, rect.y, rect.width, rect.height, tile.pixels.data(), rect.width * 4);
+		}
+		tile.milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		std::unique_lock<std::mutex> lock(m_done_mutex);
+		m_done_cv.wait(lock, [this] {
+			return m_done_tiles.size() < MAX_PENDING_TILES_PER_THREAD * m_thread_count || m_cancelled.load();
+		});
+		if (m_cancelled.load()) {
+			break;
+		}
+		m_done_tiles.push_back(std::move(tile));
+		m_tiles_done.fetch_add(1);
+		m_scheduler->complete(rect);
+		m_done_cv.notify_all();
+	}
+	std::lock_guard<std::mutex> lock(m_done_mutex);
+	m_active_workers.fetch_sub(1);
+	m_done_cv.notify_all();
+}
+
+void CpuRenderer::renderRegion(const CpuRenderParams& params, int x0, int y0, int w, int h, unsigned char* dst, int dst_stride) const {
+	iterateRegion(params, x0, y0, w, h, [&](int row, const int* iters, const double* mag2) {
+		shadeRow(params, w, iters, mag2, dst + (size_t)row * dst_stride);
+	});
+}
+
+void CpuRenderer::renderRegionGBuffer(const CpuRenderParams& params, int x0, int y0, int w, int h, float* values, int values_stride,
+	unsigned char* orbit, int orbit_stride) const {
+	iterateRegion(params, x0, y0, w, h, [&](int row, const int* iters, const double* mag2) {
+		gbufferRow(params, w, iters, mag2, values + (size_t)row * values_stride, orbit + (size_t)row * orbit_stride);
+	});
+}
+
+void CpuRenderer::iterateRegion(const CpuRenderParams& params, int x0, int y0, int w, int h, const RowFn& emit) const {
+	if (params.subdivision != CpuSubdivision::OFF) {
+		iterateRegionSubdivided(params, x0, y0, w, h, emit);
+		return;
+	}
+	const double aspect = (double)params.width / (double)params.height;
+	const int batch_rows = params.compaction_chunk > 0 ? std::clamp(COMPACTION_BATCH_PIXELS / std::max(w, 1), 1, h) : 1;
+	const size_t batch = (size_t)w * batch_rows;
+	std::vector<double> u(batch), v(batch), mag2(batch);
+	std::vector<int> iters(batch);
+	PointScratch scratch;
+	// pixel centres, identical to the interpolated TexCoords of the fullscreen / tiled quad
+	for (int row = 0; row < batch_rows; ++row) {
+		for (int col = 0; col < w; ++col) {
+			u[(size_t)row * w + col] = (((double)(x0 + col) + 0.5) / (double)params.width * 2.0 - 1.0) * aspect;
+		}
+	}
+	for (int row = 0; row < h; row += batch_rows) {
+		const int rows = std::min(batch_rows, h - row);
+		for (int r = 0; r < rows; ++r) {
+			std::fill(v.begin() + (size_t)r * w, v.begin() + (size_t)(r + 1) * w, ((double)(y0 + row + r) + 0.5) / (double)params.height * 2.0 - 1.0);
+		}
+		iteratePoints(params, w * rows, u.data(), v.data(), iters.data(), mag2.data(), scratch);
+		for (int r = 0; r < rows; ++r) {
+			emit(row + r, iters.data() + (size_t)r * w, mag2.data() + (size_t)r * w);
+		}
+	}
+}
+
+void CpuRenderer::iterateRegionSubdivided(const CpuRenderParams& params, int x0, int y0, int w, int h, const RowFn& emit) const {
+	struct Rect { int x, y, w, h; };
+	const double aspect = (double)params.width / (double)params.height;
+	std::vector<double> u(w), v(h);
+	for (int col = 0; col < w; ++col) {
+		u[col] = (((double)(x0 + col) + 0.5) / (double)params.width * 2.0 - 1.0) * aspect;
+	}
+	for (int row = 0; row < h; ++row) {
+		v[row] = ((double)(y0 + row) + 0.5) / (double)params.height * 2.0 - 1.0;
+	}
+	std::vector<int> iters((size_t)w * h, SUBDIVISION_UNKNOWN);
+	std::vector<double> mag2((size_t)w * h, 0.0);
+
+	// the borders of a whole level of rectangles go through the kernels in one batch, single borders are too short for the simd lanes
+	std::vector<int> pending;
+	std::vector<double> pending_u, pending_v, pending_mag2;
+	std::vector<int> pending_iters;
+	PointScratch scratch;
+	auto request = [&](int x, int y) {
+		const int index = y * w + x;
+		if (iters[index] == SUBDIVISION_UNKNOWN) {
+			iters[index] = SUBDIVISION_QUEUED;
+			pending.push_back(index);
+		}
+	};
+	auto flush = [&]() {
+		const int count = (int)pending.size();
+		pending_u.resize(count);
+		pending_v.resize(count);
+		pending_iters.resize(count);
+		pending_mag2.resize(count);
+		for (int k = 0; k < count; ++k) {
+			pending_u[k] = u[pending[k] % w];
+			pending_v[k] = v[pending[k] / w];
+		}
+		iteratePoints(params, count, pending_u.data(), pending_v.data(), pending_iters.data(), pending_mag2.data(), scratch);
+		for (int k = 0; k < count; ++k) {
+			iters[pending[k]] = pending_iters[k];
+			mag2[pending[k]] = pending_mag2[k];
+		}
+		pending.clear();
+	};
+	auto small = [](const Rect& r) { return r.w < SUBDIVISION_MIN_SIZE || r.h < SUBDIVISION_MIN_SIZE; };
+	// the bulb is a disk and the cardioid left of its cusp is convex, so a rectangle whose corners are inside one of them is
+	// interior everywhere, the same pixels the per-pixel path short-cuts with insideCardioidOrBulb
+	const bool exact = params.subdivision == CpuSubdivision::EXACT;
+	const bool provable = exact && params.fractal == CpuFractal::MANDELBROT && !params.reference;
+	auto provablyInterior = [&](const Rect& r) {
+		const double left = u[r.x] / params.zoom + params.center_x;
+		const double right = u[r.x + r.w - 1] / params.zoom + params.center_x;
+		const double bottom = v[r.y] / params.zoom + params.center_y;
+		const double top = v[r.y + r.h - 1] / params.zoom + params.center_y;
+		if (right <= 0.25 && insideCardioid(left, bottom) && insideCardioid(right, bottom) && insideCardioid(left, top) &&
+			insideCardioid(right, top)) {
+			return true;
+		}
+		return insideBulb(left, bottom) && insideBulb(right, bottom) && insideBulb(left, top) && insideBulb(right, top);
+	};
+
+	std::vector<Rect> level{ { 0, 0, w, h } };
+	std::vector<Rect> next;
+	while (!level.empty()) {
+		if (provable) {
+			level.erase(std::remove_if(level.begin(), level.end(), [&](const Rect& r) {
+				if (!provablyInterior(r)) {
+					return false;
+				}
+				for (int y = r.y; y < r.y + r.h; ++y) {
+					for (int x = r.x; x < r.x + r.w; ++x) {
+						if (iters[(size_t)y * w + x] == SUBDIVISION_UNKNOWN) {
+							iters[(size_t)y * w + x] = params.max_iterations;
+						}
+					}
+				}
+				return true;
+			}), level.end());
+		}
+		for (const Rect& r : level) {
+			if (small(r)) {
+				for (int y = r.y; y < r.y + r.h; ++y) {
+					for (int x = r.x; x < r.x + r.w; ++x) request(x, y);
+				}
+				continue;
+			}
+			for (int x = r.x; x < r.x + r.w; ++x) {
+				request(x, r.y);
+				request(x, r.y + r.h - 1);
+			}
+			for (int y = r.y + 1; y < r.y + r.h - 1; ++y) {
+				request(r.x, y);
+				request(r.x + r.w - 1, y);
+			}
+		}
+		flush();
+
+		next.clear();
+		for (const Rect& r : level) {
+			if (small(r)) {
+				continue;
+			}
+			const int right = r.x + r.w - 1;
+			const int top = r.y + r.h - 1;
+			const int value = iters[(size_t)r.y * w + r.x];
+			bool uniform = true;
+			for (int x = r.x; x < r.x + r.w && uniform; ++x) {
+				uniform = iters[(size_t)r.y * w + x] == value && iters[(size_t)top * w + x] == value;
+			}
+			for (int y = r.y + 1; y < top && uniform; ++y) {
+				uniform = iters[(size_t)y * w + r.x] == value && iters[(size_t)y * w + right] == value;
+			}
+			// an interior border alone does not prove the inside, exact mode only fills the rectangles removed above
+			if (uniform && value == params.max_iterations && !exact) {
+				for (int y = r.y + 1; y < top; ++y) {
+					std::fill_n(iters.begin() + (size_t)y * w + r.x + 1, r.w - 2, value);
+				}
+				continue;
+			}
+			if (uniform && params.subdivision == CpuSubdivision::GUESS) {
+				// average of the row and column interpolations keeps the smooth colouring continuous with the border
+				for (int y = r.y + 1; y < top; ++y) {
+					const double ty = (double)(y - r.y) / (double)(r.h - 1);
+					const double left_mag2 = mag2[(size_t)y * w + r.x];
+					const double right_mag2 = mag2[(size_t)y * w + right];
+					for (int x = r.x + 1; x < right; ++x) {
+						const double tx = (double)(x - r.x) / (double)(r.w - 1);
+						const double bottom_mag2 = mag2[(size_t)r.y * w + x];
+						const double top_mag2 = mag2[(size_t)top * w + x];
+						const double across = left_mag2 + (right_mag2 - left_mag2) * tx;
+						const double along = bottom_mag2 + (top_mag2 - bottom_mag2) * ty;
+						iters[(size_t)y * w + x] = value;
+						mag2[(size_t)y * w + x] = 0.5 * (across + along);
+					}
+				}
+				continue;
+			}
+			// quarters share the middle row and column, those pixels are only iterated once
+			const int mx = r.x + r.w / 2;
+			const int my = r.y + r.h / 2;
+			next.push_back({ r.x, r.y, mx - r.x + 1, my - r.y + 1 });
+			next.push_back({ mx, r.y, r.x + r.w - mx, my - r.y + 1 });
+			next.push_back({ r.x, my, mx - r.x + 1, r.y + r.h - my });
+			next.push_back({ mx, my, r.x + r.w - mx, r.y + r.h - my });
+		}
+		std::swap(level, next);
+	}
+
+	for (int row = 0; row < h; ++row) {
+		emit(row, iters.data() + (size_t)row * w, mag2.data() + (size_t)row * w);
+	}
+}
+
+void CpuRenderer::iteratePoints(const CpuRenderParams& params, int count, const double* u, const double* v, int* iters, double* mag2,
+	PointScratch& scratch) const {
+	if (count <= 0) {
+		return;
+	}
+	if ((int)scratch.z_re.size() < count) {
+		scratch.z_re.resize(count);
+		scratch.z_im.resize(count);
+		scratch.c_re.resize(count);
+		scratch.c_im.resize(count);
+		scratch.saved_re.resize(count);
+		scratch.saved_im.resize(count);
+		scratch.lanes.resize(count);
+		scratch.chunk_lanes.resize(count);
+	}
+	double* z_re = scratch.z_re.data();
+	double* z_im = scratch.z_im.data();
+	double* c_re = scratch.c_re.data();
+	double* c_im = scratch.c_im.data();
+	int* lanes = scratch.lanes.data();
+	const bool julia = params.fractal == CpuFractal::JULIA;
+	const bool perturb = params.reference && params.fractal == CpuFractal::MANDELBROT;
+
+	if (perturb) {
+		// the bla radii only hold for |dc| up to the c_max the table was built for
+		bool use_bla = false;
+		if (params.zoom >= BLA_MIN_ZOOM && params.reference->bla.levels() > 0) {
+			const double aspect = (double)params.width / (double)params.height;
+			const double dc_max = std::hypot(params.reference_offset_x, params.reference_offset_y) + std::hypot(aspect, 1.0) / params.zoom;
+			use_bla = dc_max <= params.reference->bla.c_max;
+		}
+		// c is only known relative to the reference, the offsets stay tiny so doubles keep their precision
+		for (int n = 0; n < count; ++n) {
+			c_re[n] = u[n] / params.zoom + params.reference_offset_x;
+			c_im[n] = v[n] / params.zoom + params.reference_offset_y;
+		}
+		if (use_bla) {
+			perturbBlaScalar(count, c_re, c_im, *params.reference, params.max_iterations, iters, mag2);
+		}
+		else {
+			m_perturb(count, c_re, c_im, params.reference->points.data(), params.reference->length(), params.max_iterations, iters, mag2);
+		}
+		return;
+	}
+	for (int n = 0; n < count; ++n) {
+		const double px = u[n] / params.zoom + params.center_x;
+		const double py = v[n] / params.zoom + params.center_y;
+		if (julia) {
+			z_re[n] = px;
+			z_im[n] = py;
+			c_re[n] = params.julia_c_x;
+			c_im[n] = params.julia_c_y;
+		}
+		else {
+			z_re[n] = 0.0;
+			z_im[n] = 0.0;
+			c_re[n] = px;
+			c_im[n] = py;
+		}
+	}
+	if (julia) {
+		iterateLanes(params, count, iters, mag2, scratch);
+		return;
+	}
+	// cardioid and bulb pixels are interior without iterating, the rest is packed to the front for the kernel
+	int active = 0;
+	for (int n = 0; n < count; ++n) {
+		if (!insideCardioidOrBulb(c_re[n], c_im[n])) {
+			lanes[active] = n;
+			c_re[active] = c_re[n];
+			c_im[active] = c_im[n];
+			++active;
+		}
+	}
+	iterateLanes(params, active, iters, mag2, scratch);
+	// scatter back from the end, a packed lane never sits right of its point
+	for (int n = count - 1, k = active - 1; n >= 0; --n) {
+		if (k >= 0 && lanes[k] == n) {
+			iters[n] = iters[k];
+			mag2[n] = mag2[k];
+			--k;
+		}
+		else {
+			iters[n] = params.max_iterations;
+			mag2[n] = 0.0;
+		}
+	}
+}
+
+void CpuRenderer::iterateLanes(const CpuRenderParams& params, int count, int* iters, double* mag2, PointScratch& scratch) const {
+	double* z_re = scratch.z_re.data();
+	double* z_im = scratch.z_im.data();
+	double* c_re = scratch.c_re.data();
+	double* c_im = scratch.c_im.data();
+	double* saved_re = scratch.saved_re.data();
+	double* saved_im = scratch.saved_im.data();
+	std::copy(z_re, z_re + count, saved_re);
+	std::copy(z_im, z_im + count, saved_im);
+	const int max_iter = params.max_iterations;
+	if (params.compaction_chunk <= 0) {
+		m_iterate(count, z_re, z_im, c_re, c_im, saved_re, saved_im, 0, max_iter, PERIOD_FIRST_SAVE, max_iter, iters, mag2);
+		return;
+	}
+	// the chunk results land in the lanes' own slots, finished lanes move them to their point through the lane map
+	int* lanes = scratch.chunk_lanes.data();
+	for (int n = 0; n < count; ++n) {
+		lanes[n] = n;
+	}
+	std::vector<int> chunk_iters(count);
+	std::vector<double> chunk_mag2(count);
+	int active = count;
+	int begin = 0;
+	int chunk = params.compaction_chunk;
+	int next_save = PERIOD_FIRST_SAVE;
+	while (active > 0 && begin < max_iter) {
+		const int end = (int)std::min<long long>((long long)begin + chunk, max_iter);
+		m_iterate(active, z_re, z_im, c_re, c_im, saved_re, saved_im, begin, end, next_save, max_iter, chunk_iters.data(), chunk_mag2.data());
+		// running prefix count of the survivors gives each one its slot in the next chunk, kept <= k so this packs in place
+		int kept = 0;
+		for (int k = 0; k < active; ++k) {
+			if (chunk_iters[k] >= 0) {
+				iters[lanes[k]] = chunk_iters[k];
+				mag2[lanes[k]] = chunk_mag2[k];
+				continue;
+			}
+			z_re[kept] = z_re[k];
+			z_im[kept] = z_im[k];
+			c_re[kept] = c_re[k];
+			c_im[kept] = c_im[k];
+			saved_re[kept] = saved_re[k];
+			saved_im[kept] = saved_im[k];
+			lanes[kept] = lanes[k];
+			++kept;
+		}
+		next_save = periodSaveAfter(begin, end, next_save);
+		active = kept;
+		begin = end;
+		chunk = (int)std::min<long long>((long long)chunk * 2, max_iter);
+	}
+}
+
+void CpuRenderer::shadeRow(const CpuRenderParams& params, int count, const int* iters, const double* mag2, unsigned char* dst) const {
+	for (int n = 0; n < count; ++n) {
+		unsigned char* px = dst + (size_t)n * 4;
+		if (iters[n] == params.max_iterations) {
+			px[0] = 0; px[1] = 0; px[2] = 0; px[3] = 255;
+			continue;
+		}
+		// float math from here on, like the shaders
+		const float magnitude = (float)mag2[n];
+		const float smooth_i = (float)iters[n] - std::log2(std::log2(magnitude));
+		const float t = smooth_i * params.color_density;
+		for (int k = 0; k < 3; ++k) {
+			const float value = params.palette_a[k] + params.palette_b[k] * std::cos(6.28318f * (params.palette_c[k] * t + params.palette_d[k]));
+			px[k] = toUnorm8(value);
+		}
+		px[3] = 255;
+	}
+}
+
+void CpuRenderer::gbufferRow(const CpuRenderParams& params, int count, const int* iters, const double* mag2, float* values, unsigned char* orbit) const {
+	for (int n = 0; n < count; ++n) {
+		unsigned char* word = orbit + (size_t)n * 4;
+		// arg(z) is not known here, 128 is the encoding of arg 0 that gbuffer.glsl also writes for interior pixels
+		word[1] = 128;
+		word[2] = 0;
+		if (iters[n] == params.max_iterations) {
+			values[n] = 0.0f;
+			word[0] = 0;
+			word[3] = 0;
+			continue;
+		}
+		const float magnitude = (float)mag2[n];
+		values[n] = (float)iters[n] - std::log2(std::log2(magnitude));
+		word[0] = toUnorm8(0.5f * std::log2(magnitude) / GBUFFER_LOG_RANGE + 0.5f);
+		word[3] = 1;
+	}
+}
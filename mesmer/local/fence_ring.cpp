@@ -0,0 +1,108 @@
+/*
+	Mesmer - An interactive and high-performance fractal generator and explorer.
+	Made by -> Titan // GH: https://github.com/titan3755/mesmer
+	[fence_ring.cpp]
+*/
+
+#include <fence_ring.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <spdlog/spdlog.h>
+
+namespace {
+
+	constexpr int MIN_DEPTH = 2;        // one draw executing, one queued behind it
+	constexpr float DRAW_MS_SMOOTHING = 0.2f;
+
+}
+
+bool FenceRing::create(int max_depth, float target_queue_ms) {
+	release();
+	m_slots.resize(std::max(max_depth, MIN_DEPTH));
+	bool created = true;
+	for (Slot& slot : m_slots) {
+		glGenQueries(1, &slot.query);
+		created = created && slot.query != 0;
+	}
+	m_target_queue_ms = target_queue_ms;
+	m_draw_ms = 0.0f;
+	m_depth = MIN_DEPTH;
+	m_next = 0;
+	m_pending = 0;
+	m_open = false;
+	return created;
+}
+
+void FenceRing::release() {
+	for (Slot& slot : m_slots) {
+		if (slot.fence) {
+			glDeleteSync(slot.fence);
+		}
+		if (slot.query) {
+			glDeleteQueries(1, &slot.query);
+		}
+	}
+	m_slots.clear();
+	m_next = 0;
+	m_pending = 0;
+	m_open = false;
+}
+
+int FenceRing::begin() {
+	// the slot would still be in flight, its fence and timing must survive until it retires
+	if (m_open || m_pending >= (int)m_slots.size()) {
+		spdlog::error("Fence ring: draw started without a free slot.");
+		return -1;
+	}
+	glBeginQuery(GL_TIME_ELAPSED, m_slots[m_next].query);
+	m_open = true;
+	return m_next;
+}
+
+void FenceRing::end() {
+	if (!m_open) {
+		return;
+	}
+	m_open = false;
+	Slot& slot = m_slots[m_next];
+	glEndQuery(GL_TIME_ELAPSED);
+	slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	// a submission per draw, the watchdog times submissions and the gpu can start on this one right away
+	glFlush();
+	m_next = (m_next + 1) % (int)m_slots.size();
+	++m_pending;
+}
+
+bool FenceRing::retire(GLuint64 timeout_ns, const std::function<void(int slot, float gpu_ms)>& consume) {
+	if (empty()) {
+		return false;
+	}
+	const int count = (int)m_slots.size();
+	const int index = (m_next - m_pending + count) % count;
+	Slot& slot = m_slots[index];
+	// every fence was flushed in end(), no flush bit needed
+	const GLenum wait_result = glClientWaitSync(slot.fence, 0, timeout_ns);
+	if (wait_result == GL_TIMEOUT_EXPIRED) {
+		return false;
+	}
+	glDeleteSync(slot.fence);
+	slot.fence = nullptr;
+	--m_pending;
+	float gpu_ms = 0.0f;
+	if (wait_result == GL_WAIT_FAILED) {
+		spdlog::error("Fence ring: fence wait failed.");
+	}
+	else {
+		// the fence follows the query's end, so the result is in
+		GLuint64 elapsed_ns = 0;
+		glGetQueryObjectui64v(slot.query, GL_QUERY_RESULT, &elapsed_ns);
+		gpu_ms = (float)((double)elapsed_ns / 1.0e6);
+		m_draw_ms = m_draw_ms > 0.0f ? m_draw_ms + (gpu_ms - m_draw_ms) * DRAW_MS_SMOOTHING : gpu_ms;
+		// enough draws queued behind the running one to cover the target, cheap draws need a deeper window
+		const int wanted = 1 + (int)std::ceil(m_target_queue_ms / std::max(m_draw_ms, 0.01f));
+		m_depth = std::clamp(wanted, MIN_DEPTH, count);
+	}
+	consume(index, gpu_ms);
+	return true;
+}
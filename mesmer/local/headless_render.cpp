@@ -0,0 +1,311 @@
+/*
+	Mesmer - An interactive and high-performance fractal generator and explorer.
+	Made by -> Titan // GH: https://github.com/titan3755/mesmer
+	[headless_render.cpp]
+*/
+
+#include <headless_render.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include <big_float.hpp>
+#include <cpu_renderer.hpp>
+#include <perturbation.hpp>
+#include <png_writer.hpp>
+#include <tile_scheduler.hpp>
+
+namespace {
+
+	constexpr int DEFAULT_TILE_SIZE = 128;
+	constexpr int MAX_IMAGE_SIDE = 1 << 20;            // png allows 2^31 - 1, this is well past anything sensible
+
+	struct HeadlessOptions {
+		CpuRenderParams params;
+		std::string center_x = "-0.75";
+		std::string center_y = "0.0";
+		std::string output;
+		unsigned int threads = 0;
+		int tile_size = DEFAULT_TILE_SIZE;
+	};
+
+	void printUsage() {
+		std::cout <<
+			"usage: mesmer render [options] --output image.png\n"
+			"  --fractal mandelbrot|julia   fractal to render (default mandelbrot)\n"
+			"  --center X,Y                 view centre, any number of digits (default -0.75,0)\n"
+			"  --zoom Z                     zoom, 1 shows the whole set (default 1)\n"
+			"  --iterations N               maximum iterations (default 5000)\n"
+			"  --julia-c X,Y                julia constant (default -0.7,0.27015)\n"
+			"  --density D                  colour density (default 0.05)\n"
+			"  --palette a,a,a,b,b,b,c,c,c,d,d,d\n"
+			"                               cosine palette coefficients (default 0.5,0.5,0.5,0.5,0.5,0.5,1,1,1,0,0.1,0.2)\n"
+			"  --size WxH                   image size in pixels (default 1920x1080)\n"
+			"  --subdivision off|exact|fill|guess\n"
+			"                               mariani-silver subdivision, exact matches off, fill and guess can miss thin filaments (default off)\n"
+			"  --compaction N               iterate in chunks from N iterations, compacting the pixels still running (default 0, off)\n"
+			"  --tile N                     tile size in pixels (default 128)\n"
+			"  --threads N                  worker threads, 0 for one per core (default 0)\n"
+			"  --output path.png            image to write\n"
+			"exit codes: 0 rendered, 1 render or write failed, 2 bad arguments\n";
+	}
+
+	bool splitPair(const std::string& text, char separator, std::string& first, std::string& second) {
+		const size_t split = text.find(separator);
+		if (split == std::string::npos || split == 0 || split + 1 >= text.size()) {
+			return false;
+		}
+		first = text.substr(0, split);
+		second = text.substr(split + 1);
+		return true;
+	}
+
+	bool parseDouble(const std::string& text, double& out) {
+		char* end = nullptr;
+		out = std::strtod(text.c_str(), &end);
+		return !text.empty() && end == text.c_str() + text.size();
+	}
+
+	bool parseInt(const std::string& text, long long low, long long high, int& out) {
+		char* end = nullptr;
+		const long long value = std::strtoll(text.c_str(), &end, 10);
+		if (text.empty() || end != text.c_str() + text.size() || value < low || value > high) {
+			return false;
+		}
+		out = (int)value;
+		return true;
+	}
+
+	bool parsePalette(const std::string& text, CpuRenderParams& params) {
+		float* targets[4] = { params.palette_a, params.palette_b, params.palette_c, params.palette_d };
+		size_t start = 0;
+		for (int i = 0; i < 12; ++i) {
+			const size_t split = text.find(',', start);
+			if ((split == std::string::npos) != (i == 11)) {
+				return false;
+			}
+			double value = 0.0;
+			if (!parseDouble(text.substr(start, split == std::string::npos ? std::string::npos : split - start), value)) {
+				return false;
+			}
+			targets[i / 3][i % 3] = (float)value;
+			start = split + 1;
+		}
+		return true;
+	}
+
+	// returns an empty string on success, otherwise what was wrong
+	std::string parseOptions(int argc, char* argv[], HeadlessOptions& options) {
+		CpuRenderParams& params = options.params;
+		params.width = 1920;
+		params.height = 1080;
+		params.subdivision = CpuSubdivision::OFF;
+		for (int i = 0; i < argc; ++i) {
+			const std::string option = argv[i];
+			if (i + 1 >= argc) {
+				return "missing value for " + option;
+			}
+			const std::string value = argv[++i];
+			std::string first;
+			std::string second;
+			bool valid = true;
+			if (option == "--fractal") {
+				if (value == "mandelbrot") {
+					params.fractal = CpuFractal::MANDELBROT;
+				}
+				else if (value == "julia") {
+					params.fractal = CpuFractal::JULIA;
+				}
+				else {
+					return "unsupported fractal '" + value + "', headless renders run on the cpu engine which knows mandelbrot and julia";
+				}
+			}
+			else if (option == "--center") {
+				valid = splitPair(value, ',', options.center_x, options.center_y);
+			}
+			else if (option == "--zoom") {
+				valid = parseDouble(value, params.zoom) && params.zoom > 0.0;
+			}
+			else if (option == "--iterations") {
+				valid = parseInt(value, 1, 100000000, params.max_iterations);
+			}
+			else if (option == "--julia-c") {
+				valid = splitPair(value, ',', first, second) && parseDouble(first, params.julia_c_x) && parseDouble(second, params.julia_c_y);
+			}
+			else if (option == "--density") {
+				double density = 0.0;
+				valid = parseDouble(value, density) && density > 0.0;
+				params.color_density = (float)density;
+			}
+			else if (option == "--palette") {
+				valid = parsePalette(value, params);
+			}
+			else if (option == "--size") {
+				valid = splitPair(value, 'x', first, second) && parseInt(first, 1, MAX_IMAGE_SIDE, params.width) &&
+					parseInt(second, 1, MAX_IMAGE_SIDE, params.height);
+			}
+			else if (option == "--subdivision") {
+				if (value == "off") {
+					params.subdivision = CpuSubdivision::OFF;
+				}
+				else if (value == "exact") {
+					params.subdivision = CpuSubdivision::EXACT;
+				}
+				else if (value == "fill") {
+					params.subdivision = CpuSubdivision::FILL;
+				}
+				else if (value == "guess") {
+					params.subdivision = CpuSubdivision::GUESS;
+				}
+				else {
+					valid = false;
+				}
+			}
+			else if (option == "--compaction") {
+				valid = parseInt(value, 0, 1 << 20, params.compaction_chunk);
+			}
+			else if (option == "--tile") {
+				valid = parseInt(value, 16, 4096, options.tile_size);
+			}
+			else if (option == "--threads") {
+				int threads = 0;
+				valid = parseInt(value, 0, 1024, threads);
+				options.threads = (unsigned int)threads;
+			}
+			else if (option == "--output") {
+				options.output = value;
+			}
+			else {
+				return "unknown option " + option;
+			}
+			if (!valid) {
+				return "invalid value '" + value + "' for " + option;
+			}
+		}
+		if (options.output.empty()) {
+			return "no --output given";
+		}
+		return "";
+	}
+
+	// rows of tiles are written out once every tile in them is in, so only the rows in flight are ever held
+	struct TileBand {
+		std::vector<unsigned char> pixels;
+		int remaining = 0;
+	};
+
+}
+
+int runHeadlessRender(int argc, char* argv[]) {
+	for (int i = 0; i < argc; ++i) {
+		const std::string option = argv[i];
+		if (option == "--help" || option == "-h") {
+			printUsage();
+			return HEADLESS_EXIT_OK;
+		}
+	}
+	HeadlessOptions options;
+	const std::string problem = parseOptions(argc, argv, options);
+	if (!problem.empty()) {
+		std::cerr << "mesmer render: " << problem << "\n";
+		printUsage();
+		return HEADLESS_EXIT_USAGE;
+	}
+	CpuRenderParams& params = options.params;
+
+	// the centre is kept exact for the reference orbit, the double is enough for everything shallower
+	BigFloat center_x;
+	BigFloat center_y;
+	if (!BigFloat::fromString(options.center_x, center_x) || !BigFloat::fromString(options.center_y, center_y)) {
+		std::cerr << "mesmer render: invalid value for --center\n";
+		return HEADLESS_EXIT_USAGE;
+	}
+	params.center_x = center_x.toDouble();
+	params.center_y = center_y.toDouble();
+	if (params.fractal == CpuFractal::MANDELBROT && params.zoom >= DEEP_ZOOM_THRESHOLD) {
+		std::cout << "computing reference orbit (" << params.max_iterations << " iterations)" << std::endl;
+		params.reference = computeReferenceOrbit(center_x, center_y, params.zoom, params.max_iterations);
+		if (!params.reference) {
+			std::cerr << "mesmer render: reference orbit failed\n";
+			return HEADLESS_EXIT_FAILED;
+		}
+		params.reference_offset_x = 0.0;
+		params.reference_offset_y = 0.0;
+	}
+
+	PngWriter writer;
+	if (!writer.open(options.output, params.width, params.height)) {
+		std::cerr << "mesmer render: cannot write " << options.output << "\n";
+		return HEADLESS_EXIT_FAILED;
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+	CpuRenderer renderer(options.threads);
+	TileScheduler scheduler(renderer.threadCount());
+	std::vector<ScheduledTile> tiles = TileScheduler::makeGrid(params.width, params.height, options.tile_size, params.width * 0.5, params.height * 0.5);
+	// the png is written top down, so the top rows of tiles go first and the bands complete roughly in order
+	const int band_count = (params.height + options.tile_size - 1) / options.tile_size;
+	std::map<int, TileBand> bands;
+	for (ScheduledTile& tile : tiles) {
+		tile.priority = (double)(band_count - 1 - tile.grid_y) * params.width + tile.x;
+		++bands[tile.grid_y].remaining;
+	}
+	scheduler.reset(std::move(tiles));
+	const int total = scheduler.total();
+	renderer.begin(params, scheduler, 0);
+
+	int next_band = band_count - 1;
+	int received = 0;
+	int last_percent = -1;
+	bool written = true;
+	CpuTile tile;
+	while (renderer.waitTile(tile)) {
+		const int grid_y = tile.y / options.tile_size;
+		TileBand& band = bands[grid_y];
+		// a band only takes memory once its first tile is in
+		if (band.pixels.empty()) {
+			band.pixels.resize((size_t)tile.height * params.width * 4);
+		}
+		for (int row = 0; row < tile.height; ++row) {
+			std::copy_n(tile.pixels.data() + (size_t)row * tile.width * 4, (size_t)tile.width * 4,
+				band.pixels.data() + ((size_t)row * params.width + tile.x) * 4);
+		}
+		--band.remaining;
+		++received;
+		// rows inside a band run bottom up like the image, the png wants them top down
+		while (written && next_band >= 0 && bands[next_band].remaining == 0) {
+			TileBand& done = bands[next_band];
+			const int band_rows = (int)(done.pixels.size() / ((size_t)params.width * 4));
+			for (int row = band_rows - 1; row >= 0 && written; --row) {
+				written = writer.writeRow(done.pixels.data() + (size_t)row * params.width * 4);
+			}
+			bands.erase(next_band);
+			--next_band;
+		}
+		const int percent = received * 100 / total;
+		if (percent != last_percent) {
+			last_percent = percent;
+			std::cout << "progress " << received << "/" << total << " tiles (" << percent << "%)" << std::endl;
+		}
+		if (!written) {
+			renderer.cancel();
+			break;
+		}
+	}
+	renderer.finish();
+
+	if (!written || !writer.close()) {
+		std::cerr << "mesmer render: writing " << options.output << " failed\n";
+		return HEADLESS_EXIT_FAILED;
+	}
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::cout << "rendered " << params.width << "x" << params.height << " " << (params.fractal == CpuFractal::JULIA ? "julia" : "mandelbrot")
+		<< " in " << seconds << " s (" << renderer.threadCount() << " threads, " << CpuRenderer::simdLevelName(renderer.simdLevel())
+		<< ", subdivision " << CpuRenderer::subdivisionName(params.subdivision) << ") to " << options.output << std::endl;
+	return HEADLESS_EXIT_OK;
+}
@@ -0,0 +1,50 @@
+/*
+	Mesmer - An interactive and high-performance fractal generator and explorer.
+	Made by -> Titan // GH: https://github.com/titan3755/mesmer
+	[iteration_state.cpp]
+*/
+
+#include <iteration_state.hpp>
+
+#include <spdlog/spdlog.h>
+
+bool IterationState::allocate(int width, int height) {
+	if (width == m_width && height == m_height && m_orbits != 0) {
+		return true;
+	}
+	release();
+	const GLsizeiptr pixels = (GLsizeiptr)width * height;
+	glCreateBuffers(1, &m_orbits);
+	glCreateBuffers(1, &m_status);
+	// only the shaders touch them, the status is written for every pixel before a resumed pass reads it
+	glNamedBufferStorage(m_orbits, pixels * 4 * sizeof(GLdouble), nullptr, 0);
+	glNamedBufferStorage(m_status, pixels * sizeof(GLuint), nullptr, 0);
+	if (m_orbits == 0 || m_status == 0) {
+		spdlog::error("Iteration state: {}x{} buffers could not be created.", width, height);
+		release();
+		return false;
+	}
+	m_width = width;
+	m_height = height;
+	spdlog::info("Iteration state allocated: {}x{} ({} MB)", width, height, pixels * (4 * sizeof(GLdouble) + sizeof(GLuint)) >> 20);
+	return true;
+}
+
+void IterationState::release() {
+	if (m_orbits != 0) {
+		glDeleteBuffers(1, &m_orbits);
+	}
+	if (m_status != 0) {
+		glDeleteBuffers(1, &m_status);
+	}
+	m_orbits = 0;
+	m_status = 0;
+	m_width = 0;
+	m_height = 0;
+	m_iterations = 0;
+}
+
+void IterationState::bind() const {
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, ITERATION_STATE_ORBIT_BINDING, m_orbits);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, ITERATION_STATE_STATUS_BINDING, m_status);
+}
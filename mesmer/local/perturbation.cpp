@@ -0,0 +1,151 @@
+/*
+	Mesmer - An interactive and high-performance fractal generator and explorer.
+	Made by -> Titan // GH: https://github.com/titan3755/mesmer
+	[perturbation.cpp]
+*/
+
+#include <perturbation.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace {
+
+	// dropping dz^2 next to 2*Z*dz must not be visible in a double, so |dz| has to stay below eps * |2Z|
+	constexpr double BLA_EPSILON = 1.0 / 9007199254740992.0; // 2^-53
+	// a table only pays off for orbits long enough to skip something
+	constexpr int BLA_MIN_ORBIT_LENGTH = 64;
+
+}
+
+BlaTable buildBlaTable(const std::vector<double>& orbit, double c_max) {
+	BlaTable table;
+	table.c_max = c_max;
+	const int length = (int)(orbit.size() / 2);
+	if (length < BLA_MIN_ORBIT_LENGTH) {
+		return table;
+	}
+	// level 0: single steps m -> m + 1 for m in [1, length - 2]
+	int count = length - 2;
+	table.level_offsets.push_back(0);
+	table.level_counts.push_back(count);
+	table.entries.reserve((size_t)count * 2 * 6);
+	for (int m = 1; m <= count; ++m) {
+		const double ax = 2.0 * orbit[2 * m];
+		const double ay = 2.0 * orbit[2 * m + 1];
+		const double radius = BLA_EPSILON * std::sqrt(ax * ax + ay * ay);
+		table.entries.insert(table.entries.end(), { ax, ay, 1.0, 0.0, radius, 0.0 });
+	}
+	// level k merges neighbouring pairs of level k - 1: x then y gives A = Ay*Ax, B = Ay*Bx + By,
+	// and dz after x is bounded by |Ax|*|dz| + |Bx|*c_max, which has to fit inside r_y
+	while (count >= 2) {
+		const int source = table.level_offsets.back();
+		count /= 2;
+		table.level_offsets.push_back((int)(table.entries.size() / 6));
+		table.level_counts.push_back(count);
+		for (int j = 0; j < count; ++j) {
+			const double* x = &table.entries[(size_t)(source + 2 * j) * 6];
+			const double* y = x + 6;
+			const double ax = y[0] * x[0] - y[1] * x[1];
+			const double ay = y[0] * x[1] + y[1] * x[0];
+			const double bx = y[0] * x[2] - y[1] * x[3] + y[2];
+			const double by = y[0] * x[3] + y[1] * x[2] + y[3];
+			const double ax_mag = std::sqrt(x[0] * x[0] + x[1] * x[1]);
+			const double bx_mag = std::sqrt(x[2] * x[2] + x[3] * x[3]);
+			const double radius = std::min(x[4], std::max(0.0, (y[4] - bx_mag * c_max) / ax_mag));
+			table.entries.insert(table.entries.end(), { ax, ay, bx, by, radius, 0.0 });
+		}
+	}
+	return table;
+}
+
+int BlaTable::apply(int ref, int remaining, double dc_x, double dc_y, double& dz_x, double& dz_y) const {
+	if (ref < 1 || level_counts.empty()) {
+		return 0;
+	}
+	const double dz_mag2 = dz_x * dz_x + dz_y * dz_y;
+	const int start = ref - 1;
+	// only levels whose grid lines up with the current index can start here, and a merged radius never exceeds the
+	// radius of its first half, so the scan goes up from the single step and stops at the first entry that does not fit
+	const int top = start == 0 ? levels() - 1 : std::min(std::countr_zero((unsigned int)start), levels() - 1);
+	const double* best = nullptr;
+	int best_step = 0;
+	for (int level = 0; level <= top; ++level) {
+		const int step = 1 << level;
+		const int j = start >> level;
+		if (step > remaining || j >= level_counts[level]) {
+			break;
+		}
+		const double* entry = &entries[(size_t)(level_offsets[level] + j) * 6];
+		if (dz_mag2 >= entry[4] * entry[4]) {
+			break;
+		}
+		best = entry;
+		best_step = step;
+	}
+	if (best != nullptr) {
+		const double nx = best[0] * dz_x - best[1] * dz_y + best[2] * dc_x - best[3] * dc_y;
+		const double ny = best[0] * dz_y + best[1] * dz_x + best[2] * dc_y + best[3] * dc_x;
+		dz_x = nx;
+		dz_y = ny;
+	}
+	return best_step;
+}
+
+int referencePrecisionLimbs(double zoom) {
+	// pixel spacing bits plus 64 guard bits, and headroom for zooming in before a rebuild is needed
+	const double bits = std::log2(std::max(zoom, 1.0)) + 64.0 + 32.0;
+	return std::clamp((int)std::ceil(bits / 32.0), 2, BigFloat::DEFAULT_FRACTION_LIMBS);
+}
+
+std::shared_ptr<ReferenceOrbit> computeReferenceOrbit(const BigFloat& center_x, const BigFloat& center_y, double zoom,
+	int max_iterations, const std::atomic<bool>* cancel) {
+	const int limbs = referencePrecisionLimbs(zoom);
+	auto reference = std::make_shared<ReferenceOrbit>();
+	reference->center_x = center_x;
+	reference->center_y = center_y;
+	reference->zoom = zoom;
+	reference->max_iterations = max_iterations;
+	reference->points.reserve((size_t)max_iterations * 2 + 2);
+
+	const BigFloat cx = center_x.withPrecision(limbs);
+	const BigFloat cy = center_y.withPrecision(limbs);
+	BigFloat zx(limbs);
+	BigFloat zy(limbs);
+	reference->points.push_back(0.0);
+	reference->points.push_back(0.0);
+	for (int n = 0; n < max_iterations; ++n) {
+		if (cancel && (n & 1023) == 0 && cancel->load()) {
+			return nullptr;
+		}
+		const BigFloat zx2 = zx * zx;
+		const BigFloat zy2 = zy * zy;
+		const BigFloat zxy = zx * zy;
+		zx = zx2 - zy2 + cx;
+		zy = zxy + zxy + cy;
+		const double re = zx.toDouble();
+		const double im = zy.toDouble();
+		reference->points.push_back(re);
+		reference->points.push_back(im);
+		if (re * re + im * im > 4.0) {
+			reference->escaped = true;
+			break;
+		}
+	}
+	reference->bla = buildBlaTable(reference->points, BLA_VIEW_RADII / zoom);
+	return reference;
+}
+
+bool referenceOrbitUsable(const ReferenceOrbit& reference, double offset_x, double offset_y, double zoom, int max_iterations) {
+	if (referencePrecisionLimbs(zoom) > referencePrecisionLimbs(reference.zoom)) {
+		return false;
+	}
+	if (!reference.escaped && reference.length() - 1 < max_iterations) {
+		return false;
+	}
+	// rebasing keeps far away references correct, but a reference inside the view needs far fewer of them,
+	// and zooming out too far would let |dc| outgrow what the bla table was built for
+	const double distance = std::sqrt(offset_x * offset_x + offset_y * offset_y) * zoom;
+	return distance < 4.0 && zoom * 4.0 >= reference.zoom;
+}
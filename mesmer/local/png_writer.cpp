@@ -0,0 +1,443 @@
+/*
+	Mesmer - An interactive and high-performance fractal generator and explorer.
+	Made by -> Titan // GH: https://github.com/titan3755/mesmer
+	[png_writer.cpp]
+*/
+
+#include <png_writer.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <spdlog/spdlog.h>
+
+namespace {
+
+	constexpr int WINDOW_SIZE = 32768;                 // deflate's maximum match distance
+	constexpr int RING_SIZE = WINDOW_SIZE * 2;
+	constexpr int HASH_SIZE = 1 << 15;
+	constexpr int MIN_MATCH = 3;
+	constexpr int MAX_MATCH = 258;
+	constexpr int MAX_CHAIN = 48;                      // candidates tried per position, longer chains barely pay off here
+	constexpr size_t CHUNK_BYTES = 1 << 18;             // IDAT payload size
+
+	constexpr int LENGTH_BASE[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115,
+		131, 163, 195, 227, 258 };
+	constexpr int LENGTH_EXTRA[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+	constexpr int DISTANCE_BASE[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537,
+		2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+	constexpr int DISTANCE_EXTRA[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+	const std::array<uint32_t, 256>& crcTable() {
+		static const std::array<uint32_t, 256> table = [] {
+			std::array<uint32_t, 256> entries{};
+			for (uint32_t n = 0; n < 256; ++n) {
+				uint32_t c = n;
+				for (int k = 0; k < 8; ++k) {
+					c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+				}
+				entries[n] = c;
+			}
+			return entries;
+		}();
+		return table;
+	}
+
+	uint32_t crc32(uint32_t crc, const unsigned char* data, size_t size) {
+		const std::array<uint32_t, 256>& table = crcTable();
+		crc = ~crc;
+		for (size_t i = 0; i < size; ++i) {
+			crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+		}
+		return ~crc;
+	}
+
+	void putBigEndian(unsigned char* out, uint32_t value) {
+		out[0] = (unsigned char)(value >> 24);
+		out[1] = (unsigned char)(value >> 16);
+		out[2] = (unsigned char)(value >> 8);
+		out[3] = (unsigned char)value;
+	}
+
+	int paeth(int a, int b, int c) {
+		const int p = a + b - c;
+		const int pa = std::abs(p - a);
+		const int pb = std::abs(p - b);
+		const int pc = std::abs(p - c);
+		if (pa <= pb && pa <= pc) {
+			return a;
+		}
+		return pb <= pc ? b : c;
+	}
+
+	uint32_t hash3(const std::vector<unsigned char>& ring, int64_t position) {
+		const uint32_t a = ring[position & (RING_SIZE - 1)];
+		const uint32_t b = ring[(position + 1) & (RING_SIZE - 1)];
+		const uint32_t c = ring[(position + 2) & (RING_SIZE - 1)];
+		return ((a << 10) ^ (b << 5) ^ c) & (HASH_SIZE - 1);
+	}
+
+}
+
+PngWriter::~PngWriter() {
+	if (m_file.is_open()) {
+		m_file.close();
+		std::remove(m_path.c_str());
+	}
+}
+
+bool PngWriter::open(const std::string& path, int width, int height) {
+	if (width <= 0 || height <= 0) {
+		return false;
+	}
+	m_path = path;
+	m_file.open(path, std::ios::binary | std::ios::trunc);
+	if (!m_file) {
+		spdlog::error("PNG writer: could not open {} for writing.", path);
+		return false;
+	}
+	m_failed = false;
+	m_width = width;
+	m_height = height;
+	m_rows = 0;
+	m_previous.assign((size_t)width * 4, 0);
+	m_candidates.assign(((size_t)width * 4 + 1) * 5, 0);
+	m_window.assign(RING_SIZE, 0);
+	m_head.assign(HASH_SIZE, -1);
+	m_chain.assign(WINDOW_SIZE, -1);
+	m_position = 0;
+	m_bit_buffer = 0;
+	m_bit_count = 0;
+	m_pending.clear();
+	m_adler_a = 1;
+	m_adler_b = 0;
+
+	static const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	m_file.write((const char*)signature, sizeof(signature));
+	unsigned char header[13];
+	putBigEndian(header, (uint32_t)width);
+	putBigEndian(header + 4, (uint32_t)height);
+	header[8] = 8;  // bits per channel
+	header[9] = 6;  // rgba
+	header[10] = 0;
+	header[11] = 0;
+	header[12] = 0;
+	writeChunk("IHDR", header, sizeof(header));
+
+	// zlib header (deflate, 32k window, no dictionary), then one fixed huffman block that stays open until close()
+	m_pending.push_back(0x78);
+	m_pending.push_back(0x01);
+	putBits(0, 1);
+	putBits(1, 2);
+	return !m_failed;
+}
+
+bool PngWriter::writeRow(const unsigned char* rgba) {
+	if (!m_file.is_open() || m_rows >= m_height) {
+		return false;
+	}
+	filterRow(rgba);
+	std::copy(rgba, rgba + (size_t)m_width * 4, m_previous.begin());
+	++m_rows;
+	flushChunk(false);
+	return !m_failed;
+}
+
+bool PngWriter::close() {
+	if (!m_file.is_open()) {
+		return false;
+	}
+	const bool complete = m_rows == m_height;
+	if (complete) {
+		// end of the open block, an empty final block, then the adler-32 of everything that went in
+		putLiteral(256);
+		putBits(1, 1);
+		putBits(1, 2);
+		putLiteral(256);
+		if (m_bit_count > 0) {
+			putBits(0, 8 - m_bit_count);
+		}
+		unsigned char adler[4];
+		putBigEndian(adler, (m_adler_b << 16) | m_adler_a);
+		m_pending.insert(m_pending.end(), adler, adler + 4);
+		flushChunk(true);
+		writeChunk("IEND", nullptr, 0);
+	}
+	m_file.close();
+	if (!complete || m_failed) {
+		spdlog::error("PNG writer: {} is incomplete ({} of {} rows), removed.", m_path, m_rows, m_height);
+		std::remove(m_path.c_str());
+		return false;
+	}
+	return true;
+}
+
+void PngWriter::filterRow(const unsigned char* rgba) {
+	// the usual heuristic: the filter with the smallest sum of absolute signed bytes compresses best
+	const size_t stride = (size_t)m_width * 4 + 1;
+	const unsigned char* above = m_previous.data();
+	int64_t cost[5] = { 0, 0, 0, 0, 0 };
+	for (int filter = 0; filter < 5; ++filter) {
+		m_candidates[filter * stride] = (unsigned char)filter;
+	}
+	for (size_t i = 0; i < (size_t)m_width * 4; ++i) {
+		const int x = rgba[i];
+		const int a = i >= 4 ? rgba[i - 4] : 0;
+		const int b = above[i];
+		const int c = i >= 4 ? above[i - 4] : 0;
+		const unsigned char filtered[5] = {
+			(unsigned char)x,
+			(unsigned char)(x - a),
+			(unsigned char)(x - b),
+			(unsigned char)(x - ((a + b) >> 1)),
+			(unsigned char)(x - paeth(a, b, c)),
+		};
+		for (int filter = 0; filter < 5; ++filter) {
+			m_candidates[filter * stride + 1 + i] = filtered[filter];
+			cost[filter] += std::abs((int)(signed char)filtered[filter]);
+		}
+	}
+	const int best = (int)(std::min_element(cost, cost + 5) - cost);
+	const unsigned char* row = m_candidates.data() + best * stride;
+	updateAdler(row, stride);
+	deflate(row, stride);
+}
+
+void PngWriter::deflate(const unsigned char* data, size_t size) {
+	// pieces of at most one window, so the ring always still holds the full distance behind the piece
+	while (size > 0) {
+		const size_t piece = std::min(size, (size_t)WINDOW_SIZE);
+		for (size_t i = 0; i < piece; ++i) {
+			m_window[(m_position + (int64_t)i) & (RING_SIZE - 1)] = data[i];
+		}
+		compressPiece(piece);
+		data += piece;
+		size -= piece;
+	}
+}
+
+void PngWriter::compressPiece(size_t size) {
+	const int64_t end = m_position + (int64_t)size;
+	auto insert = [this](int64_t position) {
+		const uint32_t hash = hash3(m_window, position);
+		m_chain[position & (WINDOW_SIZE - 1)] = m_head[hash];
+		m_head[hash] = position;
+	};
+	int64_t position = m_position;
+	while (position < end) {
+		const int64_t available = end - position;
+		int best_length = 0;
+		int best_distance = 0;
+		if (available >= MIN_MATCH) {
+			const int max_length = (int)std::min<int64_t>(available, MAX_MATCH);
+			int64_t candidate = m_head[hash3(m_window, position)];
+			for (int tries = 0; candidate >= 0 && position - candidate <= WINDOW_SIZE && tries < MAX_CHAIN; ++tries) {
+				int length = 0;
+				while (length < max_length &&
+					m_window[(candidate + length) & (RING_SIZE - 1)] == m_window[(position + length) & (RING_SIZE - 1)]) {
+					++length;
+				}
+				if (length > best_length) {
+					best_length = length;
+					best_distance = (int)(position - candidate);
+					if (length == max_length) {
+						break;
+					}
+				}
+				const int64_t next = m_chain[candidate & (WINDOW_SIZE - 1)];
+				if (next >= candidate) {
+					break;
+				}
+				candidate = next;
+			}
+			insert(position);
+		}
+		if (best_length >= MIN_MATCH) {
+			putMatch(best_length, best_distance);
+			for (int64_t skipped = position + 1; skipped < position + best_length; ++skipped) {
+				if (end - skipped >= MIN_MATCH) {
+					insert(skipped);
+				}
+			}
+			position += best_length;
+		}
+		else {
+			putLiteral(m_window[position & (RING_SIZE - 1)]);
+			++position;
+		}
+	}
+	m_position = end;
+}
+
+void PngWriter::putBits(uint32_t bits, int count) {
+	m_bit_buffer |= bits << m_bit_count;
+	m_bit_count += count;
+	while (m_bit_count >= 8) {
+		m_pending.push_back((unsigned char)m_bit_buffer);
+		m_bit_buffer >>= 8;
+		m_bit_count -= 8;
+	}
+}
+
+void PngWriter::putHuffman(uint32_t code, int length) {
+	// huffman codes go most significant bit first, everything else least significant first
+	uint32_t reversed = 0;
+	for (int i = 0; i < length; ++i) {
+		reversed = (reversed << 1) | ((code >> i) & 1);
+	}
+	putBits(reversed, length);
+}
+
+void PngWriter::putLiteral(int symbol) {
+	if (symbol < 144) {
+		putHuffman(0x30 + symbol, 8);
+	}
+	else if (symbol < 256) {
+		putHuffman(0x190 + symbol - 144, 9);
+	}
+	else if (symbol < 280) {
+		putHuffman(symbol - 256, 7);
+	}
+	else {
+		putHuffman(0xC0 + symbol - 280, 8);
+	}
+}
+
+void PngWriter::putMatch(int length, int distance) {
+	int length_code = 28;
+	while (LENGTH_BASE[length_code] > length) {
+		--length_code;
+	}
+	putLiteral(257 + length_code);
+	putBits(length - LENGTH_BASE[length_code], LENGTH_EXTRA[length_code]);
+	int distance_code = 29;
+	while (DISTANCE_BASE[distance_code] > distance) {
+		--distance_code;
+	}
+	putHuffman(distance_code, 5);
+	putBits(distance - DISTANCE_BASE[distance_code], DISTANCE_EXTRA[distance_code]);
+}
+
+void PngWriter::updateAdler(const unsigned char* data, size_t size) {
+	while (size > 0) {
+		// 5552 is the longest run before the sums can overflow 32 bits
+		const size_t run = std::min(size, (size_t)5552);
+		for (size_t i = 0; i < run; ++i) {
+			m_adler_a += data[i];
+			m_adler_b += m_adler_a;
+		}
+		m_adler_a %= 65521;
+		m_adler_b %= 65521;
+		data += run;
+		size -= run;
+	}
+}
+
+void PngWriter::flushChunk(bool force) {
+	if (m_pending.empty() || (!force && m_pending.size() < CHUNK_BYTES)) {
+		return;
+	}
+	writeChunk("IDAT", m_pending.data(), m_pending.size());
+	m_pending.clear();
+}
+
+void PngWriter::writeChunk(const char type[4], const unsigned char* data, size_t size) {
+	unsigned char header[8];
+	putBigEndian(header, (uint32_t)size);
+	std::copy(type, type + 4, header + 4);
+	uint32_t crc = crc32(0, header + 4, 4);
+	if (size > 0) {
+		crc = crc32(crc, data, size);
+	}
+	unsigned char footer[4];
+	putBigEndian(footer, crc);
+	m_file.write((const char*)header, sizeof(header));
+	if (size > 0) {
+		m_file.write((const char*)data, (std::streamsize)size);
+	}
+	m_file.write((const char*)footer, sizeof(footer));
+	if (!m_file) {
+		m_failed = true;
+	}
+}
+
+PngBandEncoder::~PngBandEncoder() {
+	close();
+}
+
+bool PngBandEncoder::open(const std::string& path, int width, int height, int depth) {
+	if (!m_writer.open(path, width, height)) {
+		return false;
+	}
+	m_width = width;
+	m_depth = std::max(1, depth);
+	m_closing = false;
+	m_failed.store(false);
+	m_thread = std::thread(&PngBandEncoder::encodeLoop, this);
+	return true;
+}
+
+std::vector<unsigned char> PngBandEncoder::acquire(int rows) {
+	std::vector<unsigned char> band;
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_changed.wait(lock, [this] { return (int)m_queue.size() < m_depth; });
+		if (!m_free.empty()) {
+			band = std::move(m_free.back());
+			m_free.pop_back();
+		}
+	}
+	band.resize((size_t)rows * m_width * 4);
+	return band;
+}
+
+void PngBandEncoder::submit(std::vector<unsigned char> band) {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_queue.push_back(std::move(band));
+	}
+	m_changed.notify_all();
+}
+
+bool PngBandEncoder::close() {
+	if (!m_thread.joinable()) {
+		return false;
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_closing = true;
+	}
+	m_changed.notify_all();
+	m_thread.join();
+	m_queue.clear();
+	m_free.clear();
+	const bool written = m_writer.close();
+	return written && !m_failed.load();
+}
+
+void PngBandEncoder::encodeLoop() {
+	const size_t stride = (size_t)m_width * 4;
+	for (;;) {
+		std::vector<unsigned char> band;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_changed.wait(lock, [this] { return !m_queue.empty() || m_closing; });
+			if (m_queue.empty()) {
+				return;
+			}
+			band = std::move(m_queue.front());
+			m_queue.pop_front();
+		}
+		m_changed.notify_all();
+		// a failed file keeps taking bands so the producer never blocks on it
+		const int rows = (int)(band.size() / stride);
+		for (int row = rows - 1; row >= 0 && !m_failed.load(); --row) {
+			if (!m_writer.writeRow(band.data() + (size_t)row * stride)) {
+				m_failed.store(true);
+			}
+		}
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_free.push_back(std::move(band));
+	}
+}
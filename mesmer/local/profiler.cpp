@@ -0,0 +1,246 @@
+/*
+	Mesmer - An interactive and high-performance fractal generator and explorer.
+	Made by -> Titan // GH: https://github.com/titan3755/mesmer
+	[profiler.cpp]
+*/
+
+#include <profiler.hpp>
+
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+#include <glad/glad.h>
+#include <imgui.h>
+
+namespace {
+
+	float millisecondsSince(std::chrono::steady_clock::time_point start) {
+		return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	float percentile(std::vector<float>& sorted_samples, float fraction) {
+		if (sorted_samples.empty()) {
+			return 0.0f;
+		}
+		const size_t index = std::min(sorted_samples.size() - 1, (size_t)(fraction * (float)sorted_samples.size()));
+		return sorted_samples[index];
+	}
+
+}
+
+void Profiler::History::push(float value) {
+	samples[next] = value;
+	next = (next + 1) % PROFILER_HISTORY;
+	count = std::min(count + 1, PROFILER_HISTORY);
+}
+
+float Profiler::History::last() const {
+	return count > 0 ? samples[(next + PROFILER_HISTORY - 1) % PROFILER_HISTORY] : 0.0f;
+}
+
+Profiler::Percentiles Profiler::History::percentiles() const {
+	std::vector<float> values(samples.begin(), samples.begin() + count);
+	std::sort(values.begin(), values.end());
+	return { percentile(values, 0.50f), percentile(values, 0.95f), percentile(values, 0.99f) };
+}
+
+void Profiler::beginFrame() {
+	if (m_requested != m_enabled) {
+		m_enabled = m_requested;
+		// results from before a pause say nothing about the frames after it
+		for (FrameQueries& frame : m_frames) {
+			frame.pending = false;
+			frame.issued.fill(false);
+		}
+	}
+	if (!m_enabled) {
+		m_frame_open = false;
+		return;
+	}
+	if (m_frames[0].ids[0] == 0) {
+		for (FrameQueries& frame : m_frames) {
+			glGenQueries((GLsizei)frame.ids.size(), frame.ids.data());
+		}
+	}
+	// the slot comes back around after QUERY_FRAMES frames, whatever it measured then is read now
+	m_frame_slot = (m_frame_slot + 1) % QUERY_FRAMES;
+	collect(m_frames[m_frame_slot]);
+	m_frame_start = Clock::now();
+	m_frame_open = true;
+}
+
+void Profiler::endFrame() {
+	if (!m_frame_open) {
+		return;
+	}
+	m_frame_ms.push(millisecondsSince(m_frame_start));
+	m_frame_open = false;
+}
+
+int Profiler::beginPass(const char* name, bool gpu) {
+	if (!m_frame_open) {
+		return -1;
+	}
+	int pass = 0;
+	while (pass < m_pass_count && std::strcmp(m_passes[pass].name, name) != 0) {
+		++pass;
+	}
+	if (pass == m_pass_count) {
+		if (m_pass_count == PROFILER_MAX_PASSES) {
+			return -1;
+		}
+		m_passes[pass].name = name;
+		++m_pass_count;
+	}
+	Pass& entry = m_passes[pass];
+	entry.gpu = gpu;
+	entry.cpu_start = Clock::now();
+	if (gpu) {
+		FrameQueries& frame = m_frames[m_frame_slot];
+		glQueryCounter(frame.ids[pass * 2], GL_TIMESTAMP);
+	}
+	return pass;
+}
+
+void Profiler::endPass(int pass) {
+	if (pass < 0 || !m_frame_open) {
+		return;
+	}
+	Pass& entry = m_passes[pass];
+	entry.cpu_ms.push(millisecondsSince(entry.cpu_start));
+	if (entry.gpu) {
+		FrameQueries& frame = m_frames[m_frame_slot];
+		glQueryCounter(frame.ids[pass * 2 + 1], GL_TIMESTAMP);
+		frame.issued[pass] = true;
+		frame.pending = true;
+	}
+}
+
+void Profiler::collect(FrameQueries& frame) {
+	if (!frame.pending) {
+		return;
+	}
+	for (int pass = 0; pass < m_pass_count; ++pass) {
+		if (!frame.issued[pass]) {
+			continue;
+		}
+		frame.issued[pass] = false;
+		GLint available = 0;
+		glGetQueryObjectiv(frame.ids[pass * 2 + 1], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available) {
+			continue;
+		}
+		GLuint64 begin = 0;
+		GLuint64 end = 0;
+		glGetQueryObjectui64v(frame.ids[pass * 2], GL_QUERY_RESULT, &begin);
+		glGetQueryObjectui64v(frame.ids[pass * 2 + 1], GL_QUERY_RESULT, &end);
+		m_passes[pass].gpu_ms.push(end > begin ? (float)((double)(end - begin) / 1.0e6) : 0.0f);
+	}
+	frame.pending = false;
+}
+
+void Profiler::recordTile(bool gpu, float milliseconds) {
+	std::lock_guard<std::mutex> lock(m_tile_mutex);
+	(gpu ? m_gpu_tiles : m_cpu_tiles).push_back(milliseconds);
+}
+
+void Profiler::clearTiles() {
+	std::lock_guard<std::mutex> lock(m_tile_mutex);
+	m_gpu_tiles.clear();
+	m_cpu_tiles.clear();
+}
+
+Profiler::Percentiles Profiler::tilePercentiles(std::vector<float> samples) {
+	std::sort(samples.begin(), samples.end());
+	return { percentile(samples, 0.50f), percentile(samples, 0.95f), percentile(samples, 0.99f) };
+}
+
+void Profiler::drawOverlay(bool* open) {
+	ImGui::SetNextWindowBgAlpha(0.85f);
+	if (!ImGui::Begin("Profiler", open, ImGuiWindowFlags_AlwaysAutoResize)) {
+		ImGui::End();
+		return;
+	}
+	const Percentiles frame = m_frame_ms.percentiles();
+	ImGui::Text("Frame (cpu): %.2f ms   p50 %.2f   p95 %.2f   p99 %.2f", m_frame_ms.last(), frame.p50, frame.p95, frame.p99);
+	ImGui::PlotLines("##frame", m_frame_ms.samples.data(), m_frame_ms.count, m_frame_ms.count == PROFILER_HISTORY ? m_frame_ms.next : 0,
+		nullptr, 0.0f, std::max(frame.p99 * 1.25f, 1.0f), ImVec2(360.0f, 50.0f));
+
+	ImGui::Separator();
+	ImGui::TextDisabled("percentiles are of the gpu time for gpu passes, of the cpu time otherwise");
+	if (ImGui::BeginTable("passes", 6, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit)) {
+		ImGui::TableSetupColumn("Pass");
+		ImGui::TableSetupColumn("CPU ms");
+		ImGui::TableSetupColumn("GPU ms");
+		ImGui::TableSetupColumn("p50");
+		ImGui::TableSetupColumn("p95");
+		ImGui::TableSetupColumn("p99");
+		ImGui::TableHeadersRow();
+		for (int pass = 0; pass < m_pass_count; ++pass) {
+			const Pass& entry = m_passes[pass];
+			const Percentiles spread = (entry.gpu ? entry.gpu_ms : entry.cpu_ms).percentiles();
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn();
+			ImGui::TextUnformatted(entry.name);
+			ImGui::TableNextColumn();
+			ImGui::Text("%.3f", entry.cpu_ms.last());
+			ImGui::TableNextColumn();
+			if (entry.gpu) {
+				ImGui::Text("%.3f", entry.gpu_ms.last());
+			}
+			else {
+				ImGui::TextDisabled("-");
+			}
+			ImGui::TableNextColumn();
+			ImGui::Text("%.3f", spread.p50);
+			ImGui::TableNextColumn();
+			ImGui::Text("%.3f", spread.p95);
+			ImGui::TableNextColumn();
+			ImGui::Text("%.3f", spread.p99);
+		}
+		ImGui::EndTable();
+	}
+	for (int pass = 0; pass < m_pass_count; ++pass) {
+		const Pass& entry = m_passes[pass];
+		const History& history = entry.gpu ? entry.gpu_ms : entry.cpu_ms;
+		ImGui::PlotLines(entry.name, history.samples.data(), history.count, history.count == PROFILER_HISTORY ? history.next : 0,
+			entry.gpu ? "gpu" : "cpu", 0.0f, std::max(history.percentiles().p99 * 1.25f, 0.1f), ImVec2(360.0f, 32.0f));
+	}
+
+	std::vector<float> gpu_tiles;
+	std::vector<float> cpu_tiles;
+	{
+		std::lock_guard<std::mutex> lock(m_tile_mutex);
+		gpu_tiles = m_gpu_tiles;
+		cpu_tiles = m_cpu_tiles;
+	}
+	if (!gpu_tiles.empty() || !cpu_tiles.empty()) {
+		ImGui::Separator();
+		ImGui::Text("Pre-render tiles");
+		if (!gpu_tiles.empty()) {
+			const Percentiles spread = tilePercentiles(gpu_tiles);
+			ImGui::Text("GPU: %d tiles   p50 %.2f   p95 %.2f   p99 %.2f   max %.2f ms", (int)gpu_tiles.size(), spread.p50, spread.p95, spread.p99,
+				*std::max_element(gpu_tiles.begin(), gpu_tiles.end()));
+			ImGui::PlotHistogram("##gpu_tiles", gpu_tiles.data(), (int)gpu_tiles.size(), 0, "gpu tiles in completion order", 0.0f, FLT_MAX, ImVec2(360.0f, 40.0f));
+		}
+		if (!cpu_tiles.empty()) {
+			const Percentiles spread = tilePercentiles(cpu_tiles);
+			ImGui::Text("CPU: %d tiles   p50 %.2f   p95 %.2f   p99 %.2f   max %.2f ms", (int)cpu_tiles.size(), spread.p50, spread.p95, spread.p99,
+				*std::max_element(cpu_tiles.begin(), cpu_tiles.end()));
+			ImGui::PlotHistogram("##cpu_tiles", cpu_tiles.data(), (int)cpu_tiles.size(), 0, "cpu tiles in completion order", 0.0f, FLT_MAX, ImVec2(360.0f, 40.0f));
+		}
+	}
+	ImGui::End();
+}
+
+void Profiler::release() {
+	if (m_frames[0].ids[0] != 0) {
+		for (FrameQueries& frame : m_frames) {
+			glDeleteQueries((GLsizei)frame.ids.size(), frame.ids.data());
+			frame.ids.fill(0);
+			frame.pending = false;
+			frame.issued.fill(false);
+		}
+	}
+	m_frame_open = false;
+}
@@ -0,0 +1,436 @@
+/*
+	Mesmer - An interactive and high-performance fractal generator and explorer.
+	Made by -> Titan // GH: https://github.com/titan3755/mesmer
+	[progressive_renderer.cpp]
+*/
+
+#include <progressive_renderer.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <spdlog/spdlog.h>
+#include <glad/glad.h>
+
+namespace {
+
+	// a full resolution pass that fits in this many frame budgets is refined straight away instead of level by level
+	constexpr float DIRECT_REFINE_FRAMES = 4.0f;
+	// zoom factors closer to 1 than this are treated as a pure pan
+	constexpr double SHIFT_SCALE_TOLERANCE = 1.0e-9;
+	// leftover pixel fractions below this are rounding noise, not worth a refinement
+	constexpr double SHIFT_RESIDUAL_TOLERANCE = 1.0e-3;
+	// a zoom preview is only kept while the old image is at most 4x magnified and still covers most of the view
+	constexpr double RESAMPLE_MIN_SCALE = 0.25;
+	constexpr double RESAMPLE_MIN_COVERAGE = 0.75;
+
+}
+
+bool ProgressiveRenderer::beginPass(int width, int height) {
+	if (width <= 0 || height <= 0) {
+		return false;
+	}
+	if (width != m_width || height != m_height || m_textures[0] == 0) {
+		allocate(width, height);
+		m_restart = true;
+	}
+	collectTimings();
+	if (!m_enabled) {
+		m_restart = true;
+	}
+
+	if (m_restart) {
+		// the interactive pass always finishes its level in one go, the previous view is never shown again
+		m_restart = false;
+		m_complete = false;
+		m_full_pass = false;
+		m_resuming = false;
+		m_patches.clear();
+		m_residual_x = 0.0;
+		m_residual_y = 0.0;
+		m_level = m_enabled ? interactiveScale() : 1;
+		m_rows_done = 0;
+		m_pass_rows = levelHeight(m_level);
+	}
+	else if (!m_patches.empty()) {
+		beginPatchPass();
+		return true;
+	}
+	else {
+		if (m_complete) {
+			if (m_residual_x == 0.0 && m_residual_y == 0.0) {
+				return false;
+			}
+			// the view came to rest on pixels a pan left off the grid by a fraction, they are refined in place
+			m_complete = false;
+			m_full_pass = false;
+			m_level = 1;
+			m_rows_done = 0;
+			m_residual_x = 0.0;
+			m_residual_y = 0.0;
+		}
+		const int remaining = levelHeight(m_level) - m_rows_done;
+		int rows = PROGRESSIVE_MIN_STRIP_ROWS;
+		if (m_ns_per_pixel > 0.0) {
+			rows = std::max(rows, (int)(m_budget_ms * 1.0e6 / (m_ns_per_pixel * levelWidth(m_level))));
+		}
+		m_pass_rows = std::min(rows, remaining);
+	}
+
+	// a resumed pass draws over the finished image, the pixels it leaves alone stay as they are
+	glBindFramebuffer(GL_FRAMEBUFFER, m_fbos[m_resuming ? 0 : 1]);
+	glViewport(0, 0, levelWidth(m_level), levelHeight(m_level));
+	glEnable(GL_SCISSOR_TEST);
+	glScissor(0, m_rows_done, levelWidth(m_level), m_pass_rows);
+	m_pass_pixels = (int64_t)levelWidth(m_level) * m_pass_rows;
+
+	if (m_queries[0] == 0) {
+		glGenQueries(QUERY_COUNT, m_queries.data());
+	}
+	// a slot still waiting on the gpu means the ring is full, this pass just goes untimed
+	m_pass_query = -1;
+	if (!m_query_pending[m_query_next]) {
+		m_pass_query = m_query_next;
+		glBeginQuery(GL_TIME_ELAPSED, m_queries[m_pass_query]);
+	}
+	return true;
+}
+
+void ProgressiveRenderer::endPass() {
+	if (m_pass_query >= 0) {
+		glEndQuery(GL_TIME_ELAPSED);
+		m_query_pixels[m_pass_query] = m_pass_pixels;
+		m_query_pending[m_pass_query] = true;
+		m_query_next = (m_query_next + 1) % QUERY_COUNT;
+		m_pass_query = -1;
+	}
+	glDisable(GL_SCISSOR_TEST);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	if (m_patch_pass) {
+		glDisable(GL_STENCIL_TEST);
+		m_patch_pass = false;
+		m_patches.clear();
+		return;
+	}
+	m_rows_done += m_pass_rows;
+	if (m_rows_done < levelHeight(m_level)) {
+		return;
+	}
+	if (m_resuming) {
+		m_resuming = false;
+		m_rows_done = 0;
+		m_complete = true;
+		return;
+	}
+	std::swap(m_textures[0], m_textures[1]);
+	std::swap(m_fbos[0], m_fbos[1]);
+	m_finished_level = m_level;
+	m_rows_done = 0;
+	if (m_level == 1) {
+		m_complete = true;
+		m_full_pass = true;
+		return;
+	}
+	const double full_ms = fullFrameMs();
+	m_level = full_ms > 0.0 && full_ms <= m_budget_ms * DIRECT_REFINE_FRAMES ? 1 : m_level / 2;
+}
+
+bool ProgressiveRenderer::resume() {
+	if (!resumable()) {
+		return false;
+	}
+	m_resuming = true;
+	m_complete = false;
+	m_level = 1;
+	m_rows_done = 0;
+	return true;
+}
+
+bool ProgressiveRenderer::reproject(double scale, double offset_x, double offset_y) {
+	// a half resumed image mixes two limits, it is drawn again
+	if (!m_enabled || m_restart || m_resuming || m_finished_level == 0 || !(scale > 0.0)) {
+		return false;
+	}
+	m_full_pass = false;
+	if (std::abs(scale - 1.0) < SHIFT_SCALE_TOLERANCE) {
+		return shift(offset_x, offset_y);
+	}
+	return resample(scale, offset_x, offset_y);
+}
+
+void ProgressiveRenderer::present(int width, int height) const {
+	if (m_finished_level == 0) {
+		return;
+	}
+	presentLevel(0, m_finished_level, levelHeight(m_finished_level), width, height);
+	if (!m_complete && !m_resuming && m_rows_done > 0) {
+		const int screen_rows = (int)((int64_t)m_rows_done * height / levelHeight(m_level));
+		presentLevel(1, m_level, m_rows_done, width, screen_rows);
+	}
+}
+
+void ProgressiveRenderer::presentLevel(int target, int level, int source_rows, int width, int screen_rows) const {
+	if (level == 1 || m_upscaler == nullptr || m_upscaler->ID == 0) {
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, m_fbos[target]);
+		glBlitFramebuffer(0, 0, levelWidth(level), source_rows, 0, 0, width, screen_rows,
+			GL_COLOR_BUFFER_BIT, level == 1 ? GL_NEAREST : GL_LINEAR);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+		return;
+	}
+	// the quad always maps the whole level onto the screen, the scissor keeps a partial level to its refined rows
+	glEnable(GL_SCISSOR_TEST);
+	glScissor(0, 0, width, screen_rows);
+	m_upscaler->use();
+	m_upscaler->setInt("u_source", 0);
+	m_upscaler->setVec2("u_source_size", (float)levelWidth(level), (float)levelHeight(level));
+	m_upscaler->setIVec2("u_source_valid", levelWidth(level), source_rows);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, m_textures[target]);
+	glBindVertexArray(m_upscaler_vao);
+	glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+	glDisable(GL_SCISSOR_TEST);
+}
+
+void ProgressiveRenderer::beginPatchPass() {
+	glBindFramebuffer(GL_FRAMEBUFFER, m_fbos[0]);
+	glViewport(0, 0, m_width, m_height);
+	// only the exposed bands pass the stencil test, the early test keeps the kernel off the retained pixels
+	const GLint outside = 0;
+	const GLint inside = 1;
+	glClearBufferiv(GL_STENCIL, 0, &outside);
+	glEnable(GL_SCISSOR_TEST);
+	int x0 = m_width, y0 = m_height, x1 = 0, y1 = 0;
+	m_pass_pixels = 0;
+	for (const PixelRect& patch : m_patches) {
+		glScissor(patch.x, patch.y, patch.width, patch.height);
+		glClearBufferiv(GL_STENCIL, 0, &inside);
+		x0 = std::min(x0, patch.x);
+		y0 = std::min(y0, patch.y);
+		x1 = std::max(x1, patch.x + patch.width);
+		y1 = std::max(y1, patch.y + patch.height);
+		m_pass_pixels += (int64_t)patch.width * patch.height;
+	}
+	glScissor(x0, y0, x1 - x0, y1 - y0);
+	glEnable(GL_STENCIL_TEST);
+	glStencilFunc(GL_EQUAL, 1, 0xFF);
+	glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+	m_patch_pass = true;
+
+	if (m_queries[0] == 0) {
+		glGenQueries(QUERY_COUNT, m_queries.data());
+	}
+	m_pass_query = -1;
+	if (!m_query_pending[m_query_next]) {
+		m_pass_query = m_query_next;
+		glBeginQuery(GL_TIME_ELAPSED, m_queries[m_pass_query]);
+	}
+}
+
+bool ProgressiveRenderer::shift(double offset_x, double offset_y) {
+	// the refined image moves by whole pixels, the fraction left over is carried so it never drifts more than half a pixel
+	if (m_finished_level != 1 || !m_patches.empty()) {
+		return false;
+	}
+	const int shift_x = (int)std::lround(offset_x - m_residual_x);
+	const int shift_y = (int)std::lround(offset_y - m_residual_y);
+	if (std::abs(shift_x) >= m_width || std::abs(shift_y) >= m_height) {
+		return false;
+	}
+	const int band_x = std::abs(shift_x);
+	const int band_y = std::abs(shift_y);
+	const int64_t exposed = (int64_t)band_x * m_height + (int64_t)band_y * (m_width - band_x);
+	const double exposed_ms = m_ns_per_pixel * (double)exposed / 1.0e6;
+	if (m_ns_per_pixel > 0.0 ? exposed_ms > m_budget_ms * DIRECT_REFINE_FRAMES : exposed * 4 > (int64_t)m_width * m_height) {
+		return false;
+	}
+	m_residual_x += shift_x - offset_x;
+	m_residual_y += shift_y - offset_y;
+	if (std::abs(m_residual_x) < SHIFT_RESIDUAL_TOLERANCE) {
+		m_residual_x = 0.0;
+	}
+	if (std::abs(m_residual_y) < SHIFT_RESIDUAL_TOLERANCE) {
+		m_residual_y = 0.0;
+	}
+	if (shift_x == 0 && shift_y == 0) {
+		return true;
+	}
+
+	// new pixel p is old pixel p + shift, blits may not overlap inside one target so it goes through the other one
+	const int dst_x0 = std::max(0, -shift_x);
+	const int dst_y0 = std::max(0, -shift_y);
+	const int dst_x1 = std::min(m_width, m_width - shift_x);
+	const int dst_y1 = std::min(m_height, m_height - shift_y);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, m_fbos[0]);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_fbos[1]);
+	glBlitFramebuffer(dst_x0 + shift_x, dst_y0 + shift_y, dst_x1 + shift_x, dst_y1 + shift_y, dst_x0, dst_y0, dst_x1, dst_y1,
+		GL_COLOR_BUFFER_BIT, GL_NEAREST);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	std::swap(m_textures[0], m_textures[1]);
+	std::swap(m_fbos[0], m_fbos[1]);
+
+	if (band_x > 0) {
+		m_patches.push_back({ shift_x > 0 ? m_width - band_x : 0, 0, band_x, m_height });
+	}
+	if (band_y > 0) {
+		m_patches.push_back({ dst_x0, shift_y > 0 ? m_height - band_y : 0, dst_x1 - dst_x0, band_y });
+	}
+	// strips refined so far lived in the target the shift just overwrote
+	m_rows_done = 0;
+	return true;
+}
+
+bool ProgressiveRenderer::resample(double scale, double offset_x, double offset_y) {
+	// the part of the new view the old image still covers, further out the preview would be mostly empty
+	const double x0 = std::clamp(-offset_x / scale, 0.0, (double)m_width);
+	const double x1 = std::clamp((m_width - offset_x) / scale, 0.0, (double)m_width);
+	const double y0 = std::clamp(-offset_y / scale, 0.0, (double)m_height);
+	const double y1 = std::clamp((m_height - offset_y) / scale, 0.0, (double)m_height);
+	const double coverage = (x1 - x0) * (y1 - y0) / ((double)m_width * m_height);
+	if (scale < RESAMPLE_MIN_SCALE || coverage < RESAMPLE_MIN_COVERAGE || !m_patches.empty()) {
+		return false;
+	}
+
+	const int dst_x0 = (int)std::lround(x0);
+	const int dst_y0 = (int)std::lround(y0);
+	const int dst_x1 = (int)std::lround(x1);
+	const int dst_y1 = (int)std::lround(y1);
+	// a coarse finished level only fills the corner of its target
+	const double level_x = (double)levelWidth(m_finished_level) / m_width;
+	const double level_y = (double)levelHeight(m_finished_level) / m_height;
+	const GLfloat black[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, m_fbos[0]);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_fbos[1]);
+	glClearBufferfv(GL_COLOR, 0, black);
+	glBlitFramebuffer(
+		(int)std::lround((dst_x0 * scale + offset_x) * level_x), (int)std::lround((dst_y0 * scale + offset_y) * level_y),
+		(int)std::lround((dst_x1 * scale + offset_x) * level_x), (int)std::lround((dst_y1 * scale + offset_y) * level_y),
+		dst_x0, dst_y0, dst_x1, dst_y1, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	std::swap(m_textures[0], m_textures[1]);
+	std::swap(m_fbos[0], m_fbos[1]);
+
+	// the preview stands in for a finished full resolution level until the strips replace it
+	m_finished_level = 1;
+	m_complete = false;
+	m_level = 1;
+	m_rows_done = 0;
+	m_residual_x = 0.0;
+	m_residual_y = 0.0;
+	return true;
+}
+
+void ProgressiveRenderer::release() {
+	if (m_stencil != 0) {
+		glDeleteRenderbuffers(1, &m_stencil);
+		m_stencil = 0;
+	}
+	for (int i = 0; i < 2; ++i) {
+		if (m_fbos[i] != 0) {
+			glDeleteFramebuffers(1, &m_fbos[i]);
+		}
+		if (m_textures[i] != 0) {
+			glDeleteTextures(1, &m_textures[i]);
+		}
+		m_fbos[i] = 0;
+		m_textures[i] = 0;
+	}
+	if (m_queries[0] != 0) {
+		glDeleteQueries(QUERY_COUNT, m_queries.data());
+	}
+	m_queries.fill(0);
+	m_query_pending.fill(false);
+	m_query_next = 0;
+	m_width = 0;
+	m_height = 0;
+	m_finished_level = 0;
+	m_restart = true;
+	m_complete = false;
+	m_full_pass = false;
+	m_resuming = false;
+	m_patches.clear();
+}
+
+float ProgressiveRenderer::progress() const {
+	if (m_complete) {
+		return 1.0f;
+	}
+	return m_height > 0 ? (float)m_rows_done / (float)levelHeight(m_level) : 0.0f;
+}
+
+double ProgressiveRenderer::fullFrameMs() const {
+	return m_ns_per_pixel * (double)m_width * (double)m_height / 1.0e6;
+}
+
+void ProgressiveRenderer::allocate(int width, int height) {
+	for (int i = 0; i < 2; ++i) {
+		if (m_fbos[i] != 0) {
+			glDeleteFramebuffers(1, &m_fbos[i]);
+		}
+		if (m_textures[i] != 0) {
+			glDeleteTextures(1, &m_textures[i]);
+		}
+	}
+	if (m_stencil != 0) {
+		glDeleteRenderbuffers(1, &m_stencil);
+	}
+	m_width = width;
+	m_height = height;
+	m_finished_level = 0;
+	m_patches.clear();
+	glGenRenderbuffers(1, &m_stencil);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_stencil);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_STENCIL_INDEX8, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+	glGenTextures(2, m_textures);
+	glGenFramebuffers(2, m_fbos);
+	for (int i = 0; i < 2; ++i) {
+		glBindTexture(GL_TEXTURE_2D, m_textures[i]);
+		glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, width, height);
+		glBindFramebuffer(GL_FRAMEBUFFER, m_fbos[i]);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_textures[i], 0);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_stencil);
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+			spdlog::error("Progressive render framebuffer {} is not complete!", i);
+		}
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	spdlog::info("Progressive render targets allocated: {}x{}", width, height);
+}
+
+void ProgressiveRenderer::collectTimings() {
+	for (int i = 0; i < QUERY_COUNT; ++i) {
+		if (!m_query_pending[i]) {
+			continue;
+		}
+		GLint available = 0;
+		glGetQueryObjectiv(m_queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available) {
+			continue;
+		}
+		GLuint64 elapsed = 0;
+		glGetQueryObjectui64v(m_queries[i], GL_QUERY_RESULT, &elapsed);
+		m_query_pending[i] = false;
+		if (m_query_pixels[i] <= 0) {
+			continue;
+		}
+		// strips differ a lot in cost (interior rows run every iteration), so the estimate only moves halfway per sample
+		const double sample = (double)elapsed / (double)m_query_pixels[i];
+		m_ns_per_pixel = m_ns_per_pixel > 0.0 ? 0.5 * (m_ns_per_pixel + sample) : sample;
+	}
+}
+
+int ProgressiveRenderer::interactiveScale() const {
+	if (m_ns_per_pixel <= 0.0) {
+		return PROGRESSIVE_MAX_SCALE;
+	}
+	const double budget_ns = m_budget_ms * 1.0e6;
+	// every whole divisor is a candidate, powers of two alone leave up to 4x the pixels on the table
+	for (int scale = 1; scale < PROGRESSIVE_MAX_SCALE; ++scale) {
+		if (m_ns_per_pixel * levelWidth(scale) * levelHeight(scale) <= budget_ns) {
+			return scale;
+		}
+	}
+	return PROGRESSIVE_MAX_SCALE;
+}
@@ -0,0 +1,98 @@
+/*
+	Mesmer - An interactive and high-performance fractal generator and explorer.
+	Made by -> Titan // GH: https://github.com/titan3755/mesmer
+	[readback_ring.cpp]
+*/
+
+#include <readback_ring.hpp>
+
+#include <spdlog/spdlog.h>
+
+bool ReadbackRing::create(int slot_count, int width, int height) {
+	release();
+	m_width = width;
+	m_height = height;
+	m_slots.resize(slot_count);
+	const GLsizeiptr bytes = (GLsizeiptr)width * height * 4;
+	bool created = true;
+	for (Slot& slot : m_slots) {
+		glGenBuffers(1, &slot.buffer);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+		// read once by the cpu per fill, the driver keeps these in host visible memory
+		glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+		created = created && slot.buffer != 0;
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	m_next = 0;
+	m_pending = 0;
+	return created;
+}
+
+void ReadbackRing::release() {
+	for (Slot& slot : m_slots) {
+		if (slot.fence) {
+			glDeleteSync(slot.fence);
+		}
+		if (slot.buffer) {
+			glDeleteBuffers(1, &slot.buffer);
+		}
+	}
+	m_slots.clear();
+	m_next = 0;
+	m_pending = 0;
+}
+
+void ReadbackRing::read(int x, int y, int width, int height, int tag) {
+	if (full()) {
+		spdlog::error("Readback ring: read queued without a free slot.");
+		return;
+	}
+	if (width > m_width || height > m_height) {
+		spdlog::error("Readback ring: {}x{} read does not fit the {}x{} slots.", width, height, m_width, m_height);
+		return;
+	}
+	Slot& slot = m_slots[m_next];
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	glPixelStorei(GL_PACK_ROW_LENGTH, 0);
+	// with a pack buffer bound this only records the copy, the call returns before the gpu has even drawn the tile
+	glReadPixels(x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	slot.tag = tag;
+	slot.width = width;
+	slot.height = height;
+	m_next = (m_next + 1) % (int)m_slots.size();
+	++m_pending;
+}
+
+bool ReadbackRing::retire(const std::function<void(int tag, const unsigned char* pixels)>& consume, const std::atomic<bool>* cancel) {
+	if (empty()) {
+		return false;
+	}
+	const int count = (int)m_slots.size();
+	Slot& slot = m_slots[(m_next - m_pending + count) % count];
+	// slices keep the wait cancellable, the flush bit makes sure the fence was ever submitted
+	GLenum wait_result;
+	do {
+		if (cancel && cancel->load()) {
+			return false;
+		}
+		wait_result = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 5'000'000);
+	} while (wait_result == GL_TIMEOUT_EXPIRED);
+	glDeleteSync(slot.fence);
+	slot.fence = nullptr;
+	--m_pending;
+	if (wait_result == GL_WAIT_FAILED) {
+		spdlog::error("Readback ring: fence wait failed.");
+		return false;
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+	const void* pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)slot.width * slot.height * 4, GL_MAP_READ_BIT);
+	if (pixels) {
+		consume(slot.tag, (const unsigned char*)pixels);
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	return pixels != nullptr;
+}
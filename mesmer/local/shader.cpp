@@ -6,7 +6,129 @@
 
 #include <shader.hpp>
 
-Shader::Shader(const char* vertexPath, const char* fragmentPath) {
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <thread>
+
+namespace {
+
+    constexpr const char* PROGRAM_CACHE_DIRECTORY = "shader_cache";
+    constexpr uint32_t PROGRAM_CACHE_MAGIC = 0x4250534D; // "MSPB"
+    constexpr uint32_t PROGRAM_CACHE_VERSION = 1;
+
+    struct ProgramCacheHeader {
+        uint32_t magic = PROGRAM_CACHE_MAGIC;
+        uint32_t version = PROGRAM_CACHE_VERSION;
+        uint64_t key = 0;
+        uint32_t format = 0;
+        uint32_t length = 0;
+    };
+
+    uint64_t fnv1a(uint64_t hash, std::string_view data) {
+        for (const char ch : data) {
+            hash ^= (unsigned char)ch;
+            hash *= 0x100000001B3ull;
+        }
+        return hash;
+    }
+
+    std::string_view glString(GLenum name) {
+        const GLubyte* value = glGetString(name);
+        return value ? std::string_view((const char*)value) : std::string_view();
+    }
+
+    // binaries only load on the driver that produced them, so the driver strings are part of the key
+    uint64_t programCacheKey(const std::string& vertex_code, const std::string& fragment_code) {
+        uint64_t hash = 0xCBF29CE484222325ull;
+        for (const GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+            hash = fnv1a(hash, glString(name));
+            hash = fnv1a(hash, std::string_view("\n", 1));
+        }
+        hash = fnv1a(hash, vertex_code);
+        hash = fnv1a(hash, std::string_view("\0", 1));
+        return fnv1a(hash, fragment_code);
+    }
+
+    std::filesystem::path programCachePath(uint64_t key) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+        return std::filesystem::path(PROGRAM_CACHE_DIRECTORY) / name;
+    }
+
+    bool programBinariesSupported() {
+        GLint formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        return formats > 0;
+    }
+
+    // bytes of one element of an active uniform, samplers and anything unlisted get room for the largest (dmat4)
+    size_t uniformTypeBytes(GLenum type) {
+        switch (type) {
+        case GL_FLOAT: case GL_INT: case GL_UNSIGNED_INT: case GL_BOOL:
+            return 4;
+        case GL_FLOAT_VEC2: case GL_INT_VEC2: case GL_DOUBLE:
+            return 8;
+        case GL_FLOAT_VEC3: case GL_INT_VEC3:
+            return 12;
+        case GL_FLOAT_VEC4: case GL_INT_VEC4: case GL_DOUBLE_VEC2: case GL_FLOAT_MAT2:
+            return 16;
+        case GL_DOUBLE_VEC3:
+            return 24;
+        case GL_DOUBLE_VEC4:
+            return 32;
+        case GL_FLOAT_MAT3:
+            return 36;
+        case GL_FLOAT_MAT4:
+            return 64;
+        default:
+            return 128;
+        }
+    }
+
+    // expands #include "file" lines (relative to the including shader) so kernels can share glsl libraries like df64.glsl
+    std::string resolveIncludes(const std::string& source, const std::string& path, int depth = 0) {
+        if (depth > 8) {
+            spdlog::error("Shader include depth exceeded in {}", path);
+            return source;
+        }
+        const size_t slash = path.find_last_of("/\\");
+        const std::string directory = slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+        std::istringstream input(source);
+        std::string result;
+        std::string line;
+        while (std::getline(input, line)) {
+            const size_t directive = line.find_first_not_of(" \t");
+            if (directive != std::string::npos && line.compare(directive, 8, "#include") == 0) {
+                const size_t open = line.find('"', directive);
+                const size_t close = open == std::string::npos ? std::string::npos : line.find('"', open + 1);
+                if (close != std::string::npos) {
+                    const std::string include_path = directory + line.substr(open + 1, close - open - 1);
+                    std::ifstream include_file(include_path);
+                    if (!include_file) {
+                        spdlog::error("Fatal error reading shader include {}", include_path);
+                        continue;
+                    }
+                    std::stringstream include_stream;
+                    include_stream << include_file.rdbuf();
+                    result += resolveIncludes(include_stream.str(), include_path, depth + 1);
+                    result += "\n";
+                    continue;
+                }
+            }
+            result += line;
+            result += "\n";
+        }
+        return result;
+    }
+
+}
+
+Shader::Shader(const char* vertexPath, const char* fragmentPath) : Shader(vertexPath, fragmentPath, false) {
+}
+
+Shader::Shader(const char* vertexPath, const char* fragmentPath, bool deferLink) {
     std::string vertexCode;
     std::string fragmentCode;
     std::ifstream vShaderFile;
@@ -23,101 +145,394 @@ Shader::Shader(const char* vertexPath, const char* fragmentPath) {
         vShaderFile.close();
         fShaderFile.close();
         vertexCode = vShaderStream.str();
-        fragmentCode = fShaderStream.str();
+        fragmentCode = resolveIncludes(fShaderStream.str(), fragmentPath);
     }
     catch (std::ifstream::failure& e) {
 		spdlog::error("Fatal error reading shader files");
         std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << e.what() << std::endl;
     }
+    const bool cache_program = !vertexCode.empty() && !fragmentCode.empty() && programBinariesSupported();
+    const uint64_t cache_key = cache_program ? programCacheKey(vertexCode, fragmentCode) : 0;
+    if (cache_program && loadProgramBinary(cache_key)) {
+        reflectUniforms();
+        return;
+    }
+
     const char* vShaderCode = vertexCode.c_str();
     const char* fShaderCode = fragmentCode.c_str();
 
     unsigned int vertex, fragment;
 
+    // status queries wait for the compiler, so a deferred build leaves every check to finishLink
     vertex = glCreateShader(GL_VERTEX_SHADER);
     glShaderSource(vertex, 1, &vShaderCode, NULL);
     glCompileShader(vertex);
-    checkCompileErrors(vertex, "VERTEX");
 
     fragment = glCreateShader(GL_FRAGMENT_SHADER);
     glShaderSource(fragment, 1, &fShaderCode, NULL);
     glCompileShader(fragment);
-    checkCompileErrors(fragment, "FRAGMENT");
 
     ID = glCreateProgram();
     glAttachShader(ID, vertex);
     glAttachShader(ID, fragment);
+    if (cache_program) {
+        glProgramParameteri(ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    glLinkProgram(ID);
+
+    m_pending_link = true;
+    m_pending_vertex = vertex;
+    m_pending_fragment = fragment;
+    m_pending_cache_key = cache_program ? cache_key : 0;
+    if (!deferLink) {
+        finishLink();
+    }
+}
+
+Shader::Shader(const char* computePath) {
+    std::string computeCode;
+    std::ifstream cShaderFile(computePath);
+    if (cShaderFile) {
+        std::stringstream cShaderStream;
+        cShaderStream << cShaderFile.rdbuf();
+        computeCode = resolveIncludes(cShaderStream.str(), computePath);
+    }
+    else {
+        spdlog::error("Fatal error reading compute shader {}", computePath);
+    }
+    // no vertex stage, so the key cannot meet one of a render program
+    const bool cache_program = !computeCode.empty() && programBinariesSupported();
+    const uint64_t cache_key = cache_program ? programCacheKey(std::string(), computeCode) : 0;
+    if (cache_program && loadProgramBinary(cache_key)) {
+        reflectUniforms();
+        return;
+    }
+
+    const char* cShaderCode = computeCode.c_str();
+    unsigned int compute = glCreateShader(GL_COMPUTE_SHADER);
+    glShaderSource(compute, 1, &cShaderCode, NULL);
+    glCompileShader(compute);
+    checkCompileErrors(compute, "COMPUTE");
+
+    ID = glCreateProgram();
+    glAttachShader(ID, compute);
+    if (cache_program) {
+        glProgramParameteri(ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
     glLinkProgram(ID);
     checkCompileErrors(ID, "PROGRAM");
+    glDeleteShader(compute);
+    if (cache_program) {
+        saveProgramBinary(cache_key);
+    }
+    reflectUniforms();
+}
 
-    glDeleteShader(vertex);
-    glDeleteShader(fragment);
+void Shader::finishLink() {
+    if (!m_pending_link) {
+        return;
+    }
+    m_pending_link = false;
+    checkCompileErrors(m_pending_vertex, "VERTEX");
+    checkCompileErrors(m_pending_fragment, "FRAGMENT");
+    checkCompileErrors(ID, "PROGRAM");
+
+    glDeleteShader(m_pending_vertex);
+    glDeleteShader(m_pending_fragment);
+    m_pending_vertex = 0;
+    m_pending_fragment = 0;
+    if (m_pending_cache_key != 0) {
+        saveProgramBinary(m_pending_cache_key);
+    }
+    reflectUniforms();
 }
 
 void Shader::use() {
     glUseProgram(ID);
 }
 
-void Shader::setBool(const std::string& name, bool value) const {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+Shader::Uniform Shader::uniform(std::string_view name) const {
+    const auto it = m_uniform_index.find(name);
+    return it == m_uniform_index.end() ? Uniform{} : Uniform{ it->second };
 }
 
-void Shader::setInt(const std::string& name, int value) const {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+void Shader::setBool(Uniform uniform, bool value) const {
+    setInt(uniform, (int)value);
 }
 
-void Shader::setFloat(const std::string& name, float value) const {
-    glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+void Shader::setInt(Uniform uniform, int value) const {
+    if (changed(uniform, &value, sizeof(value))) {
+        glProgramUniform1i(ID, location(uniform), value);
+    }
 }
 
-void Shader::setDouble(const std::string& name, double value) const {
-    glUniform1d(glGetUniformLocation(ID, name.c_str()), value);
+void Shader::setFloat(Uniform uniform, float value) const {
+    if (changed(uniform, &value, sizeof(value))) {
+        glProgramUniform1f(ID, location(uniform), value);
+    }
 }
 
-void Shader::setDVec2(const std::string& name, double v1, double v2) const {
-    glUniform2d(glGetUniformLocation(ID, name.c_str()), v1, v2);
+void Shader::setDouble(Uniform uniform, double value) const {
+    if (changed(uniform, &value, sizeof(value))) {
+        glProgramUniform1d(ID, location(uniform), value);
+    }
 }
 
-void Shader::setVec2(const std::string& name, const glm::vec2& value) const {
-    glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+void Shader::setDVec2(Uniform uniform, double v1, double v2) const {
+    const double value[2] = { v1, v2 };
+    if (changed(uniform, value, sizeof(value))) {
+        glProgramUniform2dv(ID, location(uniform), 1, value);
+    }
 }
-void Shader::setVec2(const std::string& name, float x, float y) const {
-    glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y);
+
+void Shader::setVec2(Uniform uniform, float x, float y) const {
+    const float value[2] = { x, y };
+    if (changed(uniform, value, sizeof(value))) {
+        glProgramUniform2fv(ID, location(uniform), 1, value);
+    }
 }
 
-void Shader::setVec3(const std::string& name, const glm::vec3& value) const {
-    glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+void Shader::setVec3(Uniform uniform, float x, float y, float z) const {
+    const float value[3] = { x, y, z };
+    if (changed(uniform, value, sizeof(value))) {
+        glProgramUniform3fv(ID, location(uniform), 1, value);
+    }
 }
-void Shader::setVec3(const std::string& name, float x, float y, float z) const {
-    glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+
+void Shader::setVec4(Uniform uniform, float x, float y, float z, float w) const {
+    const float value[4] = { x, y, z, w };
+    if (changed(uniform, value, sizeof(value))) {
+        glProgramUniform4fv(ID, location(uniform), 1, value);
+    }
 }
 
-void Shader::setVec4(const std::string& name, const glm::vec4& value) const {
-    glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+void Shader::setIVec2(Uniform uniform, int v1, int v2) const {
+    const int value[2] = { v1, v2 };
+    if (changed(uniform, value, sizeof(value))) {
+        glProgramUniform2iv(ID, location(uniform), 1, value);
+    }
 }
-void Shader::setVec4(const std::string& name, float x, float y, float z, float w) const {
-    glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w);
+
+void Shader::setIVec4(Uniform uniform, int v1, int v2, int v3, int v4) const {
+    const int value[4] = { v1, v2, v3, v4 };
+    if (changed(uniform, value, sizeof(value))) {
+        glProgramUniform4iv(ID, location(uniform), 1, value);
+    }
+}
+
+void Shader::setIntArray(Uniform uniform, const int* values, int count) const {
+    if (count > 0 && changed(uniform, values, sizeof(int) * (size_t)count)) {
+        glProgramUniform1iv(ID, location(uniform), count, values);
+    }
+}
+
+void Shader::setBool(std::string_view name, bool value) const {
+    setInt(uniform(name), (int)value);
 }
 
-void Shader::setMat2(const std::string& name, const glm::mat2& mat) const {
-    glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+void Shader::setInt(std::string_view name, int value) const {
+    setInt(uniform(name), value);
 }
 
-void Shader::setMat3(const std::string& name, const glm::mat3& mat) const {
-    glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+void Shader::setFloat(std::string_view name, float value) const {
+    setFloat(uniform(name), value);
 }
 
-void Shader::setMat4(const std::string& name, const glm::mat4& mat) const {
-    glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+void Shader::setDouble(std::string_view name, double value) const {
+    setDouble(uniform(name), value);
+}
+
+void Shader::setDVec2(std::string_view name, double v1, double v2) const {
+    setDVec2(uniform(name), v1, v2);
+}
+
+void Shader::setVec2(std::string_view name, const glm::vec2& value) const {
+    setVec2(uniform(name), value.x, value.y);
+}
+void Shader::setVec2(std::string_view name, float x, float y) const {
+    setVec2(uniform(name), x, y);
+}
+
+void Shader::setVec3(std::string_view name, const glm::vec3& value) const {
+    setVec3(uniform(name), value.x, value.y, value.z);
+}
+void Shader::setVec3(std::string_view name, float x, float y, float z) const {
+    setVec3(uniform(name), x, y, z);
 }
 
-void Shader::setMat4(const std::string& name, const float* value) const
+void Shader::setVec4(std::string_view name, const glm::vec4& value) const {
+    setVec4(uniform(name), value.x, value.y, value.z, value.w);
+}
+void Shader::setVec4(std::string_view name, float x, float y, float z, float w) const {
+    setVec4(uniform(name), x, y, z, w);
+}
+
+void Shader::setMat2(std::string_view name, const glm::mat2& mat) const {
+    const Uniform handle = uniform(name);
+    if (changed(handle, &mat[0][0], sizeof(mat))) {
+        glProgramUniformMatrix2fv(ID, location(handle), 1, GL_FALSE, &mat[0][0]);
+    }
+}
+
+void Shader::setMat3(std::string_view name, const glm::mat3& mat) const {
+    const Uniform handle = uniform(name);
+    if (changed(handle, &mat[0][0], sizeof(mat))) {
+        glProgramUniformMatrix3fv(ID, location(handle), 1, GL_FALSE, &mat[0][0]);
+    }
+}
+
+void Shader::setMat4(std::string_view name, const glm::mat4& mat) const {
+    setMat4(name, &mat[0][0]);
+}
+
+void Shader::setMat4(std::string_view name, const float* value) const
 {
-    glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, value);
+    const Uniform handle = uniform(name);
+    if (changed(handle, value, sizeof(float) * 16)) {
+        glProgramUniformMatrix4fv(ID, location(handle), 1, GL_FALSE, value);
+    }
+}
+
+void Shader::setIVec2(std::string_view name, int v1, int v2) const {
+    setIVec2(uniform(name), v1, v2);
 }
 
-void Shader::setIVec4(const std::string& name, int v1, int v2, int v3, int v4) const {
-    glUniform4i(glGetUniformLocation(ID, name.c_str()), v1, v2, v3, v4);
+void Shader::setIVec4(std::string_view name, int v1, int v2, int v3, int v4) const {
+    setIVec4(uniform(name), v1, v2, v3, v4);
+}
+
+void Shader::setIntArray(std::string_view name, const int* values, int count) const {
+    setIntArray(uniform(name), values, count);
+}
+
+bool Shader::loadProgramBinary(uint64_t key) {
+    const std::filesystem::path path = programCachePath(key);
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    ProgramCacheHeader header;
+    file.read((char*)&header, sizeof(header));
+    if (!file || header.magic != PROGRAM_CACHE_MAGIC || header.version != PROGRAM_CACHE_VERSION || header.key != key || header.length == 0) {
+        return false;
+    }
+    std::vector<char> binary(header.length);
+    file.read(binary.data(), (std::streamsize)binary.size());
+    if (!file) {
+        return false;
+    }
+    file.close();
+
+    ID = glCreateProgram();
+    glProgramBinary(ID, (GLenum)header.format, binary.data(), (GLsizei)binary.size());
+    GLint linked = GL_FALSE;
+    glGetProgramiv(ID, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        spdlog::warn("Cached shader program {} was rejected by the driver, recompiling.", path.string());
+        glDeleteProgram(ID);
+        ID = 0;
+        std::error_code error;
+        std::filesystem::remove(path, error);
+        return false;
+    }
+    spdlog::debug("Shader program loaded from cache: {}", path.string());
+    return true;
+}
+
+void Shader::saveProgramBinary(uint64_t key) const {
+    GLint linked = GL_FALSE;
+    GLint length = 0;
+    glGetProgramiv(ID, GL_LINK_STATUS, &linked);
+    glGetProgramiv(ID, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (!linked || length <= 0) {
+        return;
+    }
+    ProgramCacheHeader header;
+    header.key = key;
+    std::vector<char> binary((size_t)length);
+    GLsizei written = 0;
+    GLenum format = 0;
+    glGetProgramBinary(ID, length, &written, &format, binary.data());
+    if (written <= 0) {
+        return;
+    }
+    header.format = (uint32_t)format;
+    header.length = (uint32_t)written;
+
+    // the worker context compiles too, so write under a per-thread name and move it into place
+    std::error_code error;
+    std::filesystem::create_directories(PROGRAM_CACHE_DIRECTORY, error);
+    const std::filesystem::path path = programCachePath(key);
+    std::filesystem::path temporary = path;
+    temporary += "." + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            spdlog::warn("Could not write shader cache file {}", temporary.string());
+            return;
+        }
+        file.write((const char*)&header, sizeof(header));
+        file.write(binary.data(), written);
+        if (!file) {
+            file.close();
+            std::filesystem::remove(temporary, error);
+            return;
+        }
+    }
+    std::filesystem::rename(temporary, path, error);
+    if (error) {
+        std::filesystem::remove(temporary, error);
+    }
+}
+
+void Shader::reflectUniforms() {
+    GLint count = 0;
+    GLint max_length = 0;
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+    std::vector<GLchar> name_buffer((size_t)std::max(max_length, 1));
+    size_t offset = 0;
+    for (GLint i = 0; i < count; ++i) {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(ID, (GLuint)i, (GLsizei)name_buffer.size(), &length, &size, &type, name_buffer.data());
+        std::string name(name_buffer.data(), (size_t)length);
+        const GLint uniform_location = glGetUniformLocation(ID, name.c_str());
+        if (uniform_location < 0) {
+            continue; // uniform block members have no location
+        }
+        UniformSlot slot;
+        slot.location = uniform_location;
+        slot.offset = offset;
+        slot.bytes = uniformTypeBytes(type) * (size_t)std::max(size, 1);
+        offset += slot.bytes;
+        const int index = (int)m_uniforms.size();
+        m_uniforms.push_back(slot);
+        // arrays are reported as name[0], both spellings resolve to the first element
+        if (name.size() > 3 && name.ends_with("[0]")) {
+            m_uniform_index.emplace(name.substr(0, name.size() - 3), index);
+        }
+        m_uniform_index.emplace(std::move(name), index);
+    }
+    m_uniform_values.assign(offset, 0);
+}
+
+bool Shader::changed(Uniform uniform, const void* data, size_t bytes) const {
+    if (!uniform.valid()) {
+        return false;
+    }
+    UniformSlot& slot = m_uniforms[uniform.index];
+    if (bytes > slot.bytes) {
+        return true; // more than the reflected size, the driver clamps it and there is nothing sensible to cache
+    }
+    unsigned char* cached = m_uniform_values.data() + slot.offset;
+    if (slot.uploaded && std::memcmp(cached, data, bytes) == 0) {
+        return false;
+    }
+    std::memcpy(cached, data, bytes);
+    slot.uploaded = true;
+    return true;
 }
 
 void Shader::checkCompileErrors(GLuint shader, std::string type) {
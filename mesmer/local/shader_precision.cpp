@@ -0,0 +1,107 @@
+/*
+	Mesmer - An interactive and high-performance fractal generator and explorer.
+	Made by -> Titan // GH: https://github.com/titan3755/mesmer
+	[shader_precision.cpp]
+*/
+
+#include <shader_precision.hpp>
+#include <shader.hpp>
+
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+	constexpr int BENCHMARK_SIZE = 256;
+	constexpr int BENCHMARK_ITERATIONS = 2000;
+	constexpr int BENCHMARK_RUNS = 3;
+
+	const char* const DF64_KERNELS[] = {
+		"mandelbrot", "burningship", "tricorn", "phoenix",
+		"mandelbrot_prerender", "burning_ship_prerender", "tricorn_prerender", "phoenix_prerender",
+	};
+
+	// best of a few timed draws after a warm-up one, the view is a seahorse valley window on the boundary where most pixels
+	// escape late, so neither the cardioid test nor cycle detection lets the kernels skip the iterations being timed
+	double timeKernel(Shader& shader, unsigned int vao, GLuint query) {
+		shader.use();
+		shader.setVec2("iResolution", (float)BENCHMARK_SIZE, (float)BENCHMARK_SIZE);
+		shader.setDVec2("u_center", -0.7436447860, 0.1318252536);
+		shader.setDouble("u_zoom", 200.0);
+		shader.setInt("u_max_iterations", BENCHMARK_ITERATIONS);
+		shader.setFloat("u_color_density", 0.05f);
+		glBindVertexArray(vao);
+		glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+		glFinish();
+		double best = std::numeric_limits<double>::max();
+		for (int run = 0; run < BENCHMARK_RUNS; ++run) {
+			glBeginQuery(GL_TIME_ELAPSED, query);
+			glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+			glEndQuery(GL_TIME_ELAPSED);
+			GLuint64 elapsed = 0;
+			glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+			best = std::min(best, (double)elapsed / 1.0e6);
+		}
+		glBindVertexArray(0);
+		return best;
+	}
+
+}
+
+PrecisionBenchmark benchmarkShaderPrecision(unsigned int vao) {
+	PrecisionBenchmark result;
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+
+	GLuint fbo = 0, texture = 0, query = 0;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, BENCHMARK_SIZE, BENCHMARK_SIZE, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glGenFramebuffers(1, &fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+	glGenQueries(1, &query);
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE) {
+		glViewport(0, 0, BENCHMARK_SIZE, BENCHMARK_SIZE);
+		Shader fp64("shaders/mandelbrot.vert", "shaders/mandelbrot.frag");
+		Shader df64("shaders/mandelbrot.vert", "shaders/mandelbrot_df64.frag");
+		result.fp64_ms = timeKernel(fp64, vao, query);
+		result.df64_ms = timeKernel(df64, vao, query);
+		result.valid = result.fp64_ms > 0.0 && result.df64_ms > 0.0;
+		glDeleteProgram(fp64.ID);
+		glDeleteProgram(df64.ID);
+	}
+	else {
+		spdlog::warn("Shader precision benchmark: framebuffer incomplete, keeping fp64 kernels.");
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glDeleteQueries(1, &query);
+	glDeleteFramebuffers(1, &fbo);
+	glDeleteTextures(1, &texture);
+	glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+	return result;
+}
+
+std::string df64FragmentPath(const std::string& fragment_path) {
+	const size_t slash = fragment_path.find_last_of("/\\");
+	const size_t start = slash == std::string::npos ? 0 : slash + 1;
+	const size_t dot = fragment_path.rfind(".frag");
+	if (dot == std::string::npos || dot < start) {
+		return {};
+	}
+	const std::string name = fragment_path.substr(start, dot - start);
+	for (const char* kernel : DF64_KERNELS) {
+		if (name == kernel) {
+			return fragment_path.substr(0, dot) + "_df64.frag";
+		}
+	}
+	return {};
+}
+
+bool df64Usable(double zoom, int pixels) {
+	// the views span [-1, 1] vertically, so a pixel is 2 / (zoom * pixels) wide
+	return 2.0 / (zoom * (double)std::max(pixels, 1)) >= DF64_MIN_PIXEL_SPACING;
+}
@@ -0,0 +1,229 @@
+/*
+	Mesmer - An interactive and high-performance fractal generator and explorer.
+	Made by -> Titan // GH: https://github.com/titan3755/mesmer
+	[shader_registry.cpp]
+*/
+
+#include <shader_registry.hpp>
+
+#include <chrono>
+#include <cstring>
+
+namespace {
+
+	using MaxShaderCompilerThreadsFn = void (APIENTRYP)(GLuint count);
+
+	bool extensionSupported(const char* name) {
+		GLint count = 0;
+		glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+		for (GLint i = 0; i < count; ++i) {
+			const GLubyte* extension = glGetStringi(GL_EXTENSIONS, (GLuint)i);
+			if (extension && std::strcmp((const char*)extension, name) == 0) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// lets the driver compile on its own threads, glad is generated without extensions so the entry point is loaded here
+	void enableParallelCompile() {
+		const char* function = nullptr;
+		if (extensionSupported("GL_KHR_parallel_shader_compile")) {
+			function = "glMaxShaderCompilerThreadsKHR";
+		}
+		else if (extensionSupported("GL_ARB_parallel_shader_compile")) {
+			function = "glMaxShaderCompilerThreadsARB";
+		}
+		MaxShaderCompilerThreadsFn max_threads = function ? (MaxShaderCompilerThreadsFn)SDL_GL_GetProcAddress(function) : nullptr;
+		if (max_threads == nullptr) {
+			spdlog::info("Shader registry: parallel shader compile is not available, programs build one after another.");
+			return;
+		}
+		max_threads(0xFFFFFFFFu); // the driver picks the thread count
+		spdlog::info("Shader registry: parallel shader compile enabled.");
+	}
+
+}
+
+ShaderRegistry::~ShaderRegistry() {
+	m_stop.store(true);
+	waitForPrecompile();
+}
+
+std::string ShaderRegistry::key(const std::string& vertex_path, const std::string& fragment_path) {
+	return vertex_path + "|" + fragment_path;
+}
+
+ShaderRegistry::Entry* ShaderRegistry::findOrAdd(const std::string& vertex_path, const std::string& fragment_path) {
+	std::string entry_key = key(vertex_path, fragment_path);
+	const auto it = m_index.find(entry_key);
+	if (it != m_index.end()) {
+		return it->second;
+	}
+	auto entry = std::make_unique<Entry>();
+	entry->vertex_path = vertex_path;
+	entry->fragment_path = fragment_path;
+	Entry* added = entry.get();
+	m_entries.push_back(std::move(entry));
+	m_index.emplace(std::move(entry_key), added);
+	return added;
+}
+
+void ShaderRegistry::add(const std::string& vertex_path, const std::string& fragment_path) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	findOrAdd(vertex_path, fragment_path);
+}
+
+void ShaderRegistry::precompile(SDL_Window* window, SDL_GLContext worker_context) {
+	std::lock_guard<std::mutex> lock(m_thread_mutex);
+	if (m_thread.joinable()) {
+		return;
+	}
+	m_stop.store(false);
+	m_thread = std::thread(&ShaderRegistry::compileQueued, this, window, worker_context);
+}
+
+void ShaderRegistry::compileQueued(SDL_Window* window, SDL_GLContext worker_context) {
+	if (SDL_GL_MakeCurrent(window, worker_context) != 0) {
+		spdlog::error("Shader registry: could not make the worker context current ({}), programs compile on first use.", SDL_GetError());
+		return;
+	}
+	const auto start = std::chrono::steady_clock::now();
+	enableParallelCompile();
+
+	// submit everything first so the driver threads have the whole batch, then collect the results.
+	// entries are claimed one at a time, so the main thread can still build one itself that was not submitted yet
+	std::vector<Entry*> batch;
+	std::vector<std::unique_ptr<Shader>> programs;
+	for (size_t i = 0; !m_stop.load(); ++i) {
+		Entry* entry = nullptr;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (i >= m_entries.size()) {
+				break;
+			}
+			if (m_entries[i]->state == State::QUEUED) {
+				entry = m_entries[i].get();
+				entry->state = State::COMPILING;
+			}
+		}
+		if (entry) {
+			batch.push_back(entry);
+			programs.push_back(build(entry->vertex_path, entry->fragment_path, true));
+		}
+	}
+
+	std::vector<bool> finished(batch.size(), false);
+	size_t next = 0;
+	for (size_t done = 0; done < batch.size() && !m_stop.load(); ++done) {
+		while (finished[next]) {
+			++next;
+		}
+		size_t pick = next;
+		{
+			// a program the main thread is blocked on goes first
+			std::lock_guard<std::mutex> lock(m_mutex);
+			for (size_t i = 0; m_wanted && i < batch.size(); ++i) {
+				if (batch[i] == m_wanted && !finished[i]) {
+					pick = i;
+				}
+			}
+		}
+		programs[pick]->finishLink();
+		// the other context may only use the program once this context is done with it
+		glFinish();
+		finished[pick] = true;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			batch[pick]->shader = std::move(programs[pick]);
+			batch[pick]->state = State::READY;
+			++m_ready_count;
+		}
+		m_program_ready.notify_all();
+	}
+
+	// stopped early, whatever was still building is dropped and goes back to compile-on-use
+	for (size_t i = 0; i < batch.size(); ++i) {
+		if (!finished[i]) {
+			glDeleteProgram(programs[i]->ID);
+			std::lock_guard<std::mutex> lock(m_mutex);
+			batch[i]->state = State::QUEUED;
+		}
+	}
+	m_program_ready.notify_all();
+	SDL_GL_MakeCurrent(window, nullptr);
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	spdlog::info("Shader registry: {} programs ready in {:.2f} s.", readyCount(), seconds);
+}
+
+Shader* ShaderRegistry::get(const std::string& vertex_path, const std::string& fragment_path) {
+	std::unique_lock<std::mutex> lock(m_mutex);
+	Entry* entry = findOrAdd(vertex_path, fragment_path);
+	if (entry->state == State::QUEUED) {
+		entry->state = State::COMPILING;
+		lock.unlock();
+		auto shader = build(vertex_path, fragment_path, false);
+		lock.lock();
+		entry->shader = std::move(shader);
+		entry->state = State::READY;
+		++m_ready_count;
+		lock.unlock();
+		m_program_ready.notify_all();
+		return entry->shader.get();
+	}
+	if (entry->state == State::COMPILING) {
+		m_wanted = entry;
+		m_program_ready.wait(lock, [entry]() { return entry->state != State::COMPILING; });
+		m_wanted = nullptr;
+		if (entry->state == State::QUEUED) {
+			// the background thread was stopped before it got here
+			lock.unlock();
+			return get(vertex_path, fragment_path);
+		}
+	}
+	return entry->shader.get();
+}
+
+std::unique_ptr<Shader> ShaderRegistry::build(const std::string& vertex_path, const std::string& fragment_path, bool defer_link) {
+	if (vertex_path.empty()) {
+		return std::make_unique<Shader>(fragment_path.c_str());
+	}
+	return std::make_unique<Shader>(vertex_path.c_str(), fragment_path.c_str(), defer_link);
+}
+
+bool ShaderRegistry::ready(const std::string& vertex_path, const std::string& fragment_path) const {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	const auto it = m_index.find(key(vertex_path, fragment_path));
+	return it != m_index.end() && it->second->state == State::READY;
+}
+
+int ShaderRegistry::readyCount() const {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_ready_count;
+}
+
+int ShaderRegistry::total() const {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return (int)m_entries.size();
+}
+
+void ShaderRegistry::waitForPrecompile() {
+	std::lock_guard<std::mutex> lock(m_thread_mutex);
+	if (m_thread.joinable()) {
+		m_thread.join();
+	}
+}
+
+void ShaderRegistry::release() {
+	m_stop.store(true);
+	waitForPrecompile();
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (const auto& entry : m_entries) {
+		if (entry->shader) {
+			glDeleteProgram(entry->shader->ID);
+			entry->shader.reset();
+		}
+		entry->state = State::QUEUED;
+	}
+	m_ready_count = 0;
+}
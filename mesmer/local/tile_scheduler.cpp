@@ -0,0 +1,166 @@
+/*
+	Mesmer - An interactive and high-performance fractal generator and explorer.
+	Made by -> Titan // GH: https://github.com/titan3755/mesmer
+	[tile_scheduler.cpp]
+*/
+
+#include <tile_scheduler.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+TileScheduler::TileScheduler(unsigned int worker_count) {
+	worker_count = std::max(1u, worker_count);
+	for (unsigned int i = 0; i < worker_count; ++i) {
+		m_queues.push_back(std::make_unique<WorkerQueue>());
+	}
+}
+
+void TileScheduler::reset(std::vector<ScheduledTile> tiles) {
+	std::stable_sort(tiles.begin(), tiles.end(), [](const ScheduledTile& a, const ScheduledTile& b) {
+		return a.priority < b.priority;
+	});
+	for (auto& queue : m_queues) {
+		std::lock_guard<std::mutex> lock(queue->mutex);
+		queue->tiles.clear();
+	}
+	for (size_t i = 0; i < tiles.size(); ++i) {
+		m_queues[i % m_queues.size()]->tiles.push_back(tiles[i]);
+	}
+	m_total.store((int)tiles.size());
+	m_completed.store(0);
+	m_stolen.store(0);
+	m_cancelled.store(false);
+}
+
+bool TileScheduler::acquire(unsigned int worker, ScheduledTile& tile) {
+	if (m_cancelled.load()) {
+		return false;
+	}
+	WorkerQueue& own = *m_queues[worker % m_queues.size()];
+	{
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if (!own.tiles.empty()) {
+			tile = own.tiles.front();
+			own.tiles.pop_front();
+			return true;
+		}
+	}
+	return steal(worker % m_queues.size(), tile);
+}
+
+bool TileScheduler::steal(unsigned int thief, ScheduledTile& tile) {
+	for (;;) {
+		if (m_cancelled.load()) {
+			return false;
+		}
+		// pick the victim with the most pending work, its back tile is the one it would reach last
+		size_t victim = m_queues.size();
+		size_t victim_size = 0;
+		for (size_t i = 0; i < m_queues.size(); ++i) {
+			if (i == thief) continue;
+			std::lock_guard<std::mutex> lock(m_queues[i]->mutex);
+			if (m_queues[i]->tiles.size() > victim_size) {
+				victim_size = m_queues[i]->tiles.size();
+				victim = i;
+			}
+		}
+		if (victim == m_queues.size()) {
+			return false;
+		}
+		std::lock_guard<std::mutex> lock(m_queues[victim]->mutex);
+		if (m_queues[victim]->tiles.empty()) {
+			continue; // the owner drained it in the meantime, look again
+		}
+		tile = m_queues[victim]->tiles.back();
+		m_queues[victim]->tiles.pop_back();
+		m_stolen.fetch_add(1);
+		return true;
+	}
+}
+
+void TileScheduler::complete(const ScheduledTile&) {
+	m_completed.fetch_add(1);
+}
+
+float TileScheduler::progress() const {
+	const int total = m_total.load();
+	return total > 0 ? (float)m_completed.load() / (float)total : 1.0f;
+}
+
+std::vector<ScheduledTile> TileScheduler::makeGrid(int width, int height, int tile_size, double focus_x, double focus_y) {
+	std::vector<ScheduledTile> tiles;
+	for (int gy = 0, y = 0; y < height; ++gy, y += tile_size) {
+		for (int gx = 0, x = 0; x < width; ++gx, x += tile_size) {
+			ScheduledTile tile;
+			tile.x = x;
+			tile.y = y;
+			tile.width = std::min(tile_size, width - x);
+			tile.height = std::min(tile_size, height - y);
+			tile.grid_x = gx;
+			tile.grid_y = gy;
+			const double dx = (x + tile.width * 0.5) - focus_x;
+			const double dy = (y + tile.height * 0.5) - focus_y;
+			tile.priority = std::sqrt(dx * dx + dy * dy);
+			tiles.push_back(tile);
+		}
+	}
+	return tiles;
+}
+
+double TileCostMap::rectMs(int x, int y, int width, int height) const {
+	if (empty() || width <= 0 || height <= 0) {
+		return 0.0;
+	}
+	const double cell_area = (double)cell_size * cell_size;
+	double ms = 0.0;
+	const int cy1 = std::min((y + height - 1) / cell_size, cells_y - 1);
+	const int cx1 = std::min((x + width - 1) / cell_size, cells_x - 1);
+	for (int cy = y / cell_size; cy <= cy1; ++cy) {
+		const int overlap_h = std::min(y + height, (cy + 1) * cell_size) - std::max(y, cy * cell_size);
+		for (int cx = x / cell_size; cx <= cx1; ++cx) {
+			const int overlap_w = std::min(x + width, (cx + 1) * cell_size) - std::max(x, cx * cell_size);
+			ms += cell_ms[(size_t)cy * cells_x + cx] * (overlap_w * (double)overlap_h / cell_area);
+		}
+	}
+	return ms;
+}
+
+std::vector<ScheduledTile> TileScheduler::makeAdaptive(int width, int height, int min_tile, int max_tile, const TileCostMap& cost, double budget_ms,
+	double focus_x, double focus_y) {
+	std::vector<ScheduledTile> tiles;
+	std::vector<int> stack;     // x, y, size of the squares still to place
+	for (int y = 0; y < height; y += max_tile) {
+		for (int x = 0; x < width; x += max_tile) {
+			stack.insert(stack.end(), { x, y, max_tile });
+		}
+	}
+	while (!stack.empty()) {
+		const int size = stack.back();
+		const int y = stack[stack.size() - 2];
+		const int x = stack[stack.size() - 3];
+		stack.resize(stack.size() - 3);
+		if (x >= width || y >= height) {
+			continue;
+		}
+		const int tile_width = std::min(size, width - x);
+		const int tile_height = std::min(size, height - y);
+		if (size > min_tile && cost.rectMs(x, y, tile_width, tile_height) > budget_ms) {
+			const int half = size / 2;
+			stack.insert(stack.end(), { x, y, half, x + half, y, half, x, y + half, half, x + half, y + half, half });
+			continue;
+		}
+		ScheduledTile tile;
+		tile.x = x;
+		tile.y = y;
+		tile.width = tile_width;
+		tile.height = tile_height;
+		tile.grid_x = x / size;
+		tile.grid_y = y / size;
+		const double dx = (x + tile.width * 0.5) - focus_x;
+		const double dy = (y + tile.height * 0.5) - focus_y;
+		tile.priority = std::sqrt(dx * dx + dy * dy);
+		tiles.push_back(tile);
+	}
+	return tiles;
+}
@@ -0,0 +1,371 @@
+/*
+	Mesmer - An interactive and high-performance fractal generator and explorer.
+	Made by -> Titan // GH: https://github.com/titan3755/mesmer
+	[virtual_texture.cpp]
+*/
+
+#include <virtual_texture.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <spdlog/spdlog.h>
+
+namespace {
+
+	constexpr int TABLE_BINDING = 4;            // layout(binding) of VirtualPageTable in texture_view.frag
+	constexpr int TABLE_LEVELS = VT_MAX_LEVELS + 1;
+	constexpr int TABLE_HEADER = TABLE_LEVELS * 4 + TABLE_LEVELS; // ivec4 window and int offset per level
+	constexpr int PAGES_PER_BATCH = 4;          // the context is handed back between batches so exports are not held up
+
+}
+
+bool VirtualTexture::create(int base_resolution, SDL_Window* window, SDL_GLContext worker_context, std::mutex* context_mutex,
+	unsigned int vbo, unsigned int ebo, KernelBinder bind_kernel) {
+	release();
+	m_base_pages = std::max(1, base_resolution / VT_PAGE_SIZE);
+	m_window = window;
+	m_worker_context = worker_context;
+	m_context_mutex = context_mutex;
+	m_vbo = vbo;
+	m_ebo = ebo;
+	m_bind_kernel = std::move(bind_kernel);
+
+	const int atlas_size = VT_CACHE_PAGES * VT_PAGE_SIZE;
+	const GLenum formats[2] = { GL_R32F, GL_RGBA8 };
+	unsigned int* atlases[2] = { &m_value_atlas, &m_orbit_atlas };
+	for (int k = 0; k < 2; ++k) {
+		glGenTextures(1, atlases[k]);
+		glBindTexture(GL_TEXTURE_2D, *atlases[k]);
+		glTexStorage2D(GL_TEXTURE_2D, 1, formats[k], atlas_size, atlas_size);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glGenBuffers(1, &m_page_table);
+	m_table.assign(TABLE_HEADER, 0);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_page_table);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, m_table.size() * sizeof(int32_t), m_table.data(), GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	// the worker context only sees complete objects
+	glFinish();
+
+	m_slots.assign(VT_CACHE_PAGES * VT_CACHE_PAGES, Slot{});
+	m_lookup.clear();
+	m_queue.clear();
+	m_rendering = 0;
+	m_level = 0;
+	m_frame = 0;
+	m_stop.store(false);
+	m_thread = std::thread(&VirtualTexture::workerLoop, this);
+	spdlog::info("Virtual texture: {} base pages per side, {}x{} page cache.", m_base_pages, VT_CACHE_PAGES, VT_CACHE_PAGES);
+	return m_value_atlas != 0 && m_orbit_atlas != 0 && m_page_table != 0;
+}
+
+void VirtualTexture::release() {
+	if (m_thread.joinable()) {
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stop.store(true);
+		}
+		m_wake.notify_all();
+		m_thread.join();
+	}
+	glDeleteTextures(1, &m_value_atlas);
+	glDeleteTextures(1, &m_orbit_atlas);
+	glDeleteBuffers(1, &m_page_table);
+	m_value_atlas = 0;
+	m_orbit_atlas = 0;
+	m_page_table = 0;
+	m_slots.clear();
+	m_lookup.clear();
+	m_queue.clear();
+	m_table.clear();
+	m_level = 0;
+}
+
+void VirtualTexture::update(double center_u, double center_v, double zoom, int drawable_w, int drawable_h) {
+	if (!active() || drawable_w <= 0 || drawable_h <= 0) {
+		return;
+	}
+	++m_frame;
+	// texture_view.frag scales the shorter side of the screen to 1 / zoom in uv
+	const double pixels_per_unit = zoom * std::min(drawable_w, drawable_h);
+	const double half_w = 0.5 * drawable_w / pixels_per_unit;
+	const double half_h = 0.5 * drawable_h / pixels_per_unit;
+	const double grid_u = center_u + 0.5;
+	const double grid_v = center_v + 0.5;
+	// the closest level, a page texel covers between 0.7 and 1.4 screen pixels
+	const double base_density = (double)m_base_pages * VT_PAGE_SIZE;
+	m_level = std::clamp((int)std::lround(std::log2(std::max(pixels_per_unit / base_density, 1.0))), 0, VT_MAX_LEVELS);
+
+	std::vector<Window> windows(TABLE_LEVELS);
+	for (int level = 1; level <= m_level; ++level) {
+		const int pages = pagesPerSide(level);
+		const int x0 = std::clamp((int)std::floor((grid_u - half_w) * pages), 0, pages - 1);
+		const int x1 = std::clamp((int)std::floor((grid_u + half_w) * pages), 0, pages - 1);
+		const int y0 = std::clamp((int)std::floor((grid_v - half_h) * pages), 0, pages - 1);
+		const int y1 = std::clamp((int)std::floor((grid_v + half_h) * pages), 0, pages - 1);
+		const bool visible = grid_u + half_w >= 0.0 && grid_u - half_w < 1.0 && grid_v + half_h >= 0.0 && grid_v - half_h < 1.0;
+		windows[level] = visible ? Window{ x0, y0, x1 - x0 + 1, y1 - y0 + 1 } : Window{};
+	}
+
+	std::vector<int32_t> table(TABLE_HEADER, 0);
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		// requests of the last frame that no worker has picked up are redone for this view
+		dropQueued();
+
+		// visible pages of the wanted level outlive everything else, visible coarser ones only what is off screen
+		struct Wanted { int x; int y; double distance; };
+		std::vector<Wanted> wanted;
+		for (int level = 1; level <= m_level; ++level) {
+			const Window& window = windows[level];
+			const double pages = pagesPerSide(level);
+			for (int y = window.y; y < window.y + window.height; ++y) {
+				for (int x = window.x; x < window.x + window.width; ++x) {
+					const auto found = m_lookup.find(pageKey(level, x, y));
+					if (found != m_lookup.end()) {
+						m_slots[found->second].last_used = level == m_level ? m_frame : m_frame - 1;
+					}
+					else if (level == m_level) {
+						const double dx = (x + 0.5) / pages - grid_u;
+						const double dy = (y + 0.5) / pages - grid_v;
+						wanted.push_back({ x, y, dx * dx + dy * dy });
+					}
+				}
+			}
+		}
+		// the middle of the screen first
+		std::sort(wanted.begin(), wanted.end(), [](const Wanted& a, const Wanted& b) { return a.distance < b.distance; });
+		// a worker that lost its context takes no more pages, the coarser levels stay up
+		if (m_stop.load()) {
+			wanted.clear();
+		}
+		for (const Wanted& page : wanted) {
+			const int slot = acquireSlot();
+			if (slot < 0) {
+				break;
+			}
+			m_slots[slot].key = pageKey(m_level, page.x, page.y);
+			m_slots[slot].state = SlotState::QUEUED;
+			m_slots[slot].last_used = m_frame;
+			m_lookup[m_slots[slot].key] = slot;
+			m_queue.push_back(slot);
+		}
+
+		for (int level = 1; level <= m_level; ++level) {
+			const Window& window = windows[level];
+			table[level * 4] = window.x;
+			table[level * 4 + 1] = window.y;
+			table[level * 4 + 2] = window.width;
+			table[level * 4 + 3] = window.height;
+			// entries follow the header, the offsets count from there
+			table[TABLE_LEVELS * 4 + level] = (int32_t)table.size() - TABLE_HEADER;
+			for (int y = window.y; y < window.y + window.height; ++y) {
+				for (int x = window.x; x < window.x + window.width; ++x) {
+					const auto found = m_lookup.find(pageKey(level, x, y));
+					const bool resident = found != m_lookup.end() && m_slots[found->second].state == SlotState::RESIDENT;
+					table.push_back(resident ? found->second : -1);
+				}
+			}
+		}
+	}
+	m_wake.notify_all();
+
+	if (table != m_table) {
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_page_table);
+		if (table.size() > m_table.size()) {
+			glBufferData(GL_SHADER_STORAGE_BUFFER, table.size() * sizeof(int32_t), table.data(), GL_DYNAMIC_DRAW);
+		}
+		else {
+			glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, table.size() * sizeof(int32_t), table.data());
+		}
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+		m_table = std::move(table);
+	}
+}
+
+void VirtualTexture::dropQueued() {
+	for (int slot : m_queue) {
+		m_lookup.erase(m_slots[slot].key);
+		m_slots[slot] = Slot{};
+	}
+	m_queue.clear();
+}
+
+int VirtualTexture::acquireSlot() {
+	// an empty slot, otherwise the least recently seen page that is not on screen at the wanted level
+	int best = -1;
+	for (int slot = 0; slot < (int)m_slots.size(); ++slot) {
+		const Slot& entry = m_slots[slot];
+		if (entry.state == SlotState::EMPTY) {
+			return slot;
+		}
+		if (entry.state == SlotState::RESIDENT && entry.last_used < m_frame && (best < 0 || entry.last_used < m_slots[best].last_used)) {
+			best = slot;
+		}
+	}
+	if (best >= 0) {
+		m_lookup.erase(m_slots[best].key);
+		m_slots[best] = Slot{};
+	}
+	return best;
+}
+
+void VirtualTexture::bind(Shader* shader, int value_unit, int orbit_unit) const {
+	shader->setInt("u_vt_level", active() ? m_level : 0);
+	if (!active()) {
+		return;
+	}
+	shader->setInt("u_vt_value", value_unit);
+	shader->setInt("u_vt_orbit", orbit_unit);
+	shader->setInt("u_vt_base_pages", m_base_pages);
+	glActiveTexture(GL_TEXTURE0 + value_unit);
+	glBindTexture(GL_TEXTURE_2D, m_value_atlas);
+	glActiveTexture(GL_TEXTURE0 + orbit_unit);
+	glBindTexture(GL_TEXTURE_2D, m_orbit_atlas);
+	glActiveTexture(GL_TEXTURE0);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, TABLE_BINDING, m_page_table);
+}
+
+int VirtualTexture::residentPages() const {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return (int)std::count_if(m_slots.begin(), m_slots.end(), [](const Slot& slot) { return slot.state == SlotState::RESIDENT; });
+}
+
+int VirtualTexture::queuedPages() const {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return (int)m_queue.size() + m_rendering;
+}
+
+bool VirtualTexture::busy() const {
+	return active() && queuedPages() > 0;
+}
+
+void VirtualTexture::workerLoop() {
+	GLuint vao = 0;
+	GLuint fbo = 0;
+	bool context_ready = false;
+	for (;;) {
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_wake.wait(lock, [this] { return m_stop.load() || !m_queue.empty(); });
+			if (m_stop.load()) {
+				break;
+			}
+		}
+		// the pre-render and the export hold the context for their whole run, pages wait and the coarser levels stay up
+		std::unique_lock<std::mutex> context(*m_context_mutex, std::defer_lock);
+		while (!m_stop.load() && !context.try_lock()) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(5));
+		}
+		if (m_stop.load()) {
+			break;
+		}
+		if (SDL_GL_MakeCurrent(m_window, m_worker_context) != 0) {
+			spdlog::error("Virtual texture: could not set GL context! Error: {}", SDL_GetError());
+			// nothing renders the queue any more, the viewer must not wait on it
+			std::lock_guard<std::mutex> lock(m_mutex);
+			dropQueued();
+			m_stop.store(true);
+			break;
+		}
+		if (!context_ready) {
+			// vertex arrays and framebuffers are not shared between contexts
+			glGenVertexArrays(1, &vao);
+			glBindVertexArray(vao);
+			glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
+			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+			glEnableVertexAttribArray(0);
+			glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
+			glEnableVertexAttribArray(1);
+			glGenFramebuffers(1, &fbo);
+			glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_value_atlas, 0);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, m_orbit_atlas, 0);
+			const GLenum attachments[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+			glDrawBuffers(2, attachments);
+			if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+				spdlog::error("Virtual texture: page framebuffer is not complete!");
+			}
+			context_ready = true;
+		}
+		glBindVertexArray(vao);
+		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+
+		int batch[PAGES_PER_BATCH];
+		uint64_t keys[PAGES_PER_BATCH];
+		int count = 0;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			while (count < PAGES_PER_BATCH && !m_queue.empty()) {
+				batch[count] = m_queue.front();
+				keys[count] = m_slots[batch[count]].key;
+				m_slots[batch[count]].state = SlotState::RENDERING;
+				m_queue.pop_front();
+				++count;
+			}
+			m_rendering = count;
+		}
+		Shader* kernel = nullptr;
+		int kernel_level = -1;
+		bool drawn = true;
+		for (int i = 0; i < count; ++i) {
+			const int level = (int)(keys[i] >> 48);
+			const int x = (int)(keys[i] & 0xFFFFFF);
+			const int y = (int)((keys[i] >> 24) & 0xFFFFFF);
+			const int pages = pagesPerSide(level);
+			if (level != kernel_level) {
+				// the kernel follows the level, deep levels switch to df64 like the live view does
+				kernel = m_bind_kernel(pages * VT_PAGE_SIZE);
+				kernel_level = level;
+			}
+			if (kernel == nullptr) {
+				drawn = false;
+				break;
+			}
+			glViewport((batch[i] % VT_CACHE_PAGES) * VT_PAGE_SIZE, (batch[i] / VT_CACHE_PAGES) * VT_PAGE_SIZE, VT_PAGE_SIZE, VT_PAGE_SIZE);
+			kernel->setIVec4("u_tile_info", x * VT_PAGE_SIZE, y * VT_PAGE_SIZE, VT_PAGE_SIZE, VT_PAGE_SIZE);
+			kernel->setIVec2("u_image_size", pages * VT_PAGE_SIZE, pages * VT_PAGE_SIZE);
+			glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+		}
+		// the main context samples the atlas as soon as the page is marked resident
+		GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 5'000'000) == GL_TIMEOUT_EXPIRED) {
+		}
+		glDeleteSync(fence);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		SDL_GL_MakeCurrent(m_window, nullptr);
+		context.unlock();
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (int i = 0; i < count; ++i) {
+			Slot& slot = m_slots[batch[i]];
+			if (slot.state == SlotState::RENDERING && slot.key == keys[i]) {
+				if (drawn) {
+					slot.state = SlotState::RESIDENT;
+				}
+				else {
+					m_lookup.erase(slot.key);
+					slot = Slot{};
+				}
+			}
+		}
+		m_rendering = 0;
+		if (!drawn) {
+			spdlog::error("Virtual texture: no kernel for the detail pages, dropping the queue.");
+			dropQueued();
+		}
+	}
+	// the objects of this context go with it, the context may be gone by the time the application exits
+	if (context_ready && m_context_mutex->try_lock()) {
+		if (SDL_GL_MakeCurrent(m_window, m_worker_context) == 0) {
+			glDeleteFramebuffers(1, &fbo);
+			glDeleteVertexArrays(1, &vao);
+			SDL_GL_MakeCurrent(m_window, nullptr);
+		}
+		m_context_mutex->unlock();
+	}
+}
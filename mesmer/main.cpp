@@ -5,6 +5,7 @@
 */
 
 #include <application.hpp>
+#include <headless_render.hpp>
 
 const char* WINDOW_TITLE = "Mesmer";
 const char* SETTINGS_FILE = "settings.mesmer";
@@ -31,6 +32,10 @@ std::map<std::string, std::string> app_metadata = {
 };
 
 int main(int argc, char* argv[]) {
+	// `mesmer render ...` renders without a window, see headless_render.hpp
+	if (argc >= 2 && std::string(argv[1]) == "render") {
+		return runHeadlessRender(argc - 2, argv + 2);
+	}
 	Application app(WINDOW_TITLE, SETTINGS_FILE, app_metadata, argc, argv);
 	try {
 		app.run();
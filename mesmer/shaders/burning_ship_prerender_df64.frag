@@ -0,0 +1,58 @@
+/*
+	Mesmer - An interactive and high-performance fractal generator and explorer.
+	Made by -> Titan // GH: https://github.com/titan3755/mesmer
+	[burning_ship_prerender_df64.frag]
+*/
+
+#version 460 core
+#include "df64.glsl"
+#include "gbuffer.glsl"
+#include "interior.glsl"
+in vec2 TexCoords;
+uniform dvec2 u_center;
+uniform double u_zoom;
+uniform int u_max_iterations;
+uniform ivec4 u_tile_info;   // pixel rect of the tile (x, y, width, height)
+uniform ivec2 u_image_size;  // the whole image the rect is part of
+void main()
+{
+    dvec2 global_uv = (dvec2(u_tile_info.xy) + dvec2(TexCoords) * dvec2(u_tile_info.zw)) / dvec2(u_image_size);
+    global_uv = global_uv * 2.0 - 1.0;
+    dvec2 c = global_uv / u_zoom + u_center;
+    vec2 cx = df64_from_double(c.x);
+    vec2 cy = df64_from_double(c.y);
+    vec2 zx = vec2(0.0);
+    vec2 zy = vec2(0.0);
+    float magnitude = 0.0;
+    vec2 saved_x = zx;
+    vec2 saved_y = zy;
+    int next_save = 8;
+    int i;
+    for (i = 0; i < u_max_iterations; i++) {
+        zx = df64_abs(zx);
+        zy = df64_abs(zy);
+        vec2 xy = df64_mul(zx, zy);
+        zx = df64_add(df64_sub(df64_sqr(zx), df64_sqr(zy)), cx);
+        zy = df64_add(2.0 * xy, cy);
+        magnitude = zx.x * zx.x + zy.x * zy.x;
+        if (magnitude > 4.0) break;
+        if ((i & 7) == 0) {
+            if (abs(df64_sub(zx, saved_x).x) + abs(df64_sub(zy, saved_y).x) < PERIOD_EPSILON_DF64) {
+                i = u_max_iterations;
+                break;
+            }
+            if (i >= next_save) {
+                saved_x = zx;
+                saved_y = zy;
+                next_save *= 2;
+            }
+        }
+    }
+    if (i == u_max_iterations) {
+        writeGBuffer(0.0, vec2(0.0), 0.0, 0);
+    }
+    else {
+        float smooth_i = float(i) - log2(log2(magnitude));
+        writeGBuffer(smooth_i, vec2(zx.x, zy.x), 0.0, 1);
+    }
+}
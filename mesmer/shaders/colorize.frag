@@ -0,0 +1,24 @@
+/*
+	Mesmer - An interactive and high-performance fractal generator and explorer.
+	Made by -> Titan // GH: https://github.com/titan3755/mesmer
+	[colorize.frag]
+*/
+
+#version 460 core
+
+#define GBUFFER_READ_ONLY
+#include "gbuffer.glsl"
+#include "colorize.glsl"
+
+out vec4 FragColor;
+uniform sampler2D u_gbuffer_value;
+uniform sampler2D u_gbuffer_orbit;
+
+void main()
+{
+    // the pass covers the texture 1:1, so every fragment reads exactly its own texel
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    float value = texelFetch(u_gbuffer_value, texel, 0).r;
+    vec4 orbit = texelFetch(u_gbuffer_orbit, texel, 0);
+    FragColor = vec4(colorizeTexel(value, orbit), 1.0);
+}
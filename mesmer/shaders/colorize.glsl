@@ -0,0 +1,56 @@
+/*
+	Mesmer - An interactive and high-performance fractal generator and explorer.
+	Made by -> Titan // GH: https://github.com/titan3755/mesmer
+	[colorize.glsl]
+*/
+
+// palette mapping of the iteration g-buffer (see gbuffer.glsl), shared by the colour pass over the pre-render texture
+// and the viewer, which colours the detail pages of the virtual texture as it draws them
+
+uniform vec3 u_palette_a;
+uniform vec3 u_palette_b;
+uniform vec3 u_palette_c;
+uniform vec3 u_palette_d;
+uniform float u_color_density;
+uniform float u_palette_offset; // palette cycling phase
+uniform int u_colorize_mode;    // 0 escape time, 1 newton basins, 2 lyapunov exponent
+uniform int u_color_style;      // 0 smooth, 1 distance shaded, 2 binary decomposition
+
+vec3 palette(float t) {
+    return u_palette_a + u_palette_b * cos(6.28318 * (u_palette_c * t + u_palette_d));
+}
+
+vec3 colorizeTexel(float value, vec4 orbit)
+{
+    int basin = gbufferBasin(orbit);
+    vec3 color = vec3(0.0);
+    if (u_colorize_mode == 1) {
+        // the root picks a palette component as its base hue, iterations darken it
+        float base_hue = basin == 1 ? u_palette_a.x : basin == 2 ? u_palette_b.y : basin == 3 ? u_palette_c.z : 0.0;
+        if (base_hue > 0.0) {
+            color = palette(base_hue - value * u_color_density * 2.0 + u_palette_offset);
+        }
+    }
+    else if (u_colorize_mode == 2) {
+        if (basin == 1) {
+            color = palette(value * u_color_density * 50.0 + u_palette_offset);
+        }
+        else {
+            color = vec3(0.0, 0.1, 0.5) * clamp(abs(value) * 2.0, 0.0, 1.0);
+        }
+    }
+    else if (basin != 0) {
+        float t = value * u_color_density + u_palette_offset;
+        // binary decomposition: the lower half plane of the final z is shifted by half a palette period
+        if (u_color_style == 2 && orbit.y < 0.5) {
+            t += 0.5;
+        }
+        color = palette(t);
+        // distance shading darkens the last pixels before the boundary, kernels without an estimate leave it alone
+        if (u_color_style == 1 && orbit.z > 0.0) {
+            float distance_px = exp2(gbufferDecodeLog2(orbit.z));
+            color *= clamp(0.25 + 0.75 * sqrt(distance_px * 0.5), 0.0, 1.0);
+        }
+    }
+    return color;
+}
@@ -0,0 +1,100 @@
+/*
+	Mesmer - An interactive and high-performance fractal generator and explorer.
+	Made by -> Titan // GH: https://github.com/titan3755/mesmer
+	[compaction.glsl]
+*/
+
+// stream compaction of the compute kernels. a tile is iterated in chunks of iterations: the first pass runs every pixel
+// of the tile, every later one only the orbits still running after the last chunk, read from one list and appended
+// packed to the other. the lists are swapped between passes, so a chunk never spends lanes on finished pixels.
+// the last pass appends the orbits that ran out at the limit, a render keeps them to continue to a higher one
+
+layout(local_size_x = 64) in;
+
+uniform ivec4 u_tile_info;   // pixel rect of the tile (x, y, width, height)
+uniform ivec2 u_image_size;  // the whole image the rect is part of
+uniform int u_iter_begin;    // the chunk covers [u_iter_begin, u_iter_end), 0 starts the tile
+uniform int u_iter_end;
+uniform int u_next_save;     // period check save point at u_iter_begin, the same for every running orbit
+
+// 48 bytes in std430
+struct OrbitState {
+    dvec2 z;
+    dvec2 z_saved;
+    vec2 dz;
+    uint texel;    // x in the low 16 bits, y in the high ones
+    uint pad;
+};
+
+layout(std430, binding = 6) readonly buffer SurvivorsIn {
+    uint survivors_in_count;
+    uint survivors_in_pad[3];
+    OrbitState survivors_in[];
+};
+
+// count reset to 0 by compaction_dispatch.comp before every pass. past the end of the list the count keeps going
+// but the orbits are dropped, the host finds out from the count
+layout(std430, binding = 7) buffer SurvivorsOut {
+    uint survivors_out_count;
+    uint survivors_out_pad[3];
+    OrbitState survivors_out[];
+};
+
+shared uint s_scan[64];
+shared uint s_base;
+
+ivec2 compactionTexel(OrbitState orbit)
+{
+    return ivec2(orbit.texel & 0xFFFFu, orbit.texel >> 16);
+}
+
+// the orbit this invocation continues, on the first pass a fresh one at its pixel of the tile. z and dz are left for the
+// kernel to start there
+bool compactionFetch(out OrbitState orbit)
+{
+    orbit = OrbitState(dvec2(0.0), dvec2(0.0), vec2(0.0), 0u, 0u);
+    uint index = gl_GlobalInvocationID.x;
+    if (u_iter_begin == 0) {
+        uint width = uint(u_tile_info.z);
+        if (index >= width * uint(u_tile_info.w)) {
+            return false;
+        }
+        ivec2 texel = u_tile_info.xy + ivec2(index % width, index / width);
+        orbit.texel = uint(texel.x) | (uint(texel.y) << 16);
+        return true;
+    }
+    if (index >= survivors_in_count) {
+        return false;
+    }
+    orbit = survivors_in[index];
+    return true;
+}
+
+// the same mapping as the fragment kernels, pixel centres over [-1, 1]
+dvec2 compactionPixelUv(ivec2 texel)
+{
+    return (dvec2(texel) + 0.5) / dvec2(u_image_size) * 2.0 - 1.0;
+}
+
+// every invocation of the group has to call this. a scan over the group gives the running orbits their offsets and one
+// atomic reserves the whole run in the output list
+void compactionAppend(bool running, OrbitState orbit)
+{
+    uint lane = gl_LocalInvocationIndex;
+    s_scan[lane] = running ? 1u : 0u;
+    barrier();
+    for (uint offset = 1u; offset < 64u; offset <<= 1u) {
+        uint add = lane >= offset ? s_scan[lane - offset] : 0u;
+        barrier();
+        s_scan[lane] += add;
+        barrier();
+    }
+    if (lane == 63u) {
+        s_base = s_scan[63] > 0u ? atomicAdd(survivors_out_count, s_scan[63]) : 0u;
+    }
+    barrier();
+    uint slot = s_base + s_scan[lane] - 1u;
+    if (running && slot < uint(survivors_out.length())) {
+        survivors_out[slot] = orbit;
+    }
+}
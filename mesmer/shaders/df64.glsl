@@ -0,0 +1,71 @@
+/*
+	Mesmer - An interactive and high-performance fractal generator and explorer.
+	Made by -> Titan // GH: https://github.com/titan3755/mesmer
+	[df64.glsl]
+*/
+
+// df64 (double-float) arithmetic: a value is the unevaluated sum hi + lo of two floats, ~48 mantissa bits
+// from fp32 instructions only. everything is precise, reassociating or contracting the error terms breaks it
+
+vec2 df64_from_double(double a)
+{
+    precise float hi = float(a);
+    precise float lo = float(a - double(hi));
+    return vec2(hi, lo);
+}
+
+vec2 df64_quick_two_sum(float a, float b)
+{
+    precise float s = a + b;
+    precise float e = b - (s - a);
+    return vec2(s, e);
+}
+
+vec2 df64_two_sum(float a, float b)
+{
+    precise float s = a + b;
+    precise float v = s - a;
+    precise float e = (a - (s - v)) + (b - v);
+    return vec2(s, e);
+}
+
+vec2 df64_two_prod(float a, float b)
+{
+    precise float p = a * b;
+    precise float e = fma(a, b, -p);
+    return vec2(p, e);
+}
+
+vec2 df64_add(vec2 a, vec2 b)
+{
+    precise vec2 s = df64_two_sum(a.x, b.x);
+    precise vec2 t = df64_two_sum(a.y, b.y);
+    s.y += t.x;
+    s = df64_quick_two_sum(s.x, s.y);
+    s.y += t.y;
+    return df64_quick_two_sum(s.x, s.y);
+}
+
+vec2 df64_sub(vec2 a, vec2 b)
+{
+    return df64_add(a, -b);
+}
+
+vec2 df64_mul(vec2 a, vec2 b)
+{
+    precise vec2 p = df64_two_prod(a.x, b.x);
+    p.y += a.x * b.y + a.y * b.x;
+    return df64_quick_two_sum(p.x, p.y);
+}
+
+vec2 df64_sqr(vec2 a)
+{
+    precise vec2 p = df64_two_prod(a.x, a.x);
+    p.y += 2.0 * a.x * a.y;
+    return df64_quick_two_sum(p.x, p.y);
+}
+
+vec2 df64_abs(vec2 a)
+{
+    return a.x < 0.0 ? -a : a;
+}
@@ -0,0 +1,77 @@
+/*
+	Mesmer - An interactive and high-performance fractal generator and explorer.
+	Made by -> Titan // GH: https://github.com/titan3755/mesmer
+	[gbuffer.glsl]
+*/
+
+// iteration g-buffer of the pre-render kernels, the palette is only applied afterwards by colorize.frag
+// attachment 0 (r32f):  palette coordinate before u_color_density (smooth iteration count, newton iterations, lyapunov exponent)
+// attachment 1 (rgba8): x = log2 |z| of the final z, y = arg(z) / 2pi + 0.5, z = log2 of the distance estimate in pixels
+//                       (0 when the kernel has none), w = basin id / 255
+// basin 0 is the fractal's fixed colour (interior, no root found, stable lyapunov), escape time kernels write 1 and
+// newton the number of the root it converged to
+
+const float GBUFFER_LOG_RANGE = 16.0; // the log2 channels cover [-8, 8]
+
+float gbufferDecodeLog2(float encoded)
+{
+    return (encoded - 0.5) * GBUFFER_LOG_RANGE;
+}
+
+int gbufferBasin(vec4 orbit)
+{
+    return int(orbit.w * 255.0 + 0.5);
+}
+
+#ifndef GBUFFER_READ_ONLY
+#ifdef GBUFFER_IMAGE
+// compute kernels store to the same textures bound as images
+layout(binding = 0, r32f) uniform writeonly image2D u_gbuffer_value_image;
+layout(binding = 1, rgba8) uniform writeonly image2D u_gbuffer_orbit_image;
+#else
+layout(location = 0) out float GValue;
+layout(location = 1) out vec4 GOrbit;
+#endif
+
+float gbufferEncodeLog2(float value)
+{
+    return clamp(value / GBUFFER_LOG_RANGE + 0.5, 0.0, 1.0);
+}
+
+// exterior distance estimate 0.5 |z| ln|z| / |dz/dc| in pixels, an overflowed derivative means the pixel touches the boundary
+float gbufferDistance(vec2 z, vec2 dz, float pixel_size)
+{
+    float dz_mag = length(dz);
+    if (isinf(dz_mag) || isnan(dz_mag))
+    {
+        return 1.0e-6;
+    }
+    float z_mag = length(z);
+    return 0.5 * z_mag * log(z_mag) / (dz_mag * pixel_size);
+}
+
+vec4 gbufferOrbit(vec2 z, float distance_px, int basin)
+{
+    float z_mag = length(z);
+    vec4 orbit;
+    orbit.x = z_mag > 0.0 ? gbufferEncodeLog2(log2(z_mag)) : 0.0;
+    orbit.y = z_mag > 0.0 ? atan(z.y, z.x) / 6.28318 + 0.5 : 0.5;
+    orbit.z = distance_px > 0.0 ? max(gbufferEncodeLog2(log2(distance_px)), 1.0 / 255.0) : 0.0;
+    orbit.w = float(basin) / 255.0;
+    return orbit;
+}
+
+#ifdef GBUFFER_IMAGE
+void storeGBuffer(ivec2 texel, float value, vec2 z, float distance_px, int basin)
+{
+    imageStore(u_gbuffer_value_image, texel, vec4(value));
+    imageStore(u_gbuffer_orbit_image, texel, gbufferOrbit(z, distance_px, basin));
+}
+#else
+void writeGBuffer(float value, vec2 z, float distance_px, int basin)
+{
+    GValue = value;
+    GOrbit = gbufferOrbit(z, distance_px, basin);
+}
+#endif
+#endif
@@ -0,0 +1,26 @@
+/*
+	Mesmer - An interactive and high-performance fractal generator and explorer.
+	Made by -> Titan // GH: https://github.com/titan3755/mesmer
+	[interior.glsl]
+*/
+
+// interior shortcuts shared by the escape time kernels
+
+// the main cardioid and the period-2 bulb of the power 2 set never escape
+bool insideCardioidOrBulb(dvec2 c)
+{
+    double x = c.x - 0.25;
+    double q = x * x + c.y * c.y;
+    if (q * (q + x) <= 0.25 * c.y * c.y)
+    {
+        return true;
+    }
+    double b = c.x + 1.0;
+    return b * b + c.y * c.y <= 0.0625;
+}
+
+// brent cycle detection: every 8th iteration z is compared with a point saved at doubling intervals,
+// an orbit that comes back to it has converged to an attracting cycle and is interior
+const double PERIOD_EPSILON = 1.0e-14LF;
+// the df64 kernels compare the high words of the difference, keeping the loop free of fp64
+const float PERIOD_EPSILON_DF64 = 1.0e-14;
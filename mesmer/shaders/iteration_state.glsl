@@ -0,0 +1,54 @@
+/*
+	Mesmer - An interactive and high-performance fractal generator and explorer.
+	Made by -> Titan // GH: https://github.com/titan3755/mesmer
+	[iteration_state.glsl]
+*/
+
+// resumable iteration state of the live view (iteration_state.hpp). full resolution passes keep where every pixel's
+// orbit stopped, so raising the limit on an unchanged view continues the pixels that ran out instead of starting over.
+// escaped and interior pixels are final, their colour is left alone by a resumed pass
+
+uniform int u_state_width;   // drawable width while the pass keeps state, 0 otherwise
+uniform int u_resume_from;   // the limit the kept orbits ran to, 0 starts every pixel afresh
+uniform int u_resume_save;   // period check save point at u_resume_from, the same for every kept orbit
+
+// z and the period check point of the pixels that ran out
+layout(std430, binding = 9) buffer IterationOrbits {
+    dvec4 state_orbits[];
+};
+// 1 for a pixel that ran out at the limit, 0 for a final one
+layout(std430, binding = 10) buffer IterationStatus {
+    uint state_running[];
+};
+
+uint statePixel()
+{
+    return uint(gl_FragCoord.y) * uint(u_state_width) + uint(gl_FragCoord.x);
+}
+
+// the orbit a resumed pass continues, false for a final pixel
+bool resumeOrbit(out dvec2 z, out dvec2 z_saved)
+{
+    uint pixel = statePixel();
+    if (state_running[pixel] == 0u) {
+        z = dvec2(0.0);
+        z_saved = dvec2(0.0);
+        return false;
+    }
+    dvec4 orbit = state_orbits[pixel];
+    z = orbit.xy;
+    z_saved = orbit.zw;
+    return true;
+}
+
+void keepOrbit(bool running, dvec2 z, dvec2 z_saved)
+{
+    if (u_state_width <= 0) {
+        return;
+    }
+    uint pixel = statePixel();
+    state_running[pixel] = running ? 1u : 0u;
+    if (running) {
+        state_orbits[pixel] = dvec4(z, z_saved);
+    }
+}
@@ -5,6 +5,8 @@
 */
 
 #version 460 core
+#include "iteration_state.glsl"
+#include "interior.glsl"
 
 out vec4 FragColor;
 in vec2 TexCoords;
@@ -29,8 +31,21 @@ void main()
     dvec2 uv = (dvec2(TexCoords) * 2.0 - 1.0);
     uv.x *= double(iResolution.x) / double(iResolution.y);
     dvec2 z = uv / u_zoom + u_center;
-    int i;
-    for (i = 0; i < u_max_iterations; i++)
+    dvec2 z_saved = z;
+    int next_save = 8;
+    int i = 0;
+    bool bounded = false;
+    if (u_resume_from > 0)
+    {
+        // only the orbits that ran out at the old limit go on
+        if (!resumeOrbit(z, z_saved))
+        {
+            discard;
+        }
+        i = u_resume_from;
+        next_save = u_resume_save;
+    }
+    for (; i < u_max_iterations; i++)
     {
         double x_temp = z.x * z.x - z.y * z.y + u_julia_c.x;
         z.y = 2.0 * z.x * z.y + u_julia_c.y;
@@ -39,8 +54,23 @@ void main()
         {
             break;
         }
+        if ((i & 7) == 0)
+        {
+            if (abs(z.x - z_saved.x) + abs(z.y - z_saved.y) < PERIOD_EPSILON)
+            {
+                i = u_max_iterations;
+                bounded = true;
+                break;
+            }
+            if (i >= next_save)
+            {
+                z_saved = z;
+                next_save *= 2;
+            }
+        }
     }
 
+    keepOrbit(i == u_max_iterations && !bounded, z, z_saved);
     if (i == u_max_iterations)
     {
         FragColor = vec4(0.0, 0.0, 0.0, 1.0);
@@ -5,22 +5,18 @@
 */
 
 #version 460 core
-out vec4 FragColor;
+#include "gbuffer.glsl"
 in vec2 TexCoords;
 uniform dvec2 u_lyapunov_center;
 uniform double u_lyapunov_zoom;
 uniform int u_max_iterations;
-uniform vec3 u_palette_a, u_palette_b, u_palette_c, u_palette_d;
-uniform float u_color_density;
-uniform ivec4 u_tile_info;
+uniform ivec4 u_tile_info;   // pixel rect of the tile (x, y, width, height)
+uniform ivec2 u_image_size;  // the whole image the rect is part of
 const int sequence[4] = int[4](0, 1, 0, 1); // ABAB
 const int sequence_len = 4;
-vec3 palette(float t) {
-    return u_palette_a + u_palette_b * cos(6.28318 * (u_palette_c * t + u_palette_d));
-}
 void main()
 {
-    dvec2 global_uv = (dvec2(u_tile_info.x, u_tile_info.y) + TexCoords) / dvec2(u_tile_info.z, u_tile_info.w);
+    dvec2 global_uv = (dvec2(u_tile_info.xy) + dvec2(TexCoords) * dvec2(u_tile_info.zw)) / dvec2(u_image_size);
     global_uv = global_uv * 2.0 - 1.0;
     dvec2 ab = global_uv / u_lyapunov_zoom + u_lyapunov_center;
     dvec2 r_params = dvec2(ab.x, ab.y);
@@ -37,10 +33,6 @@ void main()
         }
     }
     lambda /= double(n_sum);
-    if (lambda > 0.0) {
-        FragColor = vec4(palette(float(lambda) * u_color_density * 50.0), 1.0);
-    } else {
-        float stability = clamp(abs(float(lambda)) * 2.0, 0.0, 1.0);
-        FragColor = vec4(vec3(0.0, 0.1, 0.5) * stability, 1.0);
-    }
+    // chaotic (lambda > 0) pixels take the palette, stable ones get the fixed blue of colorize.frag
+    writeGBuffer(float(lambda), vec2(x, 0.0), 0.0, lambda > 0.0 ? 1 : 0);
 }
\ No newline at end of file
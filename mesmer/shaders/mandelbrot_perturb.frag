@@ -0,0 +1,127 @@
+/*
+	Mesmer - An interactive and high-performance fractal generator and explorer.
+	Made by -> Titan // GH: https://github.com/titan3755/mesmer
+	[mandelbrot_perturb.frag]
+*/
+
+#version 460 core
+
+out vec4 FragColor;
+in vec2 TexCoords;
+
+// reference orbit Z_0 .. Z_n, computed in arbitrary precision on the cpu
+layout(std430, binding = 0) readonly buffer ReferenceOrbit {
+    dvec2 u_orbit[];
+};
+
+// bilinear approximation table, entry e is A = u_bla[3e], B = u_bla[3e + 1], r = u_bla[3e + 2].x
+// and jumps 2^level iterations from orbit index 1 + j * 2^level: dz -> A*dz + B*dc
+layout(std430, binding = 1) readonly buffer BlaTable {
+    dvec2 u_bla[];
+};
+
+const int MAX_BLA_LEVELS = 32;
+
+uniform int u_orbit_length;
+uniform int u_bla_levels; // 0 disables the table
+uniform int u_bla_offset[MAX_BLA_LEVELS];
+uniform int u_bla_count[MAX_BLA_LEVELS];
+uniform dvec2 u_reference_offset; // view centre minus reference centre
+uniform double u_zoom;
+uniform int u_max_iterations;
+uniform vec2 iResolution;
+uniform vec3 u_palette_a;
+uniform vec3 u_palette_b;
+uniform vec3 u_palette_c;
+uniform vec3 u_palette_d;
+uniform float u_color_density;
+
+vec3 palette(float t) {
+    return u_palette_a + u_palette_b * cos(6.28318 * (u_palette_c * t + u_palette_d));
+}
+
+void main()
+{
+    dvec2 uv = (dvec2(TexCoords) * 2.0 - 1.0);
+    uv.x *= double(iResolution.x) / double(iResolution.y);
+    // only the distance to the reference is needed, and that stays representable in fp64
+    dvec2 dc = uv / u_zoom + u_reference_offset;
+    dvec2 dz = dvec2(0.0);
+    dvec2 z = dvec2(0.0);
+    int ref = 0;
+    int n = 0;
+    bool escaped = false;
+    while (n < u_max_iterations)
+    {
+        int steps = 0;
+        if (ref > 0 && u_bla_levels > 0)
+        {
+            // a merged radius never exceeds the radius of its first half, so scan up from the single step
+            int start = ref - 1;
+            int top = start == 0 ? u_bla_levels - 1 : min(findLSB(start), u_bla_levels - 1);
+            double dz_mag = dot(dz, dz);
+            int best = -1;
+            for (int level = 0; level <= top; level++)
+            {
+                int j = start >> level;
+                if ((1 << level) > u_max_iterations - n || j >= u_bla_count[level])
+                {
+                    break;
+                }
+                int e = (u_bla_offset[level] + j) * 3;
+                double r = u_bla[e + 2].x;
+                if (dz_mag >= r * r)
+                {
+                    break;
+                }
+                best = e;
+                steps = 1 << level;
+            }
+            if (best >= 0)
+            {
+                dvec2 A = u_bla[best];
+                dvec2 B = u_bla[best + 1];
+                dz = dvec2(A.x * dz.x - A.y * dz.y + B.x * dc.x - B.y * dc.y, A.x * dz.y + A.y * dz.x + B.x * dc.y + B.y * dc.x);
+            }
+        }
+        if (steps == 0)
+        {
+            dvec2 Z = u_orbit[ref];
+            // dz' = 2*Z*dz + dz^2 + dc
+            double x_temp = 2.0 * (Z.x * dz.x - Z.y * dz.y) + (dz.x * dz.x - dz.y * dz.y) + dc.x;
+            dz.y = 2.0 * (Z.x * dz.y + Z.y * dz.x) + 2.0 * dz.x * dz.y + dc.y;
+            dz.x = x_temp;
+            steps = 1;
+        }
+        ref += steps;
+        n += steps;
+
+        z = u_orbit[ref] + dz;
+        double mag = dot(z, z);
+        if (mag > 4.0)
+        {
+            escaped = true;
+            break;
+        }
+        // rebase onto the start of the orbit when the pixel gets closer to 0 than to the reference
+        if (mag < dot(dz, dz) || ref == u_orbit_length - 1)
+        {
+            dz = z;
+            ref = 0;
+        }
+    }
+    // same iteration index the plain shader breaks at
+    int i = escaped ? n - 1 : u_max_iterations;
+    if (i == u_max_iterations)
+    {
+        FragColor = vec4(0.0, 0.0, 0.0, 1.0);
+    }
+    else
+    {
+        float magnitude = float(dot(z, z));
+        float smooth_i = float(i) - log2(log2(magnitude));
+        float color_val = smooth_i * u_color_density;
+        vec3 color = palette(color_val);
+        FragColor = vec4(color, 1.0);
+    }
+}
@@ -5,37 +5,47 @@
 */
 
 #version 460 core
-out vec4 FragColor;
+#include "gbuffer.glsl"
+#include "interior.glsl"
 in vec2 TexCoords;
 uniform dvec2 u_center;
 uniform double u_zoom;
 uniform int u_max_iterations;
-uniform vec3 u_palette_a;
-uniform vec3 u_palette_b;
-uniform vec3 u_palette_c;
-uniform vec3 u_palette_d;
-uniform float u_color_density;
-uniform ivec4 u_tile_info;
-vec3 palette(float t) {
-    return u_palette_a + u_palette_b * cos(6.28318 * (u_palette_c * t + u_palette_d));
-}
+uniform ivec4 u_tile_info;   // pixel rect of the tile (x, y, width, height)
+uniform ivec2 u_image_size;  // the whole image the rect is part of
 void main()
 {
-    dvec2 global_uv = (dvec2(u_tile_info.x, u_tile_info.y) + TexCoords) / dvec2(u_tile_info.z, u_tile_info.w);
+    dvec2 global_uv = (dvec2(u_tile_info.xy) + dvec2(TexCoords) * dvec2(u_tile_info.zw)) / dvec2(u_image_size);
     global_uv = global_uv * 2.0 - 1.0;
     dvec2 c = global_uv / u_zoom + u_center;
+    // pixel spacing in the plane, the distance estimate is stored in pixels
+    float pixel_size = 2.0 / float(u_image_size.x) / float(u_zoom);
     dvec2 z = dvec2(0.0);
-    int i;
-    for (i = 0; i < u_max_iterations; i++) {
+    vec2 dz = vec2(0.0); // dz/dc in fp32, only the distance estimate needs it
+    dvec2 z_saved = z;
+    int next_save = 8;
+    int i = insideCardioidOrBulb(c) ? u_max_iterations : 0;
+    for (; i < u_max_iterations; i++) {
+        vec2 zf = vec2(z);
+        dz = 2.0 * vec2(zf.x * dz.x - zf.y * dz.y, zf.x * dz.y + zf.y * dz.x) + vec2(1.0, 0.0);
         z = dvec2(z.x*z.x - z.y*z.y, 2.0*z.x*z.y) + c;
         if (dot(z, z) > 4.0) break;
+        if ((i & 7) == 0) {
+            if (abs(z.x - z_saved.x) + abs(z.y - z_saved.y) < PERIOD_EPSILON) {
+                i = u_max_iterations;
+                break;
+            }
+            if (i >= next_save) {
+                z_saved = z;
+                next_save *= 2;
+            }
+        }
     }
     if (i == u_max_iterations) {
-        FragColor = vec4(0.0, 0.0, 0.0, 1.0);
+        writeGBuffer(0.0, vec2(0.0), 0.0, 0);
     } else {
         float magnitude = float(dot(z, z));
         float smooth_i = float(i) - log2(log2(magnitude));
-        float color_val = smooth_i * u_color_density;
-        FragColor = vec4(palette(color_val), 1.0);
+        writeGBuffer(smooth_i, vec2(z), gbufferDistance(vec2(z), dz, pixel_size), 1);
     }
 }
\ No newline at end of file
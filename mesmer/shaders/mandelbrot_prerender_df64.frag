@@ -0,0 +1,59 @@
+/*
+	Mesmer - An interactive and high-performance fractal generator and explorer.
+	Made by -> Titan // GH: https://github.com/titan3755/mesmer
+	[mandelbrot_prerender_df64.frag]
+*/
+
+#version 460 core
+#include "df64.glsl"
+#include "gbuffer.glsl"
+#include "interior.glsl"
+in vec2 TexCoords;
+uniform dvec2 u_center;
+uniform double u_zoom;
+uniform int u_max_iterations;
+uniform ivec4 u_tile_info;   // pixel rect of the tile (x, y, width, height)
+uniform ivec2 u_image_size;  // the whole image the rect is part of
+void main()
+{
+    dvec2 global_uv = (dvec2(u_tile_info.xy) + dvec2(TexCoords) * dvec2(u_tile_info.zw)) / dvec2(u_image_size);
+    global_uv = global_uv * 2.0 - 1.0;
+    dvec2 c = global_uv / u_zoom + u_center;
+    // pixel spacing in the plane, the distance estimate is stored in pixels
+    float pixel_size = 2.0 / float(u_image_size.x) / float(u_zoom);
+    vec2 cx = df64_from_double(c.x);
+    vec2 cy = df64_from_double(c.y);
+    vec2 zx = vec2(0.0);
+    vec2 zy = vec2(0.0);
+    vec2 dz = vec2(0.0); // dz/dc from the high words, only the distance estimate needs it
+    float magnitude = 0.0;
+    vec2 saved_x = zx;
+    vec2 saved_y = zy;
+    int next_save = 8;
+    int i = insideCardioidOrBulb(c) ? u_max_iterations : 0;
+    for (; i < u_max_iterations; i++) {
+        dz = 2.0 * vec2(zx.x * dz.x - zy.x * dz.y, zx.x * dz.y + zy.x * dz.x) + vec2(1.0, 0.0);
+        vec2 xy = df64_mul(zx, zy);
+        zx = df64_add(df64_sub(df64_sqr(zx), df64_sqr(zy)), cx);
+        zy = df64_add(2.0 * xy, cy);
+        magnitude = zx.x * zx.x + zy.x * zy.x;
+        if (magnitude > 4.0) break;
+        if ((i & 7) == 0) {
+            if (abs(df64_sub(zx, saved_x).x) + abs(df64_sub(zy, saved_y).x) < PERIOD_EPSILON_DF64) {
+                i = u_max_iterations;
+                break;
+            }
+            if (i >= next_save) {
+                saved_x = zx;
+                saved_y = zy;
+                next_save *= 2;
+            }
+        }
+    }
+    if (i == u_max_iterations) {
+        writeGBuffer(0.0, vec2(0.0), 0.0, 0);
+    } else {
+        float smooth_i = float(i) - log2(log2(magnitude));
+        writeGBuffer(smooth_i, vec2(zx.x, zy.x), gbufferDistance(vec2(zx.x, zy.x), dz, pixel_size), 1);
+    }
+}
@@ -5,6 +5,7 @@
 */
 
 #version 460 core
+#include "interior.glsl"
 out vec4 FragColor;
 in vec2 TexCoords;
 uniform dvec2 u_center;
@@ -40,8 +41,8 @@ void main() {
     dvec2 c = uv / u_zoom + u_center;
     dvec2 z = dvec2(0.0);
     
-    int i;
-    for (i = 0; i < u_max_iterations; i++) {
+    int i = (u_power == 2.0 && insideCardioidOrBulb(c)) ? u_max_iterations : 0;
+    for (; i < u_max_iterations; i++) {
         z = cpow(z, u_power) + c;
         if (dot(z, z) > 4.0) break;
     }
@@ -5,26 +5,21 @@
 */
 
 #version 460 core
-out vec4 FragColor;
+#include "gbuffer.glsl"
 in vec2 TexCoords;
 uniform dvec2 u_center;
 uniform double u_zoom;
 uniform int u_max_iterations;
-uniform ivec4 u_tile_info;
-uniform vec3 u_palette_a, u_palette_b, u_palette_c, u_palette_d;
-uniform float u_color_density;
+uniform ivec4 u_tile_info;   // pixel rect of the tile (x, y, width, height)
+uniform ivec2 u_image_size;  // the whole image the rect is part of
 dvec2 cmult(dvec2 a, dvec2 b) { return dvec2(a.x*b.x - a.y*b.y, a.x*b.y + a.y*b.x); }
 dvec2 cdiv(dvec2 a, dvec2 b) {
     double denom = b.x*b.x + b.y*b.y;
     return dvec2((a.x*b.x + a.y*b.y)/denom, (a.y*b.x - a.x*b.y)/denom);
 }
-vec3 palette(float t) 
-{
-    return u_palette_a + u_palette_b * cos(6.28318 * (u_palette_c * t + u_palette_d));
-}
 void main()
 {
-    dvec2 global_uv = (dvec2(u_tile_info.x, u_tile_info.y) + TexCoords) / dvec2(u_tile_info.z, u_tile_info.w);
+    dvec2 global_uv = (dvec2(u_tile_info.xy) + dvec2(TexCoords) * dvec2(u_tile_info.zw)) / dvec2(u_image_size);
     global_uv = global_uv * 2.0 - 1.0;
     dvec2 z = global_uv / u_zoom + u_center;
     dvec2 root1 = dvec2(1.0, 0.0);
@@ -39,14 +34,10 @@ void main()
         z = cdiv(dvec2(2.0, 0.0) * z3 + dvec2(1.0, 0.0), dvec2(3.0, 0.0) * z2);
         if (distance(z, root1) < tolerance || distance(z, root2) < tolerance || distance(z, root3) < tolerance) break;
     }
-    float base_hue = 0.0;
-    if (distance(z, root1) < tolerance)      base_hue = u_palette_a.x;
-    else if (distance(z, root2) < tolerance) base_hue = u_palette_b.y;
-    else if (distance(z, root3) < tolerance) base_hue = u_palette_c.z;
-    vec3 color = vec3(0.0);
-    if (base_hue > 0.0) {
-        float color_val = base_hue - float(i) * u_color_density * 2.0;
-        color = palette(color_val);
-    }
-    FragColor = vec4(color, 1.0);
+    // the basin is the root it converged to, colorize.frag turns it into the base hue
+    int basin = 0;
+    if (distance(z, root1) < tolerance)      basin = 1;
+    else if (distance(z, root2) < tolerance) basin = 2;
+    else if (distance(z, root3) < tolerance) basin = 3;
+    writeGBuffer(float(i), vec2(z), 0.0, basin);
 }
\ No newline at end of file
@@ -5,16 +5,15 @@
 */
 
 #version 460 core
-out vec4 FragColor;
+#include "gbuffer.glsl"
 in vec2 TexCoords;
 uniform dvec2 u_center;
 uniform double u_zoom;
 uniform int u_max_iterations;
 uniform double u_power;
 uniform double u_relaxation;
-uniform vec3 u_palette_a, u_palette_b, u_palette_c, u_palette_d;
-uniform float u_color_density;
-uniform ivec4 u_tile_info;
+uniform ivec4 u_tile_info;   // pixel rect of the tile (x, y, width, height)
+uniform ivec2 u_image_size;  // the whole image the rect is part of
 dvec2 cmult(dvec2 a, dvec2 b) { return dvec2(a.x*b.x - a.y*b.y, a.x*b.y + a.y*b.x); }
 dvec2 cdiv(dvec2 a, dvec2 b) {
     double denom = b.x*b.x + b.y*b.y;
@@ -31,12 +30,9 @@ dvec2 cpow(dvec2 z, double exponent) {
     float new_y = r_pow * sin(exp * theta);
     return dvec2(new_x, new_y);
 }
-vec3 palette(float t) {
-    return u_palette_a + u_palette_b * cos(6.28318 * (u_palette_c * t + u_palette_d));
-}
 void main()
 {
-    dvec2 global_uv = (dvec2(u_tile_info.x, u_tile_info.y) + TexCoords) / dvec2(u_tile_info.z, u_tile_info.w);
+    dvec2 global_uv = (dvec2(u_tile_info.xy) + dvec2(TexCoords) * dvec2(u_tile_info.zw)) / dvec2(u_image_size);
     global_uv = global_uv * 2.0 - 1.0;
     dvec2 c = global_uv / u_zoom + u_center;
     dvec2 z = dvec2(1.0, 0.0);
@@ -49,13 +45,11 @@ void main()
         if (dot(z, z) > 100.0) break;
     }
     if (i == u_max_iterations) {
-        FragColor = vec4(0.0, 0.0, 0.0, 1.0);
+        writeGBuffer(0.0, vec2(0.0), 0.0, 0);
     }
     else {
         float magnitude = float(dot(z, z));
         float smooth_i = float(i) - log2(log2(magnitude));
-        float color_val = smooth_i * u_color_density;
-        vec3 color = palette(color_val);
-        FragColor = vec4(color, 1.0);
+        writeGBuffer(smooth_i, vec2(z), 0.0, 1);
     }
 }
\ No newline at end of file
@@ -0,0 +1,53 @@
+/*
+	Mesmer - An interactive and high-performance fractal generator and explorer.
+	Made by -> Titan // GH: https://github.com/titan3755/mesmer
+	[persistent_queue.glsl]
+*/
+
+// work queue of the persistent compute kernels. only as many workgroups as the gpu keeps resident are launched, and
+// every invocation takes the next pixels of the tile from an atomic counter as soon as it is done with its last one,
+// so a lane stuck on an interior orbit no longer holds up the rest of its warp
+
+layout(local_size_x = 64) in;
+
+uniform ivec4 u_tile_info;   // pixel rect of the tile (x, y, width, height)
+uniform ivec2 u_image_size;  // the whole image the rect is part of
+
+// reset to 0 before every dispatch
+layout(std430, binding = 5) buffer PersistentQueue {
+    uint queue_next;
+};
+
+const uint QUEUE_BATCH = 4u; // pixels taken per atomic, cheap exterior pixels would otherwise queue on the counter
+
+struct QueueCursor {
+    uint next;
+    uint end;
+};
+
+QueueCursor queueBegin()
+{
+    return QueueCursor(0u, 0u);
+}
+
+bool queueFetch(inout QueueCursor cursor, out ivec2 texel)
+{
+    if (cursor.next == cursor.end) {
+        cursor.next = atomicAdd(queue_next, QUEUE_BATCH);
+        cursor.end = cursor.next + QUEUE_BATCH;
+    }
+    uint pixel = cursor.next++;
+    uint width = uint(u_tile_info.z);
+    if (pixel >= width * uint(u_tile_info.w)) {
+        texel = ivec2(0);
+        return false;
+    }
+    texel = u_tile_info.xy + ivec2(pixel % width, pixel / width);
+    return true;
+}
+
+// the same mapping as the fragment kernels, pixel centres over [-1, 1]
+dvec2 queuePixelUv(ivec2 texel)
+{
+    return (dvec2(texel) + 0.5) / dvec2(u_image_size) * 2.0 - 1.0;
+}
@@ -0,0 +1,50 @@
+/*
+	Mesmer - An interactive and high-performance fractal generator and explorer.
+	Made by -> Titan // GH: https://github.com/titan3755/mesmer
+	[phoenix_prerender_df64.frag]
+*/
+
+#version 460 core
+#include "df64.glsl"
+#include "gbuffer.glsl"
+in vec2 TexCoords;
+uniform dvec2 u_center;
+uniform double u_zoom;
+uniform int u_max_iterations;
+uniform dvec2 u_phoenix_c;
+uniform double u_phoenix_p;
+uniform ivec4 u_tile_info;   // pixel rect of the tile (x, y, width, height)
+uniform ivec2 u_image_size;  // the whole image the rect is part of
+void main()
+{
+    dvec2 global_uv = (dvec2(u_tile_info.xy) + dvec2(TexCoords) * dvec2(u_tile_info.zw)) / dvec2(u_image_size);
+    global_uv = global_uv * 2.0 - 1.0;
+    dvec2 z0 = global_uv / u_zoom + u_center;
+    vec2 zx = df64_from_double(z0.x);
+    vec2 zy = df64_from_double(z0.y);
+    vec2 prev_x = vec2(0.0);
+    vec2 prev_y = vec2(0.0);
+    vec2 pcx = df64_from_double(u_phoenix_c.x);
+    vec2 pcy = df64_from_double(u_phoenix_c.y);
+    vec2 p = df64_from_double(u_phoenix_p);
+    float magnitude = zx.x * zx.x + zy.x * zy.x;
+    int i;
+    for (i = 0; i < u_max_iterations; i++) {
+        vec2 temp_x = zx;
+        vec2 temp_y = zy;
+        vec2 xy = df64_mul(zx, zy);
+        zx = df64_add(df64_add(df64_sub(df64_sqr(zx), df64_sqr(zy)), pcx), df64_mul(p, prev_x));
+        zy = df64_add(df64_add(2.0 * xy, pcy), df64_mul(p, prev_y));
+        prev_x = temp_x;
+        prev_y = temp_y;
+        magnitude = zx.x * zx.x + zy.x * zy.x;
+        if (magnitude > 4.0) break;
+    }
+    if (i == u_max_iterations) {
+        writeGBuffer(0.0, vec2(0.0), 0.0, 0);
+    }
+    else {
+        float smooth_i = float(i) - log2(log2(magnitude));
+        writeGBuffer(smooth_i, vec2(zx.x, zy.x), 0.0, 1);
+    }
+}
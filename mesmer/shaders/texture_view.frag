@@ -5,6 +5,11 @@
 */
 
 #version 460 core
+
+#define GBUFFER_READ_ONLY
+#include "gbuffer.glsl"
+#include "colorize.glsl"
+
 out vec4 FragColor;
 in vec2 TexCoords;
 uniform sampler2D screenTexture;
@@ -12,6 +17,45 @@ uniform dvec2 u_center;
 uniform double u_zoom;
 uniform vec2 iResolution;
 
+// virtual texture detail pages, sizes as in virtual_texture.hpp
+const int VT_PAGE_SIZE = 256;
+const int VT_CACHE_PAGES = 16;
+const int VT_TABLE_LEVELS = 11;
+uniform int u_vt_level;            // finest level on screen, 0 shows the pre-render texture alone
+uniform int u_vt_base_pages;       // pages per side of level 0
+uniform sampler2D u_vt_value;
+uniform sampler2D u_vt_orbit;
+layout(std430, binding = 4) readonly buffer VirtualPageTable {
+    ivec4 vt_windows[VT_TABLE_LEVELS];  // first page and page count of the visible window per level
+    int vt_offsets[VT_TABLE_LEVELS];    // where the window's entries start
+    int vt_entries[];                   // cache slot per page, -1 while it is not in
+};
+
+// the finest resident page under the fragment, false when none is
+bool samplePages(dvec2 grid_uv, out vec3 color)
+{
+    if (any(lessThan(grid_uv, dvec2(0.0))) || any(greaterThanEqual(grid_uv, dvec2(1.0)))) {
+        return false;
+    }
+    for (int level = u_vt_level; level >= 1; --level) {
+        dvec2 page_coord = grid_uv * double(u_vt_base_pages << level);
+        ivec4 window = vt_windows[level];
+        ivec2 local = ivec2(floor(page_coord)) - window.xy;
+        if (any(lessThan(local, ivec2(0))) || any(greaterThanEqual(local, window.zw))) {
+            continue;
+        }
+        int slot = vt_entries[vt_offsets[level] + local.y * window.z + local.x];
+        if (slot < 0) {
+            continue;
+        }
+        ivec2 inside = min(ivec2(vec2(fract(page_coord)) * float(VT_PAGE_SIZE)), ivec2(VT_PAGE_SIZE - 1));
+        ivec2 texel = ivec2(slot % VT_CACHE_PAGES, slot / VT_CACHE_PAGES) * VT_PAGE_SIZE + inside;
+        color = colorizeTexel(texelFetch(u_vt_value, texel, 0).r, texelFetch(u_vt_orbit, texel, 0));
+        return true;
+    }
+    return false;
+}
+
 void main()
 {
     float screenAspect = iResolution.x / iResolution.y;
@@ -24,5 +68,10 @@ void main()
     }
     uv = uv / u_zoom + u_center;
     uv += 0.5;
+    vec3 page_color;
+    if (u_vt_level > 0 && samplePages(uv, page_color)) {
+        FragColor = vec4(page_color, 1.0);
+        return;
+    }
     FragColor = texture(screenTexture, vec2(uv));
-}
\ No newline at end of file
+}
@@ -1,4 +1,5 @@
 #version 460 core
+#include "interior.glsl"
 
 out vec4 FragColor;
 in vec2 TexCoords;
@@ -25,6 +26,8 @@ void main()
     dvec2 c = uv / u_zoom + u_center;
     dvec2 z = dvec2(0.0);
     
+    dvec2 z_saved = z;
+    int next_save = 8;
     int i;
     for (i = 0; i < u_max_iterations; i++)
     {
@@ -37,6 +40,19 @@ void main()
         {
             break;
         }
+        if ((i & 7) == 0)
+        {
+            if (abs(z.x - z_saved.x) + abs(z.y - z_saved.y) < PERIOD_EPSILON)
+            {
+                i = u_max_iterations;
+                break;
+            }
+            if (i >= next_save)
+            {
+                z_saved = z;
+                next_save *= 2;
+            }
+        }
     }
 
     if (i == u_max_iterations)
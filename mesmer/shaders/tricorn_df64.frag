@@ -0,0 +1,84 @@
+/*
+	Mesmer - An interactive and high-performance fractal generator and explorer.
+	Made by -> Titan // GH: https://github.com/titan3755/mesmer
+	[tricorn_df64.frag]
+*/
+
+#version 460 core
+
+#include "df64.glsl"
+#include "interior.glsl"
+
+out vec4 FragColor;
+in vec2 TexCoords;
+
+uniform dvec2 u_center;
+uniform double u_zoom;
+uniform int u_max_iterations;
+uniform vec2 iResolution;
+uniform vec3 u_palette_a;
+uniform vec3 u_palette_b;
+uniform vec3 u_palette_c;
+uniform vec3 u_palette_d;
+uniform float u_color_density;
+
+vec3 palette(float t) {
+    return u_palette_a + u_palette_b * cos(6.28318 * (u_palette_c * t + u_palette_d));
+}
+
+void main()
+{
+    dvec2 uv = (dvec2(TexCoords) * 2.0 - 1.0);
+    uv.x *= double(iResolution.x) / double(iResolution.y);
+    
+    dvec2 c = uv / u_zoom + u_center;
+    vec2 cx = df64_from_double(c.x);
+    vec2 cy = df64_from_double(c.y);
+    vec2 zx = vec2(0.0);
+    vec2 zy = vec2(0.0);
+    float magnitude = 0.0;
+    vec2 saved_x = zx;
+    vec2 saved_y = zy;
+    int next_save = 8;
+    
+    int i;
+    for (i = 0; i < u_max_iterations; i++)
+    {
+        zy = -zy;
+        vec2 xy = df64_mul(zx, zy);
+        zx = df64_add(df64_sub(df64_sqr(zx), df64_sqr(zy)), cx);
+        zy = df64_add(2.0 * xy, cy);
+
+        magnitude = zx.x * zx.x + zy.x * zy.x;
+        if (magnitude > 4.0)
+        {
+            break;
+        }
+        if ((i & 7) == 0)
+        {
+            if (abs(df64_sub(zx, saved_x).x) + abs(df64_sub(zy, saved_y).x) < PERIOD_EPSILON_DF64)
+            {
+                i = u_max_iterations;
+                break;
+            }
+            if (i >= next_save)
+            {
+                saved_x = zx;
+                saved_y = zy;
+                next_save *= 2;
+            }
+        }
+    }
+
+    if (i == u_max_iterations)
+    {
+        FragColor = vec4(0.0, 0.0, 0.0, 1.0);
+    }
+    else
+    {
+        float smooth_i = float(i) - log2(log2(magnitude));
+        float color_val = smooth_i * u_color_density;
+        vec3 color = palette(color_val);
+        FragColor = vec4(color, 1.0);
+    }
+}
@@ -0,0 +1,53 @@
+/*
+	Mesmer - An interactive and high-performance fractal generator and explorer.
+	Made by -> Titan // GH: https://github.com/titan3755/mesmer
+	[upscale.frag]
+*/
+
+#version 460 core
+out vec4 FragColor;
+in vec2 TexCoords;
+uniform sampler2D u_source;
+uniform vec2 u_source_size;    // texels the reduced level spans, it only fills the corner of its texture
+uniform ivec2 u_source_valid;  // texels holding finished pixels, taps never reach past them
+
+// catmull-rom weights of the four taps around a sample position
+vec4 catmullRom(float t)
+{
+    float t2 = t * t;
+    float t3 = t2 * t;
+    return vec4(-0.5 * t3 + t2 - 0.5 * t,
+                1.5 * t3 - 2.5 * t2 + 1.0,
+                -1.5 * t3 + 2.0 * t2 + 0.5 * t,
+                0.5 * t3 - 0.5 * t2);
+}
+
+void main()
+{
+    vec2 position = TexCoords * u_source_size - 0.5;
+    ivec2 base = ivec2(floor(position));
+    vec2 f = position - vec2(base);
+    vec4 weight_x = catmullRom(f.x);
+    vec4 weight_y = catmullRom(f.y);
+    ivec2 last = max(u_source_valid - 1, ivec2(0));
+
+    vec3 color = vec3(0.0);
+    vec3 low = vec3(1.0);
+    vec3 high = vec3(0.0);
+    for (int j = 0; j < 4; ++j) {
+        vec3 row = vec3(0.0);
+        for (int i = 0; i < 4; ++i) {
+            vec3 texel = texelFetch(u_source, clamp(base + ivec2(i - 1, j - 1), ivec2(0), last), 0).rgb;
+            row += texel * weight_x[i];
+            if (i == 1 || i == 2) {
+                if (j == 1 || j == 2) {
+                    low = min(low, texel);
+                    high = max(high, texel);
+                }
+            }
+        }
+        color += row * weight_y[j];
+    }
+    // the bicubic keeps filament edges sharp, clamping it to the nearest four texels removes the ringing around them
+    FragColor = vec4(clamp(color, low, high), 1.0);
+}